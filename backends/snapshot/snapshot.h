@@ -0,0 +1,80 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ *  ---
+ *
+ *  The binary design snapshot format shared by write_snapshot and
+ *  read_snapshot.
+ *
+ *  All integers are unsigned LEB128 varints, signed values (wire and memory
+ *  start offsets) are zigzag encoded first. Identifiers are stored once in
+ *  a string table at the start of the file and referred to by their index.
+ *
+ *    file     := magic version autoidx strings modules
+ *    strings  := count { length bytes '\0' }     index 0 is the empty id
+ *    modules  := count { module }
+ *    module   := name attrs params wires memories cells conns processes
+ *    params   := count { id } count { id const }  avail, then defaults
+ *    wire     := name width start_offset port_id flags attrs
+ *    memory   := name width start_offset size attrs
+ *    cell     := name type attrs count { id const } count { id sig }
+ *    conns    := count { sig sig }
+ *    process  := name attrs case count { sync }
+ *    case     := attrs count { sig } count { sig sig } count { switch }
+ *    switch   := attrs sig count { case }
+ *    sync     := type sig count { sig sig }
+ *    attrs    := count { id const }
+ *    const    := flags bits
+ *    bits     := width kind data
+ *    sig      := count { chunk }
+ *    chunk    := 0 bits | wire_index+1 offset width
+ *
+ *  Wires are referred to by the index in the order they are stored in the
+ *  module. Constants that only have 0 and 1 bits are packed 8 bits per
+ *  byte, others 2 bits per byte (one State per nibble). The string table
+ *  is NUL-terminated so that the reader can intern the identifiers
+ *  directly from the mapped file.
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "kernel/yosys.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+namespace SNAPSHOT
+{
+	static const char magic[8] = { 'Y', 'S', 'N', 'A', 'P', '\r', '\n', '\032' };
+	static const int version = 1;
+
+	enum ConstKind {
+		KIND_BITS = 0,
+		KIND_STATES = 1
+	};
+
+	enum WireFlags {
+		WIRE_INPUT  = 1,
+		WIRE_OUTPUT = 2,
+		WIRE_UPTO   = 4,
+		WIRE_SIGNED = 8
+	};
+}
+
+YOSYS_NAMESPACE_END
+
+#endif
@@ -0,0 +1,306 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/yosys.h"
+#include "backends/snapshot/snapshot.h"
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+using namespace SNAPSHOT;
+
+// The modules are encoded into `body` first, the string table is written
+// in front of it once all identifiers are known.
+struct SnapshotWriter
+{
+	std::string body;
+	dict<RTLIL::IdString, int> id_index;
+	std::vector<RTLIL::IdString> id_list;
+	dict<RTLIL::Wire*, int> wire_index;
+
+	SnapshotWriter()
+	{
+		id_index[RTLIL::IdString()] = 0;
+		id_list.push_back(RTLIL::IdString());
+	}
+
+	static void put_uint(std::string &buf, uint64_t value)
+	{
+		while (value >= 0x80) {
+			buf.push_back(char(value | 0x80));
+			value >>= 7;
+		}
+		buf.push_back(char(value));
+	}
+
+	void put_uint(uint64_t value)
+	{
+		put_uint(body, value);
+	}
+
+	void put_int(int value)
+	{
+		put_uint((uint32_t(value) << 1) ^ uint32_t(value >> 31));
+	}
+
+	void put_id(RTLIL::IdString id)
+	{
+		auto it = id_index.find(id);
+		if (it != id_index.end()) {
+			put_uint(it->second);
+			return;
+		}
+		int index = GetSize(id_list);
+		id_index[id] = index;
+		id_list.push_back(id);
+		put_uint(index);
+	}
+
+	void put_bits(const std::vector<RTLIL::State> &bits)
+	{
+		int width = GetSize(bits);
+		bool only_01 = true;
+		for (auto bit : bits)
+			if (bit != RTLIL::S0 && bit != RTLIL::S1) {
+				only_01 = false;
+				break;
+			}
+
+		put_uint(width);
+		body.push_back(only_01 ? KIND_BITS : KIND_STATES);
+
+		if (only_01) {
+			for (int i = 0; i < width; i += 8) {
+				unsigned char byte = 0;
+				for (int k = 0; k < 8 && i+k < width; k++)
+					byte |= (bits[i+k] == RTLIL::S1) << k;
+				body.push_back(char(byte));
+			}
+		} else {
+			for (int i = 0; i < width; i += 2) {
+				unsigned char byte = bits[i];
+				if (i+1 < width)
+					byte |= bits[i+1] << 4;
+				body.push_back(char(byte));
+			}
+		}
+	}
+
+	void put_const(const RTLIL::Const &value)
+	{
+		put_uint(value.flags);
+		put_bits(value.bits);
+	}
+
+	void put_sig(const RTLIL::SigSpec &sig)
+	{
+		const std::vector<RTLIL::SigChunk> &chunks = sig.chunks();
+		put_uint(chunks.size());
+		for (auto &chunk : chunks) {
+			if (chunk.wire == nullptr) {
+				put_uint(0);
+				put_bits(chunk.data);
+				continue;
+			}
+			put_uint(wire_index.at(chunk.wire) + 1);
+			put_uint(chunk.offset);
+			put_uint(chunk.width);
+		}
+	}
+
+	void put_sigsigs(const std::vector<RTLIL::SigSig> &actions)
+	{
+		put_uint(actions.size());
+		for (auto &it : actions) {
+			put_sig(it.first);
+			put_sig(it.second);
+		}
+	}
+
+	void put_attrs(const RTLIL::AttrObject *obj)
+	{
+		put_uint(obj->attributes.size());
+		for (auto &it : obj->attributes) {
+			put_id(it.first);
+			put_const(it.second);
+		}
+	}
+
+	void put_case(const RTLIL::CaseRule *cs)
+	{
+		put_attrs(cs);
+		put_uint(cs->compare.size());
+		for (auto &sig : cs->compare)
+			put_sig(sig);
+		put_sigsigs(cs->actions);
+		put_uint(cs->switches.size());
+		for (auto sw : cs->switches) {
+			put_attrs(sw);
+			put_sig(sw->signal);
+			put_uint(sw->cases.size());
+			for (auto sub : sw->cases)
+				put_case(sub);
+		}
+	}
+
+	void put_module(RTLIL::Module *module)
+	{
+		put_id(module->name);
+		put_attrs(module);
+
+		put_uint(module->avail_parameters.size());
+		for (auto &id : module->avail_parameters)
+			put_id(id);
+		put_uint(module->parameter_default_values.size());
+		for (auto &it : module->parameter_default_values) {
+			put_id(it.first);
+			put_const(it.second);
+		}
+
+		wire_index.clear();
+		put_uint(module->wires_.size());
+		for (auto wire : module->wires()) {
+			int index = GetSize(wire_index);
+			wire_index[wire] = index;
+			put_id(wire->name);
+			put_uint(wire->width);
+			put_int(wire->start_offset);
+			put_uint(wire->port_id);
+			put_uint((wire->port_input ? WIRE_INPUT : 0) | (wire->port_output ? WIRE_OUTPUT : 0) |
+					(wire->upto ? WIRE_UPTO : 0) | (wire->is_signed ? WIRE_SIGNED : 0));
+			put_attrs(wire);
+		}
+
+		put_uint(module->memories.size());
+		for (auto &it : module->memories) {
+			RTLIL::Memory *memory = it.second;
+			put_id(memory->name);
+			put_uint(memory->width);
+			put_int(memory->start_offset);
+			put_uint(memory->size);
+			put_attrs(memory);
+		}
+
+		put_uint(module->cells_.size());
+		for (auto cell : module->cells()) {
+			put_id(cell->name);
+			put_id(cell->type);
+			put_attrs(cell);
+			put_uint(cell->parameters.size());
+			for (auto &it : cell->parameters) {
+				put_id(it.first);
+				put_const(it.second);
+			}
+			put_uint(cell->connections().size());
+			for (auto &it : cell->connections()) {
+				put_id(it.first);
+				put_sig(it.second);
+			}
+		}
+
+		put_sigsigs(module->connections());
+
+		put_uint(module->processes.size());
+		for (auto &it : module->processes) {
+			RTLIL::Process *proc = it.second;
+			put_id(proc->name);
+			put_attrs(proc);
+			put_case(&proc->root_case);
+			put_uint(proc->syncs.size());
+			for (auto sync : proc->syncs) {
+				body.push_back(char(sync->type));
+				put_sig(sync->signal);
+				put_sigsigs(sync->actions);
+			}
+		}
+	}
+
+	// Returns the size of the file.
+	size_t write(std::ostream &f, const std::vector<RTLIL::Module*> &modules)
+	{
+		for (auto module : modules)
+			put_module(module);
+
+		std::string header(magic, sizeof(magic));
+		put_uint(header, version);
+		put_uint(header, autoidx);
+		put_uint(header, id_list.size());
+		for (auto id : id_list) {
+			put_uint(header, id.size());
+			header.append(id.c_str(), id.size() + 1);
+		}
+		put_uint(header, modules.size());
+
+		f.write(header.data(), header.size());
+		f.write(body.data(), body.size());
+		return header.size() + body.size();
+	}
+};
+
+struct SnapshotBackend : public Backend {
+	SnapshotBackend() : Backend("snapshot", "write design to a binary snapshot file") { }
+	void help() override
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    write_snapshot [options] [filename]\n");
+		log("\n");
+		log("Write the current design to a binary snapshot file, which can be loaded with\n");
+		log("'read_snapshot'. The snapshot contains the same information as an RTLIL file,\n");
+		log("but is several times smaller and much faster to read. Identifiers are only\n");
+		log("stored once and the modules, wires and cells are kept in their current order.\n");
+		log("\n");
+		log("The format is specific to this version of Yosys and not meant for exchanging\n");
+		log("designs with other tools. Use 'write_rtlil' or 'write_json' for that.\n");
+		log("\n");
+		log("    -selected\n");
+		log("        only write the selected modules. Modules that are only partially\n");
+		log("        selected are skipped with a warning.\n");
+		log("\n");
+	}
+	void execute(std::ostream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design) override
+	{
+		bool selected = false;
+
+		log_header(design, "Executing SNAPSHOT backend.\n");
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++) {
+			std::string arg = args[argidx];
+			if (arg == "-selected") {
+				selected = true;
+				continue;
+			}
+			break;
+		}
+		extra_args(f, filename, args, argidx, true);
+
+		std::vector<RTLIL::Module*> modules = selected ? design->selected_whole_modules_warn() : design->modules();
+
+		log("Output filename: %s\n", filename.c_str());
+
+		SnapshotWriter writer;
+		size_t bytes = writer.write(*f, modules);
+
+		log("Wrote %d modules and %d identifiers (%zu bytes).\n", GetSize(modules),
+				GetSize(writer.id_list), bytes);
+	}
+} SnapshotBackend;
+
+PRIVATE_NAMESPACE_END
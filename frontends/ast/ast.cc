@@ -38,9 +38,10 @@ using namespace AST_INTERNAL;
 
 // instantiate global variables (public API)
 namespace AST {
-	std::string current_filename;
+	YS_THREAD_LOCAL std::string current_filename;
 	void (*set_line_num)(int) = NULL;
 	int (*get_line_num)() = NULL;
+	YS_THREAD_LOCAL unsigned int hashidx_count = hashidx_seed;
 }
 
 // instantiate global variables (private API)
@@ -198,7 +199,6 @@ bool AstNode::get_bool_attribute(RTLIL::IdString id)
 // (the optional child arguments make it easier to create AST trees)
 AstNode::AstNode(AstNodeType type, AstNode *child1, AstNode *child2, AstNode *child3)
 {
-	static unsigned int hashidx_count = 123456789;
 	hashidx_count = mkhash_xorshift(hashidx_count);
 	hashidx_ = hashidx_count;
 
@@ -336,10 +336,17 @@ namespace AST
 	// this must be set by the language frontend before parsing the sources
 	// the AstNode constructor then uses current_filename and get_line_num()
 	// to initialize the filename and linenum properties of new nodes
-	extern std::string current_filename;
+	// (current_filename is per thread, a frontend may parse several files at once)
+	extern YS_THREAD_LOCAL std::string current_filename;
 	extern void (*set_line_num)(int);
 	extern int (*get_line_num)();
 
+	// the hash values of new nodes are taken from this sequence, a frontend that
+	// creates nodes on several threads resets it for each file so that the hash
+	// values do not depend on the scheduling of the threads
+	extern YS_THREAD_LOCAL unsigned int hashidx_count;
+	static const unsigned int hashidx_seed = 123456789;
+
 	// set set_line_num and get_line_num to internal dummy functions (done by simplify() and AstModule::derive
 	// to control the filename and linenum properties of new nodes not generated by a frontend parser)
 	void use_internal_line_num();
@@ -0,0 +1,523 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/yosys.h"
+#include "backends/snapshot/snapshot.h"
+
+#if defined(_WIN32) || defined(__wasm)
+#  define SNAPSHOT_NO_MMAP
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+using namespace SNAPSHOT;
+
+// The contents of the file, either memory-mapped or read into a buffer.
+struct SnapshotData
+{
+	std::vector<char> buffer;
+	const char *data = nullptr;
+	size_t size = 0;
+#ifndef SNAPSHOT_NO_MMAP
+	void *mapped = nullptr;
+#endif
+
+	SnapshotData() { }
+	SnapshotData(const SnapshotData &) = delete;
+	SnapshotData &operator=(const SnapshotData &) = delete;
+
+	~SnapshotData()
+	{
+#ifndef SNAPSHOT_NO_MMAP
+		if (mapped != nullptr)
+			munmap(mapped, size);
+#endif
+	}
+
+	// Maps the file if it is a regular, uncompressed snapshot file.
+	bool map(const std::string &filename)
+	{
+#ifndef SNAPSHOT_NO_MMAP
+		int fd = open(filename.c_str(), O_RDONLY);
+		if (fd < 0)
+			return false;
+
+		struct stat st;
+		if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size >= (off_t)sizeof(magic)) {
+			void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (p != MAP_FAILED) {
+				if (memcmp(p, magic, sizeof(magic)) == 0) {
+					madvise(p, st.st_size, MADV_SEQUENTIAL);
+					mapped = p;
+					data = (const char*)p;
+					size = st.st_size;
+				} else {
+					munmap(p, st.st_size);
+				}
+			}
+		}
+		close(fd);
+		return mapped != nullptr;
+#else
+		return false;
+#endif
+	}
+
+	void read(std::istream *f)
+	{
+		char block[65536];
+		while (f->read(block, sizeof(block)) || f->gcount() > 0)
+			buffer.insert(buffer.end(), block, block + f->gcount());
+		data = buffer.data();
+		size = buffer.size();
+	}
+};
+
+struct SnapshotReader
+{
+	std::string filename;
+	const unsigned char *pos, *end;
+	RTLIL::Design *design;
+	bool flag_overwrite = false, flag_nooverwrite = false, flag_lib = false;
+
+	std::vector<RTLIL::IdString> ids;
+	std::vector<RTLIL::Wire*> wires;
+	int module_count = 0, wire_count = 0, cell_count = 0;
+
+	[[noreturn]] void corrupt()
+	{
+		log_error("Snapshot file `%s' is truncated or corrupt.\n", filename.c_str());
+	}
+
+	uint64_t get_uint()
+	{
+		uint64_t value = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			if (pos == end)
+				corrupt();
+			unsigned char byte = *pos++;
+			value |= uint64_t(byte & 0x7f) << shift;
+			if ((byte & 0x80) == 0)
+				return value;
+		}
+		corrupt();
+	}
+
+	int get_int()
+	{
+		uint64_t value = get_uint();
+		if (value > uint64_t(std::numeric_limits<int>::max()))
+			corrupt();
+		return value;
+	}
+
+	int get_sint()
+	{
+		uint64_t value = get_uint();
+		if (value > std::numeric_limits<uint32_t>::max())
+			corrupt();
+		return int(uint32_t(value >> 1) ^ -uint32_t(value & 1));
+	}
+
+	// A number of elements that follow, each is at least one byte.
+	int get_count()
+	{
+		int count = get_int();
+		if (count > end - pos)
+			corrupt();
+		return count;
+	}
+
+	unsigned char get_byte()
+	{
+		if (pos == end)
+			corrupt();
+		return *pos++;
+	}
+
+	RTLIL::IdString get_id()
+	{
+		uint64_t index = get_uint();
+		if (index >= ids.size())
+			corrupt();
+		return ids[index];
+	}
+
+	void get_bits(std::vector<RTLIL::State> &bits)
+	{
+		int width = get_int();
+		unsigned char kind = get_byte();
+		size_t bytes = kind == KIND_BITS ? (size_t(width) + 7) / 8 : (size_t(width) + 1) / 2;
+		if (kind > KIND_STATES || bytes > size_t(end - pos))
+			corrupt();
+
+		bits.resize(width);
+		if (kind == KIND_BITS) {
+			for (int i = 0; i < width; i++)
+				bits[i] = RTLIL::State((pos[i >> 3] >> (i & 7)) & 1);
+		} else {
+			for (int i = 0; i < width; i++) {
+				unsigned char state = (pos[i >> 1] >> (4 * (i & 1))) & 15;
+				if (state > RTLIL::Sm)
+					corrupt();
+				bits[i] = RTLIL::State(state);
+			}
+		}
+		pos += bytes;
+	}
+
+	RTLIL::Const get_const()
+	{
+		RTLIL::Const value;
+		value.flags = get_int();
+		get_bits(value.bits);
+		return value;
+	}
+
+	RTLIL::SigSpec get_sig()
+	{
+		int count = get_count();
+		if (count == 0)
+			return RTLIL::SigSpec();
+
+		std::vector<RTLIL::SigChunk> chunks(count);
+		for (auto &chunk : chunks) {
+			uint64_t index = get_uint();
+			if (index == 0) {
+				get_bits(chunk.data);
+				chunk.width = GetSize(chunk.data);
+				continue;
+			}
+			if (index > wires.size())
+				corrupt();
+			chunk.wire = wires[index - 1];
+			chunk.offset = get_int();
+			chunk.width = get_int();
+			if (chunk.width > chunk.wire->width - chunk.offset)
+				corrupt();
+		}
+		if (count == 1)
+			return RTLIL::SigSpec(chunks.front());
+		return RTLIL::SigSpec(chunks);
+	}
+
+	void get_sigsigs(std::vector<RTLIL::SigSig> &actions)
+	{
+		int count = get_count();
+		actions.reserve(count);
+		for (int i = 0; i < count; i++) {
+			RTLIL::SigSpec lhs = get_sig();
+			actions.push_back(RTLIL::SigSig(lhs, get_sig()));
+		}
+	}
+
+	void get_attrs(RTLIL::AttrObject *obj)
+	{
+		int count = get_count();
+		for (int i = 0; i < count; i++) {
+			RTLIL::IdString id = get_id();
+			obj->attributes[id] = get_const();
+		}
+	}
+
+	void get_case(RTLIL::CaseRule *cs)
+	{
+		get_attrs(cs);
+		int count = get_count();
+		cs->compare.reserve(count);
+		for (int i = 0; i < count; i++)
+			cs->compare.push_back(get_sig());
+		get_sigsigs(cs->actions);
+		count = get_count();
+		for (int i = 0; i < count; i++) {
+			RTLIL::SwitchRule *sw = new RTLIL::SwitchRule;
+			cs->switches.push_back(sw);
+			get_attrs(sw);
+			sw->signal = get_sig();
+			int case_count = get_count();
+			for (int j = 0; j < case_count; j++) {
+				RTLIL::CaseRule *sub = new RTLIL::CaseRule;
+				sw->cases.push_back(sub);
+				get_case(sub);
+			}
+		}
+	}
+
+	// Mirrors the handling of re-defined modules in read_rtlil.
+	bool keep_module(RTLIL::Module *module)
+	{
+		RTLIL::Module *existing_mod = design->module(module->name);
+		if (existing_mod == nullptr)
+			return true;
+
+		if (!flag_overwrite && (flag_lib || module->get_bool_attribute(ID::blackbox))) {
+			log("Ignoring blackbox re-definition of module %s.\n", log_id(module));
+			return false;
+		}
+		if (!flag_nooverwrite && !flag_overwrite && !existing_mod->get_bool_attribute(ID::blackbox))
+			log_error("Snapshot file `%s' redefines module %s.\n", filename.c_str(), log_id(module));
+		if (flag_nooverwrite) {
+			log("Ignoring re-definition of module %s.\n", log_id(module));
+			return false;
+		}
+		log("Replacing existing%s module %s.\n", existing_mod->get_bool_attribute(ID::blackbox) ? " blackbox" : "", log_id(module));
+		design->remove(existing_mod);
+		return true;
+	}
+
+	void get_module()
+	{
+		RTLIL::Module *module = new RTLIL::Module;
+		module->name = get_id();
+		if (module->name.empty())
+			corrupt();
+		get_attrs(module);
+
+		int count = get_count();
+		for (int i = 0; i < count; i++)
+			module->avail_parameters(get_id());
+		count = get_count();
+		for (int i = 0; i < count; i++) {
+			RTLIL::IdString id = get_id();
+			module->parameter_default_values[id] = get_const();
+		}
+
+		count = get_count();
+		wires.clear();
+		wires.reserve(count);
+		module->wires_.reserve(count);
+		for (int i = 0; i < count; i++) {
+			RTLIL::IdString name = get_id();
+			if (name.empty() || module->wire(name) != nullptr)
+				corrupt();
+			RTLIL::Wire *wire = module->addWire(name, get_int());
+			wire->start_offset = get_sint();
+			wire->port_id = get_int();
+			int flags = get_int();
+			wire->port_input = (flags & WIRE_INPUT) != 0;
+			wire->port_output = (flags & WIRE_OUTPUT) != 0;
+			wire->upto = (flags & WIRE_UPTO) != 0;
+			wire->is_signed = (flags & WIRE_SIGNED) != 0;
+			get_attrs(wire);
+			wires.push_back(wire);
+		}
+
+		count = get_count();
+		for (int i = 0; i < count; i++) {
+			RTLIL::Memory *memory = new RTLIL::Memory;
+			memory->name = get_id();
+			if (module->memories.count(memory->name))
+				corrupt();
+			module->memories[memory->name] = memory;
+			memory->width = get_int();
+			memory->start_offset = get_sint();
+			memory->size = get_int();
+			get_attrs(memory);
+		}
+
+		count = get_count();
+		module->cells_.reserve(count);
+		for (int i = 0; i < count; i++) {
+			RTLIL::IdString name = get_id();
+			if (name.empty() || module->cell(name) != nullptr)
+				corrupt();
+			RTLIL::Cell *cell = module->addCell(name, get_id());
+			get_attrs(cell);
+			int param_count = get_count();
+			cell->parameters.reserve(param_count);
+			for (int j = 0; j < param_count; j++) {
+				RTLIL::IdString id = get_id();
+				cell->parameters[id] = get_const();
+			}
+			int conn_count = get_count();
+			cell->connections_.reserve(conn_count);
+			for (int j = 0; j < conn_count; j++) {
+				RTLIL::IdString port = get_id();
+				cell->setPort(port, get_sig());
+			}
+		}
+
+		std::vector<RTLIL::SigSig> connections;
+		get_sigsigs(connections);
+		module->new_connections(connections);
+
+		count = get_count();
+		for (int i = 0; i < count; i++) {
+			RTLIL::Process *proc = new RTLIL::Process;
+			proc->name = get_id();
+			if (module->processes.count(proc->name))
+				corrupt();
+			module->processes[proc->name] = proc;
+			get_attrs(proc);
+			get_case(&proc->root_case);
+			int sync_count = get_count();
+			for (int j = 0; j < sync_count; j++) {
+				RTLIL::SyncRule *sync = new RTLIL::SyncRule;
+				proc->syncs.push_back(sync);
+				unsigned char type = get_byte();
+				if (type > RTLIL::STi)
+					corrupt();
+				sync->type = RTLIL::SyncType(type);
+				sync->signal = get_sig();
+				get_sigsigs(sync->actions);
+			}
+		}
+
+		module->fixup_ports();
+
+		if (!keep_module(module)) {
+			delete module;
+			return;
+		}
+
+		design->add(module);
+		if (flag_lib)
+			module->makeblackbox();
+
+		module_count++;
+		wire_count += GetSize(module->wires_);
+		cell_count += GetSize(module->cells_);
+	}
+
+	void run(const char *data, size_t size)
+	{
+		pos = (const unsigned char*)data;
+		end = pos + size;
+
+		if (size < sizeof(magic) || memcmp(data, magic, sizeof(magic)) != 0)
+			log_error("File `%s' is not a Yosys snapshot file.\n", filename.c_str());
+		pos += sizeof(magic);
+
+		int file_version = get_int();
+		if (file_version != version)
+			log_error("Snapshot file `%s' has unsupported version %d (expected %d).\n",
+					filename.c_str(), file_version, version);
+
+		autoidx = max(autoidx, get_int());
+
+		int count = get_count();
+		ids.reserve(count);
+		for (int i = 0; i < count; i++) {
+			int length = get_int();
+			if (length >= end - pos || pos[length] != 0)
+				corrupt();
+			const char *str = (const char*)pos;
+			pos += length + 1;
+			if (i == 0) {
+				if (length != 0)
+					corrupt();
+				ids.push_back(RTLIL::IdString());
+				continue;
+			}
+			if ((str[0] != '\\' && str[0] != '$') || int(strlen(str)) != length)
+				corrupt();
+			ids.push_back(RTLIL::IdString(str));
+		}
+
+		count = get_count();
+		for (int i = 0; i < count; i++)
+			get_module();
+
+		if (pos != end)
+			corrupt();
+	}
+};
+
+struct SnapshotFrontend : public Frontend {
+	SnapshotFrontend() : Frontend("snapshot", "read design from a binary snapshot file") { }
+	void help() override
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    read_snapshot [options] [filename]\n");
+		log("\n");
+		log("Load modules from a binary snapshot file written by 'write_snapshot' into the\n");
+		log("current design. Uncompressed files are memory-mapped where the host supports\n");
+		log("it, so that the data is only read once from the page cache.\n");
+		log("\n");
+		log("    -nooverwrite\n");
+		log("        ignore re-definitions of modules. (the default behavior is to\n");
+		log("        create an error message if the existing module is not a blackbox\n");
+		log("        module, and overwrite the existing module if it is a blackbox module.)\n");
+		log("\n");
+		log("    -overwrite\n");
+		log("        overwrite existing modules with the same name\n");
+		log("\n");
+		log("    -lib\n");
+		log("        only create empty blackbox modules\n");
+		log("\n");
+		log("    -nommap\n");
+		log("        read the file into memory instead of mapping it\n");
+		log("\n");
+	}
+	void execute(std::istream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design) override
+	{
+		SnapshotReader reader;
+		bool nommap = false;
+
+		log_header(design, "Executing SNAPSHOT frontend.\n");
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++) {
+			std::string arg = args[argidx];
+			if (arg == "-nooverwrite") {
+				reader.flag_nooverwrite = true;
+				reader.flag_overwrite = false;
+				continue;
+			}
+			if (arg == "-overwrite") {
+				reader.flag_nooverwrite = false;
+				reader.flag_overwrite = true;
+				continue;
+			}
+			if (arg == "-lib") {
+				reader.flag_lib = true;
+				continue;
+			}
+			if (arg == "-nommap") {
+				nommap = true;
+				continue;
+			}
+			break;
+		}
+		extra_args(f, filename, args, argidx, true);
+
+		log("Input filename: %s\n", filename.c_str());
+
+		// Compressed files and pipes are read through the stream
+		SnapshotData data;
+		if (nommap || filename == "<stdin>" || !data.map(filename))
+			data.read(f);
+
+		reader.filename = filename;
+		reader.design = design;
+		reader.run(data.data, data.size);
+
+		log("Read %d modules with %d wires and %d cells.\n", reader.module_count,
+				reader.wire_count, reader.cell_count);
+	}
+} SnapshotFrontend;
+
+PRIVATE_NAMESPACE_END
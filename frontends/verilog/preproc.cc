@@ -43,9 +43,9 @@
 YOSYS_NAMESPACE_BEGIN
 using namespace VERILOG_FRONTEND;
 
-static std::list<std::string> output_code;
-static std::list<std::string> input_buffer;
-static size_t input_buffer_charp;
+static YS_THREAD_LOCAL std::list<std::string> output_code;
+static YS_THREAD_LOCAL std::list<std::string> input_buffer;
+static YS_THREAD_LOCAL size_t input_buffer_charp;
 
 static void return_char(char ch)
 {
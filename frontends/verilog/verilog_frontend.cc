@@ -29,6 +29,7 @@
 #include "verilog_frontend.h"
 #include "preproc.h"
 #include "kernel/yosys.h"
+#include "kernel/threading.h"
 #include "libs/sha1/sha1.h"
 #include <stdarg.h>
 
@@ -65,6 +66,45 @@ static void add_package_types(dict<std::string, AST::AstNode *> &user_types, std
 	user_type_stack.push_back(new UserTypeMap());
 }
 
+// preprocess and parse one file into a new AST_DESIGN node, this is called
+// on several threads at once by read_verilog -threads
+static AST::AstNode *parse_file(std::istream &f, const std::string &filename, RTLIL::Design *design,
+		const define_map_t &pre_defines, define_map_t &global_defines, const std::list<std::string> &include_dirs,
+		bool flag_nopp, bool flag_ppdump)
+{
+	log("Parsing %s%s input from `%s' to AST representation.\n",
+			formal_mode ? "formal " : "", sv_mode ? "SystemVerilog" : "Verilog", filename.c_str());
+
+	AST::current_filename = filename;
+	current_ast = new AST::AstNode(AST::AST_DESIGN);
+
+	lexin = &f;
+	std::string code_after_preproc;
+
+	if (!flag_nopp) {
+		code_after_preproc = frontend_verilog_preproc(f, filename, pre_defines, global_defines, include_dirs);
+		if (flag_ppdump)
+			log("-- Verilog code after preprocessor --\n%s-- END OF DUMP --\n", code_after_preproc.c_str());
+		lexin = new std::istringstream(code_after_preproc);
+	}
+
+	// make package typedefs available to parser
+	add_package_types(pkg_user_types, design->verilog_packages);
+
+	frontend_verilog_yyrestart(NULL);
+	frontend_verilog_yyset_lineno(1);
+	frontend_verilog_yyparse();
+	frontend_verilog_yylex_destroy();
+
+	if (!flag_nopp)
+		delete lexin;
+	lexin = nullptr;
+
+	AST::AstNode *ast = current_ast;
+	current_ast = nullptr;
+	return ast;
+}
+
 struct VerilogFrontend : public Frontend {
 	VerilogFrontend() : Frontend("verilog", "read modules from Verilog file") { }
 	void help() override
@@ -216,6 +256,14 @@ struct VerilogFrontend : public Frontend {
 		log("        add 'dir' to the directories which are used when searching include\n");
 		log("        files\n");
 		log("\n");
+		log("    -threads <N>\n");
+		log("        preprocess and parse the files on up to N threads, then convert\n");
+		log("        them to RTLIL one after another in the order of the files. The\n");
+		log("        result does not depend on N. Each file starts with the `define's\n");
+		log("        that existed before this command, the `define's of a file only\n");
+		log("        become visible to the files read by later commands. Likewise,\n");
+		log("        types from packages can only be used by files read later.\n");
+		log("\n");
 		log("The command 'verilog_defaults' can be used to register default options for\n");
 		log("subsequent calls to 'read_verilog'.\n");
 		log("\n");
@@ -255,6 +303,7 @@ struct VerilogFrontend : public Frontend {
 		bool flag_defer = false;
 		bool flag_noblackbox = false;
 		bool flag_nowb = false;
+		int threads = 0;
 		define_map_t defines_map;
 
 		std::list<std::string> include_dirs;
@@ -444,58 +493,87 @@ struct VerilogFrontend : public Frontend {
 				include_dirs.push_back(arg.substr(2));
 				continue;
 			}
+			if (arg == "-threads" && argidx+1 < args.size()) {
+				threads = std::max(atoi(args[++argidx].c_str()), 1);
+				continue;
+			}
 			break;
 		}
 		extra_args(f, filename, args, argidx);
 
-		log_header(design, "Executing Verilog-2005 frontend: %s\n", filename.c_str());
-
-		log("Parsing %s%s input from `%s' to AST representation.\n",
-				formal_mode ? "formal " : "", sv_mode ? "SystemVerilog" : "Verilog", filename.c_str());
-
-		AST::current_filename = filename;
 		AST::set_line_num = &frontend_verilog_yyset_lineno;
 		AST::get_line_num = &frontend_verilog_yyget_lineno;
 
-		current_ast = new AST::AstNode(AST::AST_DESIGN);
-
-		lexin = f;
-		std::string code_after_preproc;
-
-		if (!flag_nopp) {
-			code_after_preproc = frontend_verilog_preproc(*f, filename, defines_map, *design->verilog_defines, include_dirs);
-			if (flag_ppdump)
-				log("-- Verilog code after preprocessor --\n%s-- END OF DUMP --\n", code_after_preproc.c_str());
-			lexin = new std::istringstream(code_after_preproc);
+		std::vector<std::string> filenames = {filename};
+		std::vector<std::istream*> files = {f};
+		if (threads > 0) {
+			// open the remaining files now instead of having Frontend::execute()
+			// call us again for each of them
+			while (!next_args.empty()) {
+				std::vector<std::string> file_args = next_args;
+				std::istream *ff = nullptr;
+				std::string ff_name;
+				extra_args(ff, ff_name, file_args, argidx);
+				filenames.push_back(ff_name);
+				files.push_back(ff);
+			}
+			log_header(design, "Executing Verilog-2005 frontend: %d file%s\n", GetSize(filenames),
+					GetSize(filenames) == 1 ? "" : "s");
+		} else {
+			log_header(design, "Executing Verilog-2005 frontend: %s\n", filename.c_str());
 		}
 
-		// make package typedefs available to parser
-		add_package_types(pkg_user_types, design->verilog_packages);
-
-		frontend_verilog_yyset_lineno(1);
-		frontend_verilog_yyrestart(NULL);
-		frontend_verilog_yyparse();
-		frontend_verilog_yylex_destroy();
-
-		for (auto &child : current_ast->children) {
-			if (child->type == AST::AST_MODULE)
-				for (auto &attr : attributes)
-					if (child->attributes.count(attr) == 0)
-						child->attributes[attr] = AST::AstNode::mkconst_int(1, false);
+		std::vector<AST::AstNode*> asts(GetSize(filenames));
+		std::vector<char> nettype_wire(GetSize(filenames), default_nettype_wire);
+		std::vector<define_map_t> file_defines(GetSize(filenames));
+
+		if (threads > 0) {
+			// each file starts with the same defines and `default_nettype and
+			// collects its own `define's, which are added to the global defines
+			// in the order of the files once all of them are parsed
+			define_map_t pre_defines;
+			pre_defines.merge(defines_map);
+			pre_defines.merge(*design->verilog_defines);
+			bool initial_nettype_wire = default_nettype_wire;
+
+			parallel_for(GetSize(filenames), threads, [&](int i) {
+				AST::hashidx_count = AST::hashidx_seed;
+				enum_count = 0;
+				default_nettype_wire = initial_nettype_wire;
+				file_defines[i].clear();
+				asts[i] = parse_file(*files[i], filenames[i], design, pre_defines, file_defines[i], include_dirs, flag_nopp, flag_ppdump);
+				nettype_wire[i] = default_nettype_wire;
+			});
+		} else {
+			asts[0] = parse_file(*f, filename, design, defines_map, *design->verilog_defines, include_dirs, flag_nopp, flag_ppdump);
+			nettype_wire[0] = default_nettype_wire;
 		}
 
-		if (flag_nodpi)
-			error_on_dpi_function(current_ast);
+		for (int i = 0; i < GetSize(filenames); i++)
+		{
+			AST::AstNode *ast = asts[i];
+
+			for (auto &child : ast->children) {
+				if (child->type == AST::AST_MODULE)
+					for (auto &attr : attributes)
+						if (child->attributes.count(attr) == 0)
+							child->attributes[attr] = AST::AstNode::mkconst_int(1, false);
+			}
 
-		AST::process(design, current_ast, flag_dump_ast1, flag_dump_ast2, flag_no_dump_ptr, flag_dump_vlog1, flag_dump_vlog2, flag_dump_rtlil, flag_nolatches,
-				flag_nomeminit, flag_nomem2reg, flag_mem2reg, flag_noblackbox, lib_mode, flag_nowb, flag_noopt, flag_icells, flag_pwires, flag_nooverwrite, flag_overwrite, flag_defer, default_nettype_wire);
+			if (flag_nodpi)
+				error_on_dpi_function(ast);
 
+			AST::process(design, ast, flag_dump_ast1, flag_dump_ast2, flag_no_dump_ptr, flag_dump_vlog1, flag_dump_vlog2, flag_dump_rtlil, flag_nolatches,
+					flag_nomeminit, flag_nomem2reg, flag_mem2reg, flag_noblackbox, lib_mode, flag_nowb, flag_noopt, flag_icells, flag_pwires, flag_nooverwrite, flag_overwrite, flag_defer, nettype_wire[i]);
 
-		if (!flag_nopp)
-			delete lexin;
+			delete ast;
 
-		delete current_ast;
-		current_ast = NULL;
+			if (threads > 0) {
+				design->verilog_defines->merge(file_defines[i]);
+				if (i > 0)
+					delete files[i];
+			}
+		}
 
 		log("Successfully finished Verilog frontend.\n");
 	}
@@ -39,21 +39,29 @@ YOSYS_NAMESPACE_BEGIN
 
 namespace VERILOG_FRONTEND
 {
+	// The state of the preprocessor, lexer and parser is kept per thread, so
+	// that read_verilog -threads can parse several files at the same time. The
+	// options below (sv_mode, formal_mode, ..) are shared and must only be
+	// changed while no file is parsed.
+
 	// this variable is set to a new AST_DESIGN node and then filled with the AST by the bison parser
-	extern struct AST::AstNode *current_ast;
+	extern YS_THREAD_LOCAL struct AST::AstNode *current_ast;
 
 	// this function converts a Verilog constant to an AST_CONSTANT node
 	AST::AstNode *const2ast(std::string code, char case_type = 0, bool warn_z = false);
 
 	// names of locally typedef'ed types in a stack
 	typedef std::map<std::string, AST::AstNode*> UserTypeMap;
-	extern std::vector<UserTypeMap *> user_type_stack;
+	extern YS_THREAD_LOCAL std::vector<UserTypeMap *> user_type_stack;
 
 	// names of package typedef'ed types
-	extern dict<std::string, AST::AstNode*> pkg_user_types;
+	extern YS_THREAD_LOCAL dict<std::string, AST::AstNode*> pkg_user_types;
+
+	// number of the next anonymous enum type
+	extern YS_THREAD_LOCAL int enum_count;
 
 	// state of `default_nettype
-	extern bool default_nettype_wire;
+	extern YS_THREAD_LOCAL bool default_nettype_wire;
 
 	// running in SystemVerilog mode
 	extern bool sv_mode;
@@ -83,12 +91,14 @@ namespace VERILOG_FRONTEND
 	extern bool specify_mode;
 
 	// lexer input stream
-	extern std::istream *lexin;
+	extern YS_THREAD_LOCAL std::istream *lexin;
 }
 
 YOSYS_NAMESPACE_END
 
-// the usual bison/flex stuff
+// the usual bison/flex stuff, the lexer is reentrant and these functions
+// operate on the scanner of the calling thread, which is created by
+// frontend_verilog_yyrestart() and freed by frontend_verilog_yylex_destroy()
 extern int frontend_verilog_yydebug;
 void frontend_verilog_yyerror(char const *fmt, ...);
 void frontend_verilog_yyrestart(FILE *f);
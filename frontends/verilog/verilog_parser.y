@@ -49,27 +49,28 @@ using namespace VERILOG_FRONTEND;
 
 YOSYS_NAMESPACE_BEGIN
 namespace VERILOG_FRONTEND {
-	int port_counter;
-	dict<std::string, int> port_stubs;
-	dict<IdString, AstNode*> *attr_list, default_attr_list;
-	std::stack<dict<IdString, AstNode*> *> attr_list_stack;
-	dict<IdString, AstNode*> *albuf;
-	std::vector<UserTypeMap*> user_type_stack;
-	dict<std::string, AstNode*> pkg_user_types;
-	std::vector<AstNode*> ast_stack;
-	struct AstNode *astbuf1, *astbuf2, *astbuf3;
-	struct AstNode *current_function_or_task;
-	struct AstNode *current_ast, *current_ast_mod;
-	int current_function_or_task_port_id;
-	std::vector<char> case_type_stack;
-	bool do_not_require_port_stubs;
-	bool default_nettype_wire;
+	YS_THREAD_LOCAL int port_counter;
+	YS_THREAD_LOCAL dict<std::string, int> port_stubs;
+	YS_THREAD_LOCAL dict<IdString, AstNode*> *attr_list, default_attr_list;
+	YS_THREAD_LOCAL std::stack<dict<IdString, AstNode*> *> attr_list_stack;
+	YS_THREAD_LOCAL dict<IdString, AstNode*> *albuf;
+	YS_THREAD_LOCAL std::vector<UserTypeMap*> user_type_stack;
+	YS_THREAD_LOCAL dict<std::string, AstNode*> pkg_user_types;
+	YS_THREAD_LOCAL std::vector<AstNode*> ast_stack;
+	YS_THREAD_LOCAL struct AstNode *astbuf1, *astbuf2, *astbuf3;
+	YS_THREAD_LOCAL struct AstNode *current_function_or_task;
+	YS_THREAD_LOCAL struct AstNode *current_ast, *current_ast_mod;
+	YS_THREAD_LOCAL int current_function_or_task_port_id;
+	YS_THREAD_LOCAL std::vector<char> case_type_stack;
+	YS_THREAD_LOCAL bool do_not_require_port_stubs;
+	YS_THREAD_LOCAL bool default_nettype_wire;
 	bool sv_mode, formal_mode, lib_mode, specify_mode;
 	bool noassert_mode, noassume_mode, norestrict_mode;
 	bool assume_asserts_mode, assert_assumes_mode;
-	bool current_wire_rand, current_wire_const;
-	bool current_modport_input, current_modport_output;
-	std::istream *lexin;
+	YS_THREAD_LOCAL bool current_wire_rand, current_wire_const;
+	YS_THREAD_LOCAL bool current_modport_input, current_modport_output;
+	YS_THREAD_LOCAL std::istream *lexin;
+	YS_THREAD_LOCAL int enum_count;
 }
 YOSYS_NAMESPACE_END
 
@@ -934,7 +935,7 @@ specify_item:
 
 		AstNode *cell = new AstNode(AST_CELL);
 		ast_stack.back()->children.push_back(cell);
-		cell->str = stringf("$specify$%d", autoidx++);
+		cell->str = stringf("$specify$%d", next_autoidx());
 		cell->children.push_back(new AstNode(AST_CELLTYPE));
 		cell->children.back()->str = target->dat ? "$specify3" : "$specify2";
 		SET_AST_NODE_LOC(cell, en_expr ? @1 : @2, @10);
@@ -1023,7 +1024,7 @@ specify_item:
 
 		AstNode *cell = new AstNode(AST_CELL);
 		ast_stack.back()->children.push_back(cell);
-		cell->str = stringf("$specify$%d", autoidx++);
+		cell->str = stringf("$specify$%d", next_autoidx());
 		cell->children.push_back(new AstNode(AST_CELLTYPE));
 		cell->children.back()->str = "$specrule";
 		SET_AST_NODE_LOC(cell, @1, @14);
@@ -1430,7 +1431,6 @@ single_defparam_decl:
 /////////
 
 enum_type: TOK_ENUM {
-		static int enum_count;
 		// create parent node for the enum
 		astbuf2 = new AstNode(AST_ENUM);
 		ast_stack.back()->children.push_back(astbuf2);
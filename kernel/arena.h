@@ -0,0 +1,146 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/yosys.h"
+
+#ifndef ARENA_H
+#define ARENA_H
+
+YOSYS_NAMESPACE_BEGIN
+
+struct ArenaStats
+{
+	size_t slabs = 0;	// number of slabs allocated from the heap
+	size_t capacity = 0;	// number of objects that fit into the slabs
+	size_t live = 0;	// number of objects currently allocated
+	size_t bytes = 0;	// heap memory used by the slabs
+
+	// unused slots in the slabs, as a fraction of the capacity
+	double fragmentation() const {
+		return capacity ? double(capacity - live) / capacity : 0.0;
+	}
+
+	ArenaStats &operator+=(const ArenaStats &other) {
+		slabs += other.slabs;
+		capacity += other.capacity;
+		live += other.live;
+		bytes += other.bytes;
+		return *this;
+	}
+};
+
+// Storage for objects of type T that are created and destroyed many times
+// by their owner (the wires and cells of a module). Objects are carved out of
+// slabs of increasing size, freed slots are reused for the next allocation,
+// and all slabs are returned to the heap at once when the arena is destroyed.
+//
+// The arena only manages memory: the owner uses placement new on the result
+// of allocate() and calls the destructor before deallocate(). Objects stay
+// at the same address for their whole lifetime.
+//
+// Without YOSYS_ENABLE_ARENA (ENABLE_ARENA=0, or builds with a sanitizer)
+// every object is allocated from the heap individually.
+
+template<typename T>
+class ObjectArena
+{
+	union slot_t {
+		slot_t *next;
+		alignas(T) char storage[sizeof(T)];
+	};
+
+	static constexpr int min_slab_size = 8;
+	static constexpr int max_slab_size = 1024;
+
+	std::vector<slot_t*> slabs_;
+	slot_t *free_ = nullptr;
+	int next_slab_size_ = min_slab_size;
+	size_t capacity_ = 0, live_ = 0;
+
+	void grow()
+	{
+		int size = next_slab_size_;
+		slot_t *slab = static_cast<slot_t*>(::operator new(size * sizeof(slot_t)));
+		slabs_.push_back(slab);
+
+		// hand out the slots in address order
+		for (int i = size-1; i >= 0; i--) {
+			slab[i].next = free_;
+			free_ = &slab[i];
+		}
+
+		capacity_ += size;
+		next_slab_size_ = std::min(2 * size, int(max_slab_size));
+	}
+
+public:
+	ObjectArena() { }
+	ObjectArena(const ObjectArena &) = delete;
+	ObjectArena &operator=(const ObjectArena &) = delete;
+
+	~ObjectArena()
+	{
+		for (auto slab : slabs_)
+			::operator delete(slab);
+	}
+
+	void *allocate()
+	{
+		live_++;
+#ifdef YOSYS_ENABLE_ARENA
+		if (free_ == nullptr)
+			grow();
+		slot_t *slot = free_;
+		free_ = slot->next;
+		return slot;
+#else
+		return ::operator new(sizeof(T));
+#endif
+	}
+
+	void deallocate(T *obj)
+	{
+		live_--;
+#ifdef YOSYS_ENABLE_ARENA
+		slot_t *slot = reinterpret_cast<slot_t*>(obj);
+		slot->next = free_;
+		free_ = slot;
+#else
+		::operator delete(obj);
+#endif
+	}
+
+	ArenaStats stats() const
+	{
+		ArenaStats s;
+		s.slabs = slabs_.size();
+		s.capacity = capacity_;
+		s.live = live_;
+		s.bytes = capacity_ * sizeof(slot_t);
+#ifndef YOSYS_ENABLE_ARENA
+		s.capacity = live_;
+		s.bytes = live_ * sizeof(T);
+#endif
+		return s;
+	}
+};
+
+YOSYS_NAMESPACE_END
+
+#endif
@@ -97,6 +97,174 @@ static RTLIL::Const big2const(const BigInteger &val, int result_len, int undef_b
 	return result;
 }
 
+// Fast paths for fully defined operands. The BigInteger based implementations
+// below are only used when the operands contain undefined bits or when a value
+// does not fit the native integer types.
+
+// Get the low 64 bits of the (sign-)extended value, or fail if any bit is undefined.
+static bool const2word(const RTLIL::Const &val, bool as_signed, uint64_t &result)
+{
+	int num_bits = GetSize(val.bits);
+	uint64_t v = 0;
+
+	for (int i = 0; i < num_bits; i++) {
+		RTLIL::State bit = val.bits[i];
+		if (bit != RTLIL::State::S0 && bit != RTLIL::State::S1)
+			return false;
+		if (i < 64 && bit == RTLIL::State::S1)
+			v |= uint64_t(1) << i;
+	}
+
+	if (as_signed && 0 < num_bits && num_bits < 64 && val.bits.back() == RTLIL::State::S1)
+		v |= ~uint64_t(0) << num_bits;
+
+	result = v;
+	return true;
+}
+
+// Get the value as int64_t, or fail if any bit is undefined or the value does not
+// fit in 62 bits plus sign. (The range leaves headroom for the intermediate values
+// in the division functions.)
+static bool const2int(const RTLIL::Const &val, bool as_signed, int64_t &result)
+{
+	int num_bits = GetSize(val.bits);
+	RTLIL::State ext = as_signed && num_bits > 0 ? val.bits.back() : RTLIL::State::S0;
+	uint64_t v = 0;
+
+	for (int i = 0; i < num_bits; i++) {
+		RTLIL::State bit = val.bits[i];
+		if (bit != RTLIL::State::S0 && bit != RTLIL::State::S1)
+			return false;
+		if (i >= 62) {
+			if (bit != ext)
+				return false;
+		} else if (bit == RTLIL::State::S1)
+			v |= uint64_t(1) << i;
+	}
+
+	if (ext == RTLIL::State::S1)
+		v |= ~uint64_t(0) << min(num_bits, 62);
+
+	result = int64_t(v);
+	return true;
+}
+
+// Bits above 64 are filled with copies of bit 63, i.e. v is sign-extended
+static RTLIL::Const word2const(uint64_t v, int result_len)
+{
+	RTLIL::Const result;
+	result.bits.resize(max(result_len, 0));
+	for (int i = 0; i < result_len; i++)
+		result.bits[i] = (v >> min(i, 63)) & 1 ? RTLIL::State::S1 : RTLIL::State::S0;
+	return result;
+}
+
+static inline void mul_word(uint64_t a, uint64_t b, uint64_t &hi, uint64_t &lo)
+{
+	uint64_t a_lo = a & 0xffffffff, a_hi = a >> 32;
+	uint64_t b_lo = b & 0xffffffff, b_hi = b >> 32;
+	uint64_t ll = a_lo * b_lo, lh = a_lo * b_hi, hl = a_hi * b_lo, hh = a_hi * b_hi;
+	uint64_t mid = (ll >> 32) + (lh & 0xffffffff) + (hl & 0xffffffff);
+	lo = (mid << 32) | (ll & 0xffffffff);
+	hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+}
+
+// Compare the integer values of two constants, or fail if any bit is undefined.
+static bool packed_compare(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int &cmp)
+{
+	int width = max(GetSize(arg1.bits), GetSize(arg2.bits)) + 1;
+	RTLIL::PackedConst a(arg1, width, signed1);
+	RTLIL::PackedConst b(arg2, width, signed2);
+
+	if (!a.is_fully_def() || !b.is_fully_def())
+		return false;
+
+	bool neg_a = a.get(width-1) == RTLIL::State::S1;
+	bool neg_b = b.get(width-1) == RTLIL::State::S1;
+
+	cmp = 0;
+	if (neg_a != neg_b)
+		cmp = neg_a ? -1 : +1;
+	else
+		for (int i = a.words()-1; i >= 0 && cmp == 0; i--)
+			if (a.val[i] != b.val[i])
+				cmp = a.val[i] < b.val[i] ? -1 : +1;
+	return true;
+}
+
+// Add or subtract modulo 2^result_len, or fail if any bit is undefined.
+static bool packed_add(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len, bool subtract, RTLIL::Const &result)
+{
+	if (result_len <= 64) {
+		uint64_t a, b;
+		if (!const2word(arg1, signed1, a) || !const2word(arg2, signed2, b))
+			return false;
+		result = word2const(subtract ? a - b : a + b, result_len);
+		return true;
+	}
+
+	if (!arg1.is_fully_def() || !arg2.is_fully_def())
+		return false;
+
+	RTLIL::PackedConst a(arg1, result_len, signed1);
+	RTLIL::PackedConst b(arg2, result_len, signed2);
+	RTLIL::PackedConst y(result_len);
+
+	uint64_t carry = subtract ? 1 : 0;
+	for (int i = 0; i < y.words(); i++) {
+		uint64_t b_word = subtract ? ~b.val[i] : b.val[i];
+		uint64_t sum = a.val[i] + carry;
+		carry = sum < carry;
+		sum += b_word;
+		carry += sum < b_word;
+		y.val[i] = sum;
+	}
+
+	y.normalize();
+	result = y.as_const();
+	return true;
+}
+
+// Multiply modulo 2^result_len, or fail if any bit is undefined.
+static bool packed_mul(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len, RTLIL::Const &result)
+{
+	if (result_len <= 64) {
+		uint64_t a, b;
+		if (!const2word(arg1, signed1, a) || !const2word(arg2, signed2, b))
+			return false;
+		result = word2const(a * b, result_len);
+		return true;
+	}
+
+	if (!arg1.is_fully_def() || !arg2.is_fully_def())
+		return false;
+
+	RTLIL::PackedConst a(arg1, result_len, signed1);
+	RTLIL::PackedConst b(arg2, result_len, signed2);
+	RTLIL::PackedConst y(result_len);
+	int n = y.words();
+
+	for (int i = 0; i < n; i++) {
+		if (a.val[i] == 0)
+			continue;
+		uint64_t carry = 0;
+		for (int j = 0; i + j < n; j++) {
+			uint64_t hi, lo;
+			mul_word(a.val[i], b.val[j], hi, lo);
+			lo += carry;
+			hi += lo < carry;
+			lo += y.val[i+j];
+			hi += lo < y.val[i+j];
+			y.val[i+j] = lo;
+			carry = hi;
+		}
+	}
+
+	y.normalize();
+	result = y.as_const();
+	return true;
+}
+
 static RTLIL::State logic_and(RTLIL::State a, RTLIL::State b)
 {
 	if (a == RTLIL::State::S0) return RTLIL::State::S0;
@@ -115,18 +283,89 @@ static RTLIL::State logic_or(RTLIL::State a, RTLIL::State b)
 	return RTLIL::State::S0;
 }
 
-static RTLIL::State logic_xor(RTLIL::State a, RTLIL::State b)
+static RTLIL::State logic_invert(RTLIL::State a)
 {
-	if (a != RTLIL::State::S0 && a != RTLIL::State::S1) return RTLIL::State::Sx;
-	if (b != RTLIL::State::S0 && b != RTLIL::State::S1) return RTLIL::State::Sx;
-	return a != b ? RTLIL::State::S1 : RTLIL::State::S0;
+	if (a == RTLIL::State::S0) return RTLIL::State::S1;
+	if (a == RTLIL::State::S1) return RTLIL::State::S0;
+	return a;
 }
 
-static RTLIL::State logic_xnor(RTLIL::State a, RTLIL::State b)
+// Word-level versions of the four-valued gate functions, operating on the value
+// and undef planes of a RTLIL::PackedConst (see rtlil.h). Undefined results are
+// always Sx, i.e. value bit 0 and undef bit 1.
+
+struct packed_not {
+	static inline void eval(uint64_t av, uint64_t au, uint64_t &v, uint64_t &u) {
+		v = ~av & ~au, u = au;
+	}
+};
+
+struct packed_and {
+	static inline void eval(uint64_t av, uint64_t au, uint64_t bv, uint64_t bu, uint64_t &v, uint64_t &u) {
+		uint64_t one = (av & ~au) & (bv & ~bu);
+		uint64_t zero = (~av & ~au) | (~bv & ~bu);
+		v = one, u = ~(one | zero);
+	}
+};
+
+struct packed_or {
+	static inline void eval(uint64_t av, uint64_t au, uint64_t bv, uint64_t bu, uint64_t &v, uint64_t &u) {
+		uint64_t one = (av & ~au) | (bv & ~bu);
+		uint64_t zero = (~av & ~au) & (~bv & ~bu);
+		v = one, u = ~(one | zero);
+	}
+};
+
+struct packed_xor {
+	static inline void eval(uint64_t av, uint64_t au, uint64_t bv, uint64_t bu, uint64_t &v, uint64_t &u) {
+		u = au | bu, v = (av ^ bv) & ~u;
+	}
+};
+
+struct packed_xnor {
+	static inline void eval(uint64_t av, uint64_t au, uint64_t bv, uint64_t bu, uint64_t &v, uint64_t &u) {
+		u = au | bu, v = ~(av ^ bv) & ~u;
+	}
+};
+
+static inline bool parity64(uint64_t x)
 {
-	if (a != RTLIL::State::S0 && a != RTLIL::State::S1) return RTLIL::State::Sx;
-	if (b != RTLIL::State::S0 && b != RTLIL::State::S1) return RTLIL::State::Sx;
-	return a == b ? RTLIL::State::S1 : RTLIL::State::S0;
+	x ^= x >> 32;
+	x ^= x >> 16;
+	x ^= x >> 8;
+	x ^= x >> 4;
+	x ^= x >> 2;
+	x ^= x >> 1;
+	return x & 1;
+}
+
+// S1 if any defined bit is 1, else Sx if any bit is undefined, else S0
+static RTLIL::State packed_any_one(const RTLIL::PackedConst &a)
+{
+	for (int i = 0; i < a.words(); i++)
+		if (a.val[i] & ~a.undef_word(i))
+			return RTLIL::State::S1;
+	return a.is_fully_def() ? RTLIL::State::S0 : RTLIL::State::Sx;
+}
+
+// S0 if any defined bit is 0, else Sx if any bit is undefined, else S1
+static RTLIL::State packed_all_ones(const RTLIL::PackedConst &a)
+{
+	for (int i = 0; i < a.words(); i++)
+		if (~a.val[i] & ~a.undef_word(i) & a.word_mask(i))
+			return RTLIL::State::S0;
+	return a.is_fully_def() ? RTLIL::State::S1 : RTLIL::State::Sx;
+}
+
+static RTLIL::State packed_parity(const RTLIL::PackedConst &a)
+{
+	if (!a.is_fully_def())
+		return RTLIL::State::Sx;
+
+	uint64_t x = 0;
+	for (auto v : a.val)
+		x ^= v;
+	return parity64(x) ? RTLIL::State::S1 : RTLIL::State::S0;
 }
 
 RTLIL::Const RTLIL::const_not(const RTLIL::Const &arg1, const RTLIL::Const&, bool signed1, bool, int result_len)
@@ -134,68 +373,68 @@ RTLIL::Const RTLIL::const_not(const RTLIL::Const &arg1, const RTLIL::Const&, boo
 	if (result_len < 0)
 		result_len = arg1.bits.size();
 
-	RTLIL::Const arg1_ext = arg1;
-	extend_u0(arg1_ext, result_len, signed1);
+	RTLIL::PackedConst a(arg1, result_len, signed1);
+	RTLIL::PackedConst y(result_len);
 
-	RTLIL::Const result(RTLIL::State::Sx, result_len);
-	for (size_t i = 0; i < size_t(result_len); i++) {
-		if (i >= arg1_ext.bits.size())
-			result.bits[i] = RTLIL::State::S0;
-		else if (arg1_ext.bits[i] == RTLIL::State::S0)
-			result.bits[i] = RTLIL::State::S1;
-		else if (arg1_ext.bits[i] == RTLIL::State::S1)
-			result.bits[i] = RTLIL::State::S0;
+	if (a.is_fully_def()) {
+		for (int i = 0; i < y.words(); i++)
+			y.val[i] = ~a.val[i];
+	} else {
+		y.undef.resize(y.words());
+		for (int i = 0; i < y.words(); i++)
+			packed_not::eval(a.val[i], a.undef[i], y.val[i], y.undef[i]);
 	}
 
-	return result;
+	y.normalize();
+	return y.as_const();
 }
 
-static RTLIL::Const logic_wrapper(RTLIL::State(*logic_func)(RTLIL::State, RTLIL::State),
-		RTLIL::Const arg1, RTLIL::Const arg2, bool signed1, bool signed2, int result_len = -1)
+template<typename T>
+static RTLIL::Const logic_wrapper(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len = -1)
 {
 	if (result_len < 0)
 		result_len = max(arg1.bits.size(), arg2.bits.size());
 
-	extend_u0(arg1, result_len, signed1);
-	extend_u0(arg2, result_len, signed2);
+	RTLIL::PackedConst a(arg1, result_len, signed1);
+	RTLIL::PackedConst b(arg2, result_len, signed2);
+	RTLIL::PackedConst y(result_len);
 
-	RTLIL::Const result(RTLIL::State::Sx, result_len);
-	for (size_t i = 0; i < size_t(result_len); i++) {
-		RTLIL::State a = i < arg1.bits.size() ? arg1.bits[i] : RTLIL::State::S0;
-		RTLIL::State b = i < arg2.bits.size() ? arg2.bits[i] : RTLIL::State::S0;
-		result.bits[i] = logic_func(a, b);
+	if (a.is_fully_def() && b.is_fully_def()) {
+		uint64_t u;
+		for (int i = 0; i < y.words(); i++)
+			T::eval(a.val[i], 0, b.val[i], 0, y.val[i], u);
+	} else {
+		y.undef.resize(y.words());
+		for (int i = 0; i < y.words(); i++)
+			T::eval(a.val[i], a.undef_word(i), b.val[i], b.undef_word(i), y.val[i], y.undef[i]);
 	}
 
-	return result;
+	y.normalize();
+	return y.as_const();
 }
 
 RTLIL::Const RTLIL::const_and(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
-	return logic_wrapper(logic_and, arg1, arg2, signed1, signed2, result_len);
+	return logic_wrapper<packed_and>(arg1, arg2, signed1, signed2, result_len);
 }
 
 RTLIL::Const RTLIL::const_or(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
-	return logic_wrapper(logic_or, arg1, arg2, signed1, signed2, result_len);
+	return logic_wrapper<packed_or>(arg1, arg2, signed1, signed2, result_len);
 }
 
 RTLIL::Const RTLIL::const_xor(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
-	return logic_wrapper(logic_xor, arg1, arg2, signed1, signed2, result_len);
+	return logic_wrapper<packed_xor>(arg1, arg2, signed1, signed2, result_len);
 }
 
 RTLIL::Const RTLIL::const_xnor(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
-	return logic_wrapper(logic_xnor, arg1, arg2, signed1, signed2, result_len);
+	return logic_wrapper<packed_xnor>(arg1, arg2, signed1, signed2, result_len);
 }
 
-static RTLIL::Const logic_reduce_wrapper(RTLIL::State initial, RTLIL::State(*logic_func)(RTLIL::State, RTLIL::State), const RTLIL::Const &arg1, int result_len)
+static RTLIL::Const logic_reduce_wrapper(RTLIL::State temp, int result_len)
 {
-	RTLIL::State temp = initial;
-
-	for (size_t i = 0; i < arg1.bits.size(); i++)
-		temp = logic_func(temp, arg1.bits[i]);
-
 	RTLIL::Const result(temp);
 	while (int(result.bits.size()) < result_len)
 		result.bits.push_back(RTLIL::State::S0);
@@ -204,75 +443,46 @@ static RTLIL::Const logic_reduce_wrapper(RTLIL::State initial, RTLIL::State(*log
 
 RTLIL::Const RTLIL::const_reduce_and(const RTLIL::Const &arg1, const RTLIL::Const&, bool, bool, int result_len)
 {
-	return logic_reduce_wrapper(RTLIL::State::S1, logic_and, arg1, result_len);
+	return logic_reduce_wrapper(packed_all_ones(RTLIL::PackedConst(arg1)), result_len);
 }
 
 RTLIL::Const RTLIL::const_reduce_or(const RTLIL::Const &arg1, const RTLIL::Const&, bool, bool, int result_len)
 {
-	return logic_reduce_wrapper(RTLIL::State::S0, logic_or, arg1, result_len);
+	return logic_reduce_wrapper(packed_any_one(RTLIL::PackedConst(arg1)), result_len);
 }
 
 RTLIL::Const RTLIL::const_reduce_xor(const RTLIL::Const &arg1, const RTLIL::Const&, bool, bool, int result_len)
 {
-	return logic_reduce_wrapper(RTLIL::State::S0, logic_xor, arg1, result_len);
+	return logic_reduce_wrapper(packed_parity(RTLIL::PackedConst(arg1)), result_len);
 }
 
 RTLIL::Const RTLIL::const_reduce_xnor(const RTLIL::Const &arg1, const RTLIL::Const&, bool, bool, int result_len)
 {
-	RTLIL::Const buffer = logic_reduce_wrapper(RTLIL::State::S0, logic_xor, arg1, result_len);
-	if (!buffer.bits.empty()) {
-		if (buffer.bits.front() == RTLIL::State::S0)
-			buffer.bits.front() = RTLIL::State::S1;
-		else if (buffer.bits.front() == RTLIL::State::S1)
-			buffer.bits.front() = RTLIL::State::S0;
-	}
-	return buffer;
+	return logic_reduce_wrapper(logic_invert(packed_parity(RTLIL::PackedConst(arg1))), result_len);
 }
 
 RTLIL::Const RTLIL::const_reduce_bool(const RTLIL::Const &arg1, const RTLIL::Const&, bool, bool, int result_len)
 {
-	return logic_reduce_wrapper(RTLIL::State::S0, logic_or, arg1, result_len);
+	return logic_reduce_wrapper(packed_any_one(RTLIL::PackedConst(arg1)), result_len);
 }
 
-RTLIL::Const RTLIL::const_logic_not(const RTLIL::Const &arg1, const RTLIL::Const&, bool signed1, bool, int result_len)
+RTLIL::Const RTLIL::const_logic_not(const RTLIL::Const &arg1, const RTLIL::Const&, bool, bool, int result_len)
 {
-	int undef_bit_pos_a = -1;
-	BigInteger a = const2big(arg1, signed1, undef_bit_pos_a);
-	RTLIL::Const result(a.isZero() ? undef_bit_pos_a >= 0 ? RTLIL::State::Sx : RTLIL::State::S1 : RTLIL::State::S0);
-
-	while (int(result.bits.size()) < result_len)
-		result.bits.push_back(RTLIL::State::S0);
-	return result;
+	return logic_reduce_wrapper(logic_invert(packed_any_one(RTLIL::PackedConst(arg1))), result_len);
 }
 
-RTLIL::Const RTLIL::const_logic_and(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
+RTLIL::Const RTLIL::const_logic_and(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool, bool, int result_len)
 {
-	int undef_bit_pos_a = -1, undef_bit_pos_b = -1;
-	BigInteger a = const2big(arg1, signed1, undef_bit_pos_a);
-	BigInteger b = const2big(arg2, signed2, undef_bit_pos_b);
-
-	RTLIL::State bit_a = a.isZero() ? undef_bit_pos_a >= 0 ? RTLIL::State::Sx : RTLIL::State::S0 : RTLIL::State::S1;
-	RTLIL::State bit_b = b.isZero() ? undef_bit_pos_b >= 0 ? RTLIL::State::Sx : RTLIL::State::S0 : RTLIL::State::S1;
-	RTLIL::Const result(logic_and(bit_a, bit_b));
-
-	while (int(result.bits.size()) < result_len)
-		result.bits.push_back(RTLIL::State::S0);
-	return result;
+	RTLIL::State bit_a = packed_any_one(RTLIL::PackedConst(arg1));
+	RTLIL::State bit_b = packed_any_one(RTLIL::PackedConst(arg2));
+	return logic_reduce_wrapper(logic_and(bit_a, bit_b), result_len);
 }
 
-RTLIL::Const RTLIL::const_logic_or(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
+RTLIL::Const RTLIL::const_logic_or(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool, bool, int result_len)
 {
-	int undef_bit_pos_a = -1, undef_bit_pos_b = -1;
-	BigInteger a = const2big(arg1, signed1, undef_bit_pos_a);
-	BigInteger b = const2big(arg2, signed2, undef_bit_pos_b);
-
-	RTLIL::State bit_a = a.isZero() ? undef_bit_pos_a >= 0 ? RTLIL::State::Sx : RTLIL::State::S0 : RTLIL::State::S1;
-	RTLIL::State bit_b = b.isZero() ? undef_bit_pos_b >= 0 ? RTLIL::State::Sx : RTLIL::State::S0 : RTLIL::State::S1;
-	RTLIL::Const result(logic_or(bit_a, bit_b));
-
-	while (int(result.bits.size()) < result_len)
-		result.bits.push_back(RTLIL::State::S0);
-	return result;
+	RTLIL::State bit_a = packed_any_one(RTLIL::PackedConst(arg1));
+	RTLIL::State bit_b = packed_any_one(RTLIL::PackedConst(arg2));
+	return logic_reduce_wrapper(logic_or(bit_a, bit_b), result_len);
 }
 
 // Shift `arg1` by `arg2` bits.
@@ -282,12 +492,30 @@ RTLIL::Const RTLIL::const_logic_or(const RTLIL::Const &arg1, const RTLIL::Const
 // bounds are filled with the leftmost bit of `arg1` (arithmetic shift).
 static RTLIL::Const const_shift_worker(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool sign_ext, bool signed2, int direction, int result_len, RTLIL::State vacant_bits = RTLIL::State::S0)
 {
-	int undef_bit_pos = -1;
-	BigInteger offset = const2big(arg2, signed2, undef_bit_pos) * direction;
-
 	if (result_len < 0)
 		result_len = arg1.bits.size();
 
+	int64_t small_offset;
+	if (const2int(arg2, signed2, small_offset))
+	{
+		small_offset *= direction;
+		RTLIL::Const result;
+		result.bits.resize(result_len);
+		for (int i = 0; i < result_len; i++) {
+			int64_t pos = i + small_offset;
+			if (pos < 0)
+				result.bits[i] = vacant_bits;
+			else if (pos >= GetSize(arg1.bits))
+				result.bits[i] = sign_ext ? arg1.bits.back() : vacant_bits;
+			else
+				result.bits[i] = arg1.bits[pos];
+		}
+		return result;
+	}
+
+	int undef_bit_pos = -1;
+	BigInteger offset = const2big(arg2, signed2, undef_bit_pos) * direction;
+
 	RTLIL::Const result(RTLIL::State::Sx, result_len);
 	if (undef_bit_pos >= 0)
 		return result;
@@ -343,9 +571,9 @@ RTLIL::Const RTLIL::const_shiftx(const RTLIL::Const &arg1, const RTLIL::Const &a
 
 RTLIL::Const RTLIL::const_lt(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
-	int undef_bit_pos = -1;
-	bool y = const2big(arg1, signed1, undef_bit_pos) < const2big(arg2, signed2, undef_bit_pos);
-	RTLIL::Const result(undef_bit_pos >= 0 ? RTLIL::State::Sx : y ? RTLIL::State::S1 : RTLIL::State::S0);
+	int cmp;
+	bool def = packed_compare(arg1, arg2, signed1, signed2, cmp);
+	RTLIL::Const result(!def ? RTLIL::State::Sx : cmp < 0 ? RTLIL::State::S1 : RTLIL::State::S0);
 
 	while (int(result.bits.size()) < result_len)
 		result.bits.push_back(RTLIL::State::S0);
@@ -354,9 +582,9 @@ RTLIL::Const RTLIL::const_lt(const RTLIL::Const &arg1, const RTLIL::Const &arg2,
 
 RTLIL::Const RTLIL::const_le(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
-	int undef_bit_pos = -1;
-	bool y = const2big(arg1, signed1, undef_bit_pos) <= const2big(arg2, signed2, undef_bit_pos);
-	RTLIL::Const result(undef_bit_pos >= 0 ? RTLIL::State::Sx : y ? RTLIL::State::S1 : RTLIL::State::S0);
+	int cmp;
+	bool def = packed_compare(arg1, arg2, signed1, signed2, cmp);
+	RTLIL::Const result(!def ? RTLIL::State::Sx : cmp <= 0 ? RTLIL::State::S1 : RTLIL::State::S0);
 
 	while (int(result.bits.size()) < result_len)
 		result.bits.push_back(RTLIL::State::S0);
@@ -390,10 +618,7 @@ RTLIL::Const RTLIL::const_eq(const RTLIL::Const &arg1, const RTLIL::Const &arg2,
 RTLIL::Const RTLIL::const_ne(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
 	RTLIL::Const result = RTLIL::const_eq(arg1, arg2, signed1, signed2, result_len);
-	if (result.bits.front() == RTLIL::State::S0)
-		result.bits.front() = RTLIL::State::S1;
-	else if (result.bits.front() == RTLIL::State::S1)
-		result.bits.front() = RTLIL::State::S0;
+	result.bits.front() = logic_invert(result.bits.front());
 	return result;
 }
 
@@ -428,9 +653,9 @@ RTLIL::Const RTLIL::const_nex(const RTLIL::Const &arg1, const RTLIL::Const &arg2
 
 RTLIL::Const RTLIL::const_ge(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
-	int undef_bit_pos = -1;
-	bool y = const2big(arg1, signed1, undef_bit_pos) >= const2big(arg2, signed2, undef_bit_pos);
-	RTLIL::Const result(undef_bit_pos >= 0 ? RTLIL::State::Sx : y ? RTLIL::State::S1 : RTLIL::State::S0);
+	int cmp;
+	bool def = packed_compare(arg1, arg2, signed1, signed2, cmp);
+	RTLIL::Const result(!def ? RTLIL::State::Sx : cmp >= 0 ? RTLIL::State::S1 : RTLIL::State::S0);
 
 	while (int(result.bits.size()) < result_len)
 		result.bits.push_back(RTLIL::State::S0);
@@ -439,9 +664,9 @@ RTLIL::Const RTLIL::const_ge(const RTLIL::Const &arg1, const RTLIL::Const &arg2,
 
 RTLIL::Const RTLIL::const_gt(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
-	int undef_bit_pos = -1;
-	bool y = const2big(arg1, signed1, undef_bit_pos) > const2big(arg2, signed2, undef_bit_pos);
-	RTLIL::Const result(undef_bit_pos >= 0 ? RTLIL::State::Sx : y ? RTLIL::State::S1 : RTLIL::State::S0);
+	int cmp;
+	bool def = packed_compare(arg1, arg2, signed1, signed2, cmp);
+	RTLIL::Const result(!def ? RTLIL::State::Sx : cmp > 0 ? RTLIL::State::S1 : RTLIL::State::S0);
 
 	while (int(result.bits.size()) < result_len)
 		result.bits.push_back(RTLIL::State::S0);
@@ -450,28 +675,56 @@ RTLIL::Const RTLIL::const_gt(const RTLIL::Const &arg1, const RTLIL::Const &arg2,
 
 RTLIL::Const RTLIL::const_add(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	if (result_len < 0)
+		result_len = max(arg1.bits.size(), arg2.bits.size());
+
+	RTLIL::Const result;
+	if (packed_add(arg1, arg2, signed1, signed2, result_len, false, result))
+		return result;
+
 	int undef_bit_pos = -1;
 	BigInteger y = const2big(arg1, signed1, undef_bit_pos) + const2big(arg2, signed2, undef_bit_pos);
-	return big2const(y, result_len >= 0 ? result_len : max(arg1.bits.size(), arg2.bits.size()), undef_bit_pos);
+	return big2const(y, result_len, undef_bit_pos);
 }
 
 RTLIL::Const RTLIL::const_sub(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	if (result_len < 0)
+		result_len = max(arg1.bits.size(), arg2.bits.size());
+
+	RTLIL::Const result;
+	if (packed_add(arg1, arg2, signed1, signed2, result_len, true, result))
+		return result;
+
 	int undef_bit_pos = -1;
 	BigInteger y = const2big(arg1, signed1, undef_bit_pos) - const2big(arg2, signed2, undef_bit_pos);
-	return big2const(y, result_len >= 0 ? result_len : max(arg1.bits.size(), arg2.bits.size()), undef_bit_pos);
+	return big2const(y, result_len, undef_bit_pos);
 }
 
 RTLIL::Const RTLIL::const_mul(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	if (result_len < 0)
+		result_len = max(arg1.bits.size(), arg2.bits.size());
+
+	RTLIL::Const result;
+	if (packed_mul(arg1, arg2, signed1, signed2, result_len, result))
+		return result;
+
 	int undef_bit_pos = -1;
 	BigInteger y = const2big(arg1, signed1, undef_bit_pos) * const2big(arg2, signed2, undef_bit_pos);
-	return big2const(y, result_len >= 0 ? result_len : max(arg1.bits.size(), arg2.bits.size()), min(undef_bit_pos, 0));
+	return big2const(y, result_len, min(undef_bit_pos, 0));
 }
 
 // truncating division
 RTLIL::Const RTLIL::const_div(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	int64_t small_a, small_b;
+	if (const2int(arg1, signed1, small_a) && const2int(arg2, signed2, small_b)) {
+		if (small_b == 0)
+			return RTLIL::Const(RTLIL::State::Sx, result_len);
+		return word2const(small_a / small_b, result_len >= 0 ? result_len : max(arg1.bits.size(), arg2.bits.size()));
+	}
+
 	int undef_bit_pos = -1;
 	BigInteger a = const2big(arg1, signed1, undef_bit_pos);
 	BigInteger b = const2big(arg2, signed2, undef_bit_pos);
@@ -486,6 +739,13 @@ RTLIL::Const RTLIL::const_div(const RTLIL::Const &arg1, const RTLIL::Const &arg2
 // truncating modulo
 RTLIL::Const RTLIL::const_mod(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	int64_t small_a, small_b;
+	if (const2int(arg1, signed1, small_a) && const2int(arg2, signed2, small_b)) {
+		if (small_b == 0)
+			return RTLIL::Const(RTLIL::State::Sx, result_len);
+		return word2const(small_a % small_b, result_len >= 0 ? result_len : max(arg1.bits.size(), arg2.bits.size()));
+	}
+
 	int undef_bit_pos = -1;
 	BigInteger a = const2big(arg1, signed1, undef_bit_pos);
 	BigInteger b = const2big(arg2, signed2, undef_bit_pos);
@@ -499,6 +759,16 @@ RTLIL::Const RTLIL::const_mod(const RTLIL::Const &arg1, const RTLIL::Const &arg2
 
 RTLIL::Const RTLIL::const_divfloor(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	int64_t small_a, small_b;
+	if (const2int(arg1, signed1, small_a) && const2int(arg2, signed2, small_b)) {
+		if (small_b == 0)
+			return RTLIL::Const(RTLIL::State::Sx, result_len);
+		int64_t y = small_a / small_b;
+		if (small_a % small_b != 0 && (small_a < 0) != (small_b < 0))
+			y--;
+		return word2const(y, result_len >= 0 ? result_len : max(arg1.bits.size(), arg2.bits.size()));
+	}
+
 	int undef_bit_pos = -1;
 	BigInteger a = const2big(arg1, signed1, undef_bit_pos);
 	BigInteger b = const2big(arg2, signed2, undef_bit_pos);
@@ -521,6 +791,16 @@ RTLIL::Const RTLIL::const_divfloor(const RTLIL::Const &arg1, const RTLIL::Const
 
 RTLIL::Const RTLIL::const_modfloor(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	int64_t small_a, small_b;
+	if (const2int(arg1, signed1, small_a) && const2int(arg2, signed2, small_b)) {
+		if (small_b == 0)
+			return RTLIL::Const(RTLIL::State::Sx, result_len);
+		int64_t y = small_a % small_b;
+		if (y != 0 && (y < 0) != (small_b < 0))
+			y += small_b;
+		return word2const(y, result_len >= 0 ? result_len : max(arg1.bits.size(), arg2.bits.size()));
+	}
+
 	int undef_bit_pos = -1;
 	BigInteger a = const2big(arg1, signed1, undef_bit_pos);
 	BigInteger b = const2big(arg2, signed2, undef_bit_pos);
@@ -544,6 +824,18 @@ RTLIL::Const RTLIL::const_modfloor(const RTLIL::Const &arg1, const RTLIL::Const
 
 RTLIL::Const RTLIL::const_pow(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	int64_t small_a, small_b;
+	if (0 <= result_len && result_len <= 64 && const2int(arg1, signed1, small_a) && const2int(arg2, signed2, small_b) && small_b >= 0) {
+		// Power-modulo with 2^64 as modulus
+		uint64_t a = small_a, y = 1;
+		for (int64_t b = small_b; b > 0; b = b / 2) {
+			if (b % 2 == 1)
+				y = y * a;
+			a = a * a;
+		}
+		return word2const(y, result_len);
+	}
+
 	int undef_bit_pos = -1;
 
 	BigInteger a = const2big(arg1, signed1, undef_bit_pos);
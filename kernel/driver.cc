@@ -18,6 +18,8 @@
  */
 
 #include "kernel/yosys.h"
+#include "kernel/threading.h"
+#include "kernel/profile.h"
 #include "libs/sha1/sha1.h"
 
 #ifdef YOSYS_ENABLE_READLINE
@@ -34,6 +36,10 @@
 #include <limits.h>
 #include <errno.h>
 
+#if defined(HASHLIB_STATS) && defined(__GNUC__)
+#  include <cxxabi.h>
+#endif
+
 #if defined (__linux__) || defined(__FreeBSD__)
 #  include <sys/resource.h>
 #  include <sys/types.h>
@@ -155,6 +161,26 @@ int yosys_history_offset = 0;
 std::string yosys_history_file;
 #endif
 
+// the -R option records everything from the start to the end of the run
+static std::string profile_trace_file;
+static int profile_trace_index = -1;
+
+static void write_profile_trace()
+{
+	if (profile_trace_file.empty())
+		return;
+
+	profile_end(profile_trace_index);
+	profile_stop();
+
+	std::ofstream f(profile_trace_file.c_str(), std::ofstream::trunc);
+	if (f.fail())
+		fprintf(stderr, "Can't open trace file `%s' for writing: %s\n", profile_trace_file.c_str(), strerror(errno));
+	else
+		profile_write_trace(f);
+	profile_trace_file.clear();
+}
+
 #if defined(__wasm)
 extern "C" {
 	// FIXME: WASI does not currently support exceptions.
@@ -170,6 +196,8 @@ extern "C" {
 
 void yosys_atexit()
 {
+	write_profile_trace();
+
 #if defined(YOSYS_ENABLE_READLINE) || defined(YOSYS_ENABLE_EDITLINE)
 	if (!yosys_history_file.empty()) {
 #if defined(YOSYS_ENABLE_READLINE)
@@ -192,6 +220,51 @@ void yosys_atexit()
 #endif
 }
 
+#ifdef HASHLIB_STATS
+// Prints the dict<> and pool<> statistics for the container types and passes
+// with the most collisions
+static void log_hash_stats(bool details)
+{
+	std::vector<hashlib::hash_stats_t*> types;
+	for (auto it = hashlib::hash_stats_t::list().load(); it != nullptr; it = it->next)
+		if (it->lookups)
+			types.push_back(it);
+	std::sort(types.begin(), types.end(), [](hashlib::hash_stats_t *a, hashlib::hash_stats_t *b) {
+		return a->collisions > b->collisions;
+	});
+
+	log("Hash table collisions by container type:\n");
+	for (int i = 0; i < GetSize(types) && (details || i < 10); i++) {
+		auto t = types[i];
+		std::string name = t->type_name;
+#ifdef __GNUC__
+		int status;
+		char *demangled = abi::__cxa_demangle(t->type_name, nullptr, nullptr, &status);
+		if (status == 0)
+			name = demangled;
+		free(demangled);
+#endif
+		for (auto prefix : {"hashlib::", "Yosys::"})
+			for (size_t pos; (pos = name.find(prefix)) != std::string::npos;)
+				name.erase(pos, strlen(prefix));
+		log("%12llu lookups %5.1f%% misses %8.3f coll/lookup %6llu longest %6llu rehashes  %s\n",
+				(unsigned long long)t->lookups, 100.0 * t->misses / t->lookups, double(t->collisions) / t->lookups,
+				(unsigned long long)t->longest_chain, (unsigned long long)t->rehashes, name.c_str());
+	}
+
+	std::set<tuple<uint64_t, uint64_t, std::string>> passdat;
+	for (auto &it : pass_register)
+		if (it.second->hash_lookups)
+			passdat.insert(make_tuple(it.second->hash_collisions, it.second->hash_lookups, it.first));
+
+	log("Hash table collisions by pass:\n");
+	int out_count = 0;
+	for (auto it = passdat.rbegin(); it != passdat.rend() && (details || out_count < 10); it++, out_count++)
+		log("%12llu lookups %8.3f coll/lookup  %s\n", (unsigned long long)std::get<1>(*it),
+				double(std::get<0>(*it)) / std::get<1>(*it), std::get<2>(*it).c_str());
+}
+#endif
+
 int main(int argc, char **argv)
 {
 	std::string frontend_command = "auto";
@@ -244,6 +317,11 @@ int main(int argc, char **argv)
 		printf("    -d\n");
 		printf("        print more detailed timing stats at exit\n");
 		printf("\n");
+		printf("    -R tracefile\n");
+		printf("        record a timeline of all executed commands, external programs and\n");
+		printf("        worker threads, and write it to the specified file in Chrome trace\n");
+		printf("        event format at exit (see 'help profile')\n");
+		printf("\n");
 		printf("    -l logfile\n");
 		printf("        write log messages to the specified file\n");
 		printf("\n");
@@ -314,6 +392,10 @@ int main(int argc, char **argv)
 		printf("    -g\n");
 		printf("        globally enable debug log messages\n");
 		printf("\n");
+		printf("    -j <threads>\n");
+		printf("        default number of threads for commands that support the -threads\n");
+		printf("        option (e.g. opt_expr, opt_merge, opt_clean)\n");
+		printf("\n");
 		printf("    -V\n");
 		printf("        print version information and exit\n");
 		printf("\n");
@@ -340,7 +422,7 @@ int main(int argc, char **argv)
 	}
 
 	int opt;
-	while ((opt = getopt(argc, argv, "MXAQTVSgm:f:Hh:b:o:p:l:L:qv:tds:c:W:w:e:D:P:E:x:")) != -1)
+	while ((opt = getopt(argc, argv, "MXAQTVSgm:f:Hh:b:o:p:l:L:qv:tdR:s:c:W:w:e:D:P:E:x:j:")) != -1)
 	{
 		switch (opt)
 		{
@@ -417,6 +499,9 @@ int main(int argc, char **argv)
 		case 'd':
 			timing_details = true;
 			break;
+		case 'R':
+			profile_trace_file = optarg;
+			break;
 		case 's':
 			scriptfile = optarg;
 			scriptfile_tcl = false;
@@ -465,12 +550,27 @@ int main(int argc, char **argv)
 		case 'x':
 			log_experimentals_ignored.insert(optarg);
 			break;
+		case 'j':
+			yosys_threads = atoi(optarg);
+			if (yosys_threads < 1) {
+				fprintf(stderr, "Invalid number of threads: %s\n", optarg);
+				exit(1);
+			}
+			break;
 		default:
 			fprintf(stderr, "Run '%s -h' for help.\n", argv[0]);
 			exit(1);
 		}
 	}
 
+	if (!profile_trace_file.empty()) {
+		std::string cmdline = argv[0];
+		for (int i = 1; i < argc; i++)
+			cmdline += std::string(" ") + argv[i];
+		profile_start();
+		profile_trace_index = profile_begin("yosys", cmdline, "phase");
+	}
+
 	if (log_errfile == NULL) {
 		log_files.push_back(stdout);
 		log_error_stderr = true;
@@ -645,6 +745,10 @@ int main(int argc, char **argv)
 			}
 			log("%s\n", out_count ? "" : " no commands executed");
 		}
+
+#ifdef HASHLIB_STATS
+		log_hash_stats(timing_details);
+#endif
 	}
 
 #if defined(YOSYS_ENABLE_COVER) && (defined(__linux__) || defined(__FreeBSD__))
@@ -16,26 +16,81 @@
 #include <algorithm>
 #include <string>
 #include <vector>
+#include <type_traits>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef HASHLIB_STATS
+#  include <atomic>
+#  include <typeinfo>
+#endif
+
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
 
 namespace hashlib {
 
 const int hashtable_size_trigger = 2;
 const int hashtable_size_factor = 3;
 
-// The XOR version of DJB2
-inline unsigned int mkhash(unsigned int a, unsigned int b) {
-	return ((a << 5) + a) ^ b;
+// Multiply-xorshift finalizer (as used by wyhash and xxh3): every input bit
+// affects every output bit.
+inline unsigned int mkhash_mix64(uint64_t h) {
+	h ^= h >> 32;
+	h *= 0xd6e8feb86659fd93ull;
+	h ^= h >> 32;
+	h *= 0xd6e8feb86659fd93ull;
+	h ^= h >> 32;
+	return h;
 }
 
 // traditionally 5381 is used as starting value for the djb2 hash
 const unsigned int mkhash_init = 5381;
 
+#ifdef HASHLIB_MIX64
+
+// With HASHLIB_MIX64 the hash combinations go through the 64-bit finalizer.
+// This avoids the collisions of DJB2 on regular keys (e.g. pairs of small
+// integers) at the cost of two multiplications per combination.
+inline unsigned int mkhash(unsigned int a, unsigned int b) {
+	return mkhash_mix64(uint64_t(a) << 32 | b);
+}
+
+// (use this version for cache locality in b)
+inline unsigned int mkhash_add(unsigned int a, unsigned int b) {
+	return mkhash_mix64(a) + b;
+}
+
+#else
+
+// The XOR version of DJB2
+inline unsigned int mkhash(unsigned int a, unsigned int b) {
+	return ((a << 5) + a) ^ b;
+}
+
 // The ADD version of DJB2
 // (use this version for cache locality in b)
 inline unsigned int mkhash_add(unsigned int a, unsigned int b) {
 	return ((a << 5) + a) + b;
 }
 
+#endif
+
+// Hashes a byte string 8 bytes at a time, used for strings with HASHLIB_MIX64
+inline unsigned int mkhash_bytes(const char *p, size_t len) {
+	uint64_t h = len * 0x9e3779b97f4a7c15ull;
+	for (; len >= 8; p += 8, len -= 8) {
+		uint64_t w;
+		memcpy(&w, p, 8);
+		h = (h ^ w) * 0xd6e8feb86659fd93ull;
+		h ^= h >> 32;
+	}
+	uint64_t w = 0;
+	memcpy(&w, p, len);
+	return mkhash_mix64(h ^ w);
+}
+
 inline unsigned int mkhash_xorshift(unsigned int a) {
 	if (sizeof(a) == 4) {
 		a ^= a << 13;
@@ -75,7 +130,11 @@ template<> struct hash_ops<int32_t> : hash_int_ops
 template<> struct hash_ops<int64_t> : hash_int_ops
 {
 	static inline unsigned int hash(int64_t a) {
+#ifdef HASHLIB_MIX64
+		return mkhash_mix64(a);
+#else
 		return mkhash((unsigned int)(a), (unsigned int)(a >> 32));
+#endif
 	}
 };
 
@@ -84,10 +143,14 @@ template<> struct hash_ops<std::string> {
 		return a == b;
 	}
 	static inline unsigned int hash(const std::string &a) {
+#ifdef HASHLIB_MIX64
+		return mkhash_bytes(a.data(), a.size());
+#else
 		unsigned int v = 0;
 		for (auto c : a)
 			v = mkhash(v, c);
 		return v;
+#endif
 	}
 };
 
@@ -135,10 +198,14 @@ struct hash_cstr_ops {
 		return true;
 	}
 	static inline unsigned int hash(const char *a) {
+#ifdef HASHLIB_MIX64
+		return mkhash_bytes(a, strlen(a));
+#else
 		unsigned int hash = mkhash_init;
 		while (*a)
 			hash = mkhash(hash, *(a++));
 		return hash;
+#endif
 	}
 };
 
@@ -147,7 +214,11 @@ struct hash_ptr_ops {
 		return a == b;
 	}
 	static inline unsigned int hash(const void *a) {
+#ifdef HASHLIB_MIX64
+		return mkhash_mix64((uintptr_t)a);
+#else
 		return (uintptr_t)a;
+#endif
 	}
 };
 
@@ -166,6 +237,53 @@ inline unsigned int mkhash(const T &v) {
 	return hash_ops<T>().hash(v);
 }
 
+#ifdef HASHLIB_STATS
+// Lookup statistics of all dict<> or pool<> instances of one type. A collision
+// is a key comparison that did not match, i.e. a lookup with n collisions
+// walked a chain of n other keys.
+struct hash_stats_t
+{
+	const char *type_name;
+	std::atomic<uint64_t> lookups, misses, collisions, longest_chain, rehashes;
+	hash_stats_t *next;
+
+	hash_stats_t(const char *type_name) : type_name(type_name),
+			lookups(0), misses(0), collisions(0), longest_chain(0), rehashes(0)
+	{
+		next = list().load();
+		while (!list().compare_exchange_weak(next, this)) { }
+	}
+
+	void add_lookup(int collisions_, bool hit)
+	{
+		lookups.fetch_add(1, std::memory_order_relaxed);
+		if (!hit)
+			misses.fetch_add(1, std::memory_order_relaxed);
+		if (collisions_ == 0)
+			return;
+		collisions.fetch_add(collisions_, std::memory_order_relaxed);
+		uint64_t longest = longest_chain.load(std::memory_order_relaxed);
+		while (uint64_t(collisions_) > longest && !longest_chain.compare_exchange_weak(longest, collisions_)) { }
+	}
+
+	// All types that have been used so far
+	static std::atomic<hash_stats_t*> &list()
+	{
+		static std::atomic<hash_stats_t*> head(nullptr);
+		return head;
+	}
+
+	static void totals(uint64_t &lookups, uint64_t &collisions)
+	{
+		lookups = 0, collisions = 0;
+		for (hash_stats_t *it = list().load(); it != nullptr; it = it->next) {
+			lookups += it->lookups.load(std::memory_order_relaxed);
+			collisions += it->collisions.load(std::memory_order_relaxed);
+		}
+	}
+};
+#endif
+
 inline int hashtable_size(int min_size)
 {
 	static std::vector<int> zero_and_some_primes = {
@@ -191,17 +309,246 @@ inline int hashtable_size(int min_size)
 	throw std::length_error("hash table exceeded maximum size.");
 }
 
-template<typename K, typename T, typename OPS = hash_ops<K>> class dict;
+// Selects how dict<> and pool<> find their entries. Both layouts keep the
+// entries in a vector in insertion order, so iteration order and erase()
+// behave the same. hash_chained uses a prime sized bucket array with a linked
+// list through the entries. hash_probed uses an open addressing table with
+// one control byte per slot, which is scanned 16 slots at a time, so most
+// lookups touch one cache line of the table before the entry itself.
+// HASHLIB_PROBED makes hash_probed the default for all containers.
+struct hash_chained { };
+struct hash_probed { };
+
+#ifdef HASHLIB_PROBED
+typedef hash_probed hash_index_default;
+#else
+typedef hash_chained hash_index_default;
+#endif
+
+// The slot table of the hash_probed layout. It maps hashes to entry indices
+// and leaves the comparison of keys to the container.
+class hash_probe_table
+{
+	static const int group_size = 16;
+	static const signed char ctrl_empty = -128;
+	static const signed char ctrl_deleted = -2;
+
+	// The control bytes and slots of a group are stored together, so a
+	// lookup usually touches one cache line of the table. ctrl[i] is
+	// ctrl_empty, ctrl_deleted or 7 bits of the hash of the entry slots[i].
+	struct group_t
+	{
+		signed char ctrl[group_size];
+		int slots[group_size];
+	};
+
+	std::vector<group_t> groups;
+	unsigned int group_mask = 0;
+	int group_shift = 0;
+	int tombstones = 0;
+
+	static inline unsigned int match(const signed char *group, signed char c)
+	{
+#ifdef __SSE2__
+		__m128i g = _mm_loadu_si128((const __m128i*)group);
+		return _mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8(c)));
+#else
+		unsigned int m = 0;
+		for (int i = 0; i < group_size; i++)
+			m |= (unsigned int)(group[i] == c) << i;
+		return m;
+#endif
+	}
+
+	// empty and deleted slots are the ones with the sign bit set
+	static inline unsigned int match_free(const signed char *group)
+	{
+#ifdef __SSE2__
+		return _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+#else
+		unsigned int m = 0;
+		for (int i = 0; i < group_size; i++)
+			m |= (unsigned int)(group[i] < 0) << i;
+		return m;
+#endif
+	}
+
+	static inline int first_bit(unsigned int m)
+	{
+#ifdef __GNUC__
+		return __builtin_ctz(m);
+#else
+		int i = 0;
+		while (!(m & 1))
+			m >>= 1, i++;
+		return i;
+#endif
+	}
+
+	// The hash functions in hashlib are cheap and often leave the low bits
+	// unused (e.g. for pointers), so spread them over all bits before
+	// picking the group (from the top bits) and the control byte.
+	inline void locate(unsigned int hash, unsigned int &group, signed char &tag) const
+	{
+		uint64_t h = uint64_t(hash) * 0x9e3779b97f4a7c15ull;
+		group = (unsigned int)(h >> group_shift) & group_mask;
+		tag = (signed char)((h >> 25) & 0x7f);
+	}
+
+	// Finds the group and position that hold the given entry index
+	void find_slot(unsigned int hash, int index, group_t *&group, int &pos)
+	{
+		unsigned int g;
+		signed char tag;
+		locate(hash, g, tag);
+		for (unsigned int step = 1;; step++) {
+			group = &groups[g];
+			for (unsigned int m = match(group->ctrl, tag); m; m &= m - 1) {
+				pos = first_bit(m);
+				if (group->slots[pos] == index)
+					return;
+			}
+			if (step > group_mask + 1)
+				throw std::runtime_error("hash_probe_table: entry not found.");
+			g = (g + step) & group_mask;
+		}
+	}
+
+public:
+	bool empty() const { return groups.empty(); }
+
+	void clear()
+	{
+		groups.clear();
+		group_mask = 0;
+		tombstones = 0;
+	}
+
+	void swap(hash_probe_table &other)
+	{
+		groups.swap(other.groups);
+		std::swap(group_mask, other.group_mask);
+		std::swap(group_shift, other.group_shift);
+		std::swap(tombstones, other.tombstones);
+	}
+
+	// Empties the table and sizes it for up to `capacity` entries
+	void reset(size_t capacity)
+	{
+		size_t size = group_size;
+		while (size - size / 8 <= capacity)
+			size *= 2;
+		group_t empty_group;
+		for (int i = 0; i < group_size; i++)
+			empty_group.ctrl[i] = ctrl_empty, empty_group.slots[i] = -1;
+		groups.assign(size / group_size, empty_group);
+		group_mask = size / group_size - 1;
+		int bits = 0;
+		while ((group_mask >> bits) != 0)
+			bits++;
+		group_shift = bits ? 64 - bits : 0;
+		tombstones = 0;
+	}
+
+	// Returns true if the table has no room for another entry when it holds
+	// `count` entries, i.e. reset() must be called before the next insert()
+	bool full(size_t count) const
+	{
+		return (count + tombstones) * 8 >= groups.size() * group_size * 7;
+	}
+
+	// Returns the first entry index with the given hash that is_key()
+	// accepts, or -1
+	template<typename F>
+	int find(unsigned int hash, const F &is_key) const
+	{
+		if (groups.empty())
+			return -1;
+
+		unsigned int g;
+		signed char tag;
+		locate(hash, g, tag);
+
+		for (unsigned int step = 1;; step++) {
+			const group_t &group = groups[g];
+			for (unsigned int m = match(group.ctrl, tag); m; m &= m - 1) {
+				int index = group.slots[first_bit(m)];
+				if (is_key(index))
+					return index;
+			}
+			if (match(group.ctrl, ctrl_empty))
+				return -1;
+			g = (g + step) & group_mask;
+		}
+	}
+
+	void insert(unsigned int hash, int index)
+	{
+		unsigned int g;
+		signed char tag;
+		locate(hash, g, tag);
+
+		for (unsigned int step = 1;; step++) {
+			group_t &group = groups[g];
+			unsigned int m = match_free(group.ctrl);
+			if (m) {
+				int pos = first_bit(m);
+				if (group.ctrl[pos] == ctrl_deleted)
+					tombstones--;
+				group.ctrl[pos] = tag;
+				group.slots[pos] = index;
+				return;
+			}
+			g = (g + step) & group_mask;
+		}
+	}
+
+	void erase(unsigned int hash, int index)
+	{
+		group_t *group;
+		int pos;
+		find_slot(hash, index, group, pos);
+		// A lookup only continues past a group without empty slots, so
+		// in a group that still has one the slot can be emptied for good.
+		if (match(group->ctrl, ctrl_empty))
+			group->ctrl[pos] = ctrl_empty;
+		else {
+			group->ctrl[pos] = ctrl_deleted;
+			tombstones++;
+		}
+		group->slots[pos] = -1;
+	}
+
+	// Updates the index of an entry that was moved in the entries vector
+	void move(unsigned int hash, int from, int to)
+	{
+		group_t *group;
+		int pos;
+		find_slot(hash, from, group, pos);
+		group->slots[pos] = to;
+	}
+
+	size_t heap_bytes() const
+	{
+		return groups.capacity() * sizeof(group_t);
+	}
+};
+
+inline size_t hashtable_heap_bytes(const std::vector<int> &hashtable) { return hashtable.capacity() * sizeof(int); }
+inline size_t hashtable_heap_bytes(const hash_probe_table &hashtable) { return hashtable.heap_bytes(); }
+
+template<typename K, typename T, typename OPS = hash_ops<K>, typename INDEX = hash_index_default> class dict;
 template<typename K, int offset = 0, typename OPS = hash_ops<K>> class idict;
-template<typename K, typename OPS = hash_ops<K>> class pool;
+template<typename K, typename OPS = hash_ops<K>, typename INDEX = hash_index_default> class pool;
 template<typename K, typename OPS = hash_ops<K>> class mfp;
 
-template<typename K, typename T, typename OPS>
+template<typename K, typename T, typename OPS, typename INDEX>
 class dict
 {
 	struct entry_t
 	{
 		std::pair<K, T> udata;
+		// next entry in the bucket (hash_chained) or the hash (hash_probed)
 		int next;
 
 		entry_t() { }
@@ -210,7 +557,10 @@ class dict
 		bool operator<(const entry_t &other) const { return udata.first < other.udata.first; }
 	};
 
-	std::vector<int> hashtable;
+	typedef typename std::conditional<std::is_same<INDEX, hash_probed>::value,
+			hash_probe_table, std::vector<int>>::type hashtable_t;
+
+	hashtable_t hashtable;
 	std::vector<entry_t> entries;
 	OPS ops;
 
@@ -222,7 +572,19 @@ class dict
 	}
 #endif
 
-	int do_hash(const K &key) const
+#ifdef HASHLIB_STATS
+	static hash_stats_t &stats() {
+		static hash_stats_t s(typeid(dict).name());
+		return s;
+	}
+	static void count_lookup(int collisions, bool hit) { stats().add_lookup(collisions, hit); }
+	static void count_rehash() { stats().rehashes++; }
+#else
+	static inline void count_lookup(int, bool) { }
+	static inline void count_rehash() { }
+#endif
+
+	int do_hash(const K &key, hash_chained) const
 	{
 		unsigned int hash = 0;
 		if (!hashtable.empty())
@@ -230,8 +592,9 @@ class dict
 		return hash;
 	}
 
-	void do_rehash()
+	void do_rehash(hash_chained)
 	{
+		count_rehash();
 		hashtable.clear();
 		hashtable.resize(hashtable_size(entries.capacity() * hashtable_size_factor), -1);
 
@@ -243,7 +606,7 @@ class dict
 		}
 	}
 
-	int do_erase(int index, int hash)
+	int do_erase(int index, int hash, hash_chained)
 	{
 		do_assert(index < int(entries.size()));
 		if (hashtable.empty() || index < 0)
@@ -292,7 +655,7 @@ class dict
 		return 1;
 	}
 
-	int do_lookup(const K &key, int &hash) const
+	int do_lookup(const K &key, int &hash, hash_chained) const
 	{
 		if (hashtable.empty())
 			return -1;
@@ -303,16 +666,19 @@ class dict
 		}
 
 		int index = hashtable[hash];
+		int collisions = 0;
 
 		while (index >= 0 && !ops.cmp(entries[index].udata.first, key)) {
 			index = entries[index].next;
+			collisions++;
 			do_assert(-1 <= index && index < int(entries.size()));
 		}
 
+		count_lookup(collisions, index >= 0);
 		return index;
 	}
 
-	int do_insert(const K &key, int &hash)
+	int do_insert(const K &key, int &hash, hash_chained)
 	{
 		if (hashtable.empty()) {
 			entries.emplace_back(std::pair<K, T>(key, T()), -1);
@@ -325,7 +691,7 @@ class dict
 		return entries.size() - 1;
 	}
 
-	int do_insert(const std::pair<K, T> &value, int &hash)
+	int do_insert(const std::pair<K, T> &value, int &hash, hash_chained)
 	{
 		if (hashtable.empty()) {
 			entries.emplace_back(value, -1);
@@ -338,7 +704,7 @@ class dict
 		return entries.size() - 1;
 	}
 
-	int do_insert(std::pair<K, T> &&rvalue, int &hash)
+	int do_insert(std::pair<K, T> &&rvalue, int &hash, hash_chained)
 	{
 		if (hashtable.empty()) {
 			auto key = rvalue.first;
@@ -352,6 +718,89 @@ class dict
 		return entries.size() - 1;
 	}
 
+	int do_hash(const K &key, hash_probed) const
+	{
+		return ops.hash(key);
+	}
+
+	void do_rehash(hash_probed)
+	{
+		count_rehash();
+		hashtable.reset(entries.capacity());
+		for (int i = 0; i < int(entries.size()); i++)
+			hashtable.insert(entries[i].next, i);
+	}
+
+	int do_erase(int index, int hash, hash_probed)
+	{
+		do_assert(index < int(entries.size()));
+		if (hashtable.empty() || index < 0)
+			return 0;
+
+		hashtable.erase(hash, index);
+
+		int back_idx = entries.size()-1;
+
+		if (index != back_idx) {
+			hashtable.move(entries[back_idx].next, back_idx, index);
+			entries[index] = std::move(entries[back_idx]);
+		}
+
+		entries.pop_back();
+
+		if (entries.empty())
+			hashtable.clear();
+
+		return 1;
+	}
+
+	int do_lookup(const K &key, int &hash, hash_probed) const
+	{
+		if (hashtable.empty())
+			return -1;
+
+		int compares = 0;
+		int index = hashtable.find(hash, [&](int index) { compares++; return ops.cmp(entries[index].udata.first, key); });
+		count_lookup(index >= 0 ? compares - 1 : compares, index >= 0);
+		return index;
+	}
+
+	int do_insert_probed(int hash)
+	{
+		int index = entries.size() - 1;
+		if (hashtable.full(entries.size()))
+			do_rehash(hash_probed());
+		else
+			hashtable.insert(hash, index);
+		return index;
+	}
+
+	int do_insert(const K &key, int &hash, hash_probed)
+	{
+		entries.emplace_back(std::pair<K, T>(key, T()), hash);
+		return do_insert_probed(hash);
+	}
+
+	int do_insert(const std::pair<K, T> &value, int &hash, hash_probed)
+	{
+		entries.emplace_back(value, hash);
+		return do_insert_probed(hash);
+	}
+
+	int do_insert(std::pair<K, T> &&rvalue, int &hash, hash_probed)
+	{
+		entries.emplace_back(std::forward<std::pair<K, T>>(rvalue), hash);
+		return do_insert_probed(hash);
+	}
+
+	int do_hash(const K &key) const { return do_hash(key, INDEX()); }
+	void do_rehash() { do_rehash(INDEX()); }
+	int do_erase(int index, int hash) { return do_erase(index, hash, INDEX()); }
+	int do_lookup(const K &key, int &hash) const { return do_lookup(key, hash, INDEX()); }
+	int do_insert(const K &key, int &hash) { return do_insert(key, hash, INDEX()); }
+	int do_insert(const std::pair<K, T> &value, int &hash) { return do_insert(value, hash, INDEX()); }
+	int do_insert(std::pair<K, T> &&rvalue, int &hash) { return do_insert(std::forward<std::pair<K, T>>(rvalue), hash, INDEX()); }
+
 public:
 	class const_iterator : public std::iterator<std::forward_iterator_tag, std::pair<K, T>>
 	{
@@ -632,6 +1081,10 @@ public:
 	bool empty() const { return entries.empty(); }
 	void clear() { hashtable.clear(); entries.clear(); }
 
+	// heap memory of the entries and the hash table, not including memory
+	// owned by the keys and values
+	size_t heap_bytes() const { return entries.capacity() * sizeof(entry_t) + hashtable_heap_bytes(hashtable); }
+
 	iterator begin() { return iterator(this, int(entries.size())-1); }
 	iterator element(int n) { return iterator(this, int(entries.size())-1-n); }
 	iterator end() { return iterator(nullptr, -1); }
@@ -641,7 +1094,7 @@ public:
 	const_iterator end() const { return const_iterator(nullptr, -1); }
 };
 
-template<typename K, typename OPS>
+template<typename K, typename OPS, typename INDEX>
 class pool
 {
 	template<typename, int, typename> friend class idict;
@@ -650,6 +1103,7 @@ protected:
 	struct entry_t
 	{
 		K udata;
+		// next entry in the bucket (hash_chained) or the hash (hash_probed)
 		int next;
 
 		entry_t() { }
@@ -657,7 +1111,10 @@ protected:
 		entry_t(K &&udata, int next) : udata(std::move(udata)), next(next) { }
 	};
 
-	std::vector<int> hashtable;
+	typedef typename std::conditional<std::is_same<INDEX, hash_probed>::value,
+			hash_probe_table, std::vector<int>>::type hashtable_t;
+
+	hashtable_t hashtable;
 	std::vector<entry_t> entries;
 	OPS ops;
 
@@ -669,7 +1126,19 @@ protected:
 	}
 #endif
 
-	int do_hash(const K &key) const
+#ifdef HASHLIB_STATS
+	static hash_stats_t &stats() {
+		static hash_stats_t s(typeid(pool).name());
+		return s;
+	}
+	static void count_lookup(int collisions, bool hit) { stats().add_lookup(collisions, hit); }
+	static void count_rehash() { stats().rehashes++; }
+#else
+	static inline void count_lookup(int, bool) { }
+	static inline void count_rehash() { }
+#endif
+
+	int do_hash(const K &key, hash_chained) const
 	{
 		unsigned int hash = 0;
 		if (!hashtable.empty())
@@ -677,8 +1146,9 @@ protected:
 		return hash;
 	}
 
-	void do_rehash()
+	void do_rehash(hash_chained)
 	{
+		count_rehash();
 		hashtable.clear();
 		hashtable.resize(hashtable_size(entries.capacity() * hashtable_size_factor), -1);
 
@@ -690,7 +1160,7 @@ protected:
 		}
 	}
 
-	int do_erase(int index, int hash)
+	int do_erase(int index, int hash, hash_chained)
 	{
 		do_assert(index < int(entries.size()));
 		if (hashtable.empty() || index < 0)
@@ -735,7 +1205,7 @@ protected:
 		return 1;
 	}
 
-	int do_lookup(const K &key, int &hash) const
+	int do_lookup(const K &key, int &hash, hash_chained) const
 	{
 		if (hashtable.empty())
 			return -1;
@@ -746,16 +1216,19 @@ protected:
 		}
 
 		int index = hashtable[hash];
+		int collisions = 0;
 
 		while (index >= 0 && !ops.cmp(entries[index].udata, key)) {
 			index = entries[index].next;
+			collisions++;
 			do_assert(-1 <= index && index < int(entries.size()));
 		}
 
+		count_lookup(collisions, index >= 0);
 		return index;
 	}
 
-	int do_insert(const K &value, int &hash)
+	int do_insert(const K &value, int &hash, hash_chained)
 	{
 		if (hashtable.empty()) {
 			entries.emplace_back(value, -1);
@@ -768,7 +1241,7 @@ protected:
 		return entries.size() - 1;
 	}
 
-	int do_insert(K &&rvalue, int &hash)
+	int do_insert(K &&rvalue, int &hash, hash_chained)
 	{
 		if (hashtable.empty()) {
 			entries.emplace_back(std::forward<K>(rvalue), -1);
@@ -781,6 +1254,82 @@ protected:
 		return entries.size() - 1;
 	}
 
+	int do_hash(const K &key, hash_probed) const
+	{
+		return ops.hash(key);
+	}
+
+	void do_rehash(hash_probed)
+	{
+		count_rehash();
+		hashtable.reset(entries.capacity());
+		for (int i = 0; i < int(entries.size()); i++)
+			hashtable.insert(entries[i].next, i);
+	}
+
+	int do_erase(int index, int hash, hash_probed)
+	{
+		do_assert(index < int(entries.size()));
+		if (hashtable.empty() || index < 0)
+			return 0;
+
+		hashtable.erase(hash, index);
+
+		int back_idx = entries.size()-1;
+
+		if (index != back_idx) {
+			hashtable.move(entries[back_idx].next, back_idx, index);
+			entries[index] = std::move(entries[back_idx]);
+		}
+
+		entries.pop_back();
+
+		if (entries.empty())
+			hashtable.clear();
+
+		return 1;
+	}
+
+	int do_lookup(const K &key, int &hash, hash_probed) const
+	{
+		if (hashtable.empty())
+			return -1;
+
+		int compares = 0;
+		int index = hashtable.find(hash, [&](int index) { compares++; return ops.cmp(entries[index].udata, key); });
+		count_lookup(index >= 0 ? compares - 1 : compares, index >= 0);
+		return index;
+	}
+
+	int do_insert_probed(int hash)
+	{
+		int index = entries.size() - 1;
+		if (hashtable.full(entries.size()))
+			do_rehash(hash_probed());
+		else
+			hashtable.insert(hash, index);
+		return index;
+	}
+
+	int do_insert(const K &value, int &hash, hash_probed)
+	{
+		entries.emplace_back(value, hash);
+		return do_insert_probed(hash);
+	}
+
+	int do_insert(K &&rvalue, int &hash, hash_probed)
+	{
+		entries.emplace_back(std::forward<K>(rvalue), hash);
+		return do_insert_probed(hash);
+	}
+
+	int do_hash(const K &key) const { return do_hash(key, INDEX()); }
+	void do_rehash() { do_rehash(INDEX()); }
+	int do_erase(int index, int hash) { return do_erase(index, hash, INDEX()); }
+	int do_lookup(const K &key, int &hash) const { return do_lookup(key, hash, INDEX()); }
+	int do_insert(const K &value, int &hash) { return do_insert(value, hash, INDEX()); }
+	int do_insert(K &&rvalue, int &hash) { return do_insert(std::forward<K>(rvalue), hash, INDEX()); }
+
 public:
 	class const_iterator : public std::iterator<std::forward_iterator_tag, K>
 	{
@@ -988,6 +1537,10 @@ public:
 	bool empty() const { return entries.empty(); }
 	void clear() { hashtable.clear(); entries.clear(); }
 
+	// heap memory of the entries and the hash table, not including memory
+	// owned by the keys and values
+	size_t heap_bytes() const { return entries.capacity() * sizeof(entry_t) + hashtable_heap_bytes(hashtable); }
+
 	iterator begin() { return iterator(this, int(entries.size())-1); }
 	iterator element(int n) { return iterator(this, int(entries.size())-1-n); }
 	iterator end() { return iterator(nullptr, -1); }
@@ -1075,6 +1628,8 @@ public:
 	bool empty() const { return database.empty(); }
 	void clear() { database.clear(); }
 
+	size_t heap_bytes() const { return database.heap_bytes(); }
+
 	const_iterator begin() const { return const_iterator(*this, offset); }
 	const_iterator element(int n) const { return const_iterator(*this, n); }
 	const_iterator end() const { return const_iterator(*this, offset + size()); }
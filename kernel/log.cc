@@ -61,12 +61,17 @@ void (*log_error_atexit)() = NULL;
 
 int log_make_debug = 0;
 int log_force_debug = 0;
-int log_debug_suppressed = 0;
+YS_THREAD_LOCAL int log_debug_suppressed = 0;
 
 vector<int> header_count;
 vector<char*> log_id_cache;
-vector<shared_str> string_buf;
-int string_buf_index = -1;
+YS_THREAD_LOCAL vector<shared_str> string_buf;
+YS_THREAD_LOCAL int string_buf_index = -1;
+
+#ifdef YOSYS_ENABLE_THREADS
+thread_local LogCapture *log_capture;
+static std::mutex log_id_cache_mutex;
+#endif
 
 static struct timeval initial_tv = { 0, 0 };
 static bool next_print_log = false;
@@ -116,6 +121,13 @@ void logv(const char *format, va_list ap)
 	if (str.empty())
 		return;
 
+#ifdef YOSYS_ENABLE_THREADS
+	if (log_capture) {
+		log_capture->messages.push_back({LogCapture::LOG, std::string(), str});
+		return;
+	}
+#endif
+
 	size_t nnl_pos = str.find_last_not_of('\n');
 	if (nnl_pos == std::string::npos)
 		log_newline_count += GetSize(str);
@@ -237,6 +249,13 @@ static void logv_warning_with_prefix(const char *prefix,
 	std::string message = vstringf(format, ap);
 	bool suppressed = false;
 
+#ifdef YOSYS_ENABLE_THREADS
+	if (log_capture) {
+		log_capture->messages.push_back({LogCapture::WARNING, prefix, message});
+		return;
+	}
+#endif
+
 	for (auto &re : log_nowarn_regexes)
 		if (YS_REGEX_NS::regex_search(message, re))
 			suppressed = true;
@@ -323,6 +342,12 @@ void log_file_info(const std::string &filename, int lineno,
 static void logv_error_with_prefix(const char *prefix,
                                    const char *format, va_list ap)
 {
+#ifdef YOSYS_ENABLE_THREADS
+	if (log_capture) {
+		log_capture->messages.push_back({LogCapture::ERROR, prefix, vstringf(format, ap)});
+		throw log_capture_error_exception();
+	}
+#endif
 #ifdef EMSCRIPTEN
 	auto backup_log_files = log_files;
 #endif
@@ -413,6 +438,13 @@ void log_experimental(const char *format, ...)
 	string s = vstringf(format, ap);
 	va_end(ap);
 
+#ifdef YOSYS_ENABLE_THREADS
+	if (log_capture) {
+		log_capture->messages.push_back({LogCapture::EXPERIMENTAL, std::string(), s});
+		return;
+	}
+#endif
+
 	if (log_experimentals_ignored.count(s) == 0 && log_experimentals.count(s) == 0) {
 		log_warning("Feature '%s' is experimental.\n", s.c_str());
 		log_experimentals.insert(s);
@@ -439,6 +471,13 @@ void log_cmd_error(const char *format, ...)
 	va_list ap;
 	va_start(ap, format);
 
+#ifdef YOSYS_ENABLE_THREADS
+	if (log_capture) {
+		log_capture->messages.push_back({LogCapture::CMD_ERROR, std::string(), vstringf(format, ap)});
+		throw log_capture_error_exception();
+	}
+#endif
+
 	if (log_cmd_error_throw) {
 		log_last_error = vstringf(format, ap);
 		log("ERROR: %s", log_last_error.c_str());
@@ -449,6 +488,68 @@ void log_cmd_error(const char *format, ...)
 	logv_error(format, ap);
 }
 
+#ifdef YOSYS_ENABLE_THREADS
+static void log_warning_with_prefix(const char *prefix, const char *format, ...)
+{
+	va_list ap;
+	va_start(ap, format);
+	logv_warning_with_prefix(prefix, format, ap);
+	va_end(ap);
+}
+
+[[noreturn]]
+static void log_error_with_prefix(const char *prefix, const char *format, ...)
+{
+	va_list ap;
+	va_start(ap, format);
+	logv_error_with_prefix(prefix, format, ap);
+}
+
+void LogCapture::start()
+{
+	log_assert(log_capture == nullptr);
+	log_capture = this;
+	debug_suppressed = log_debug_suppressed;
+	log_debug_suppressed = 0;
+}
+
+void LogCapture::stop()
+{
+	log_assert(log_capture == this);
+	log_capture = nullptr;
+	std::swap(debug_suppressed, log_debug_suppressed);
+}
+
+void LogCapture::replay()
+{
+	for (auto &msg : messages)
+		switch (msg.kind)
+		{
+		case LOG:
+			// keep the trailing newline in the format string for log_time
+			if (msg.text.back() == '\n')
+				log("%s\n", msg.text.substr(0, GetSize(msg.text)-1).c_str());
+			else
+				log("%s", msg.text.c_str());
+			break;
+		case WARNING:
+			log_warning_with_prefix(msg.prefix.c_str(), "%s", msg.text.c_str());
+			break;
+		case EXPERIMENTAL:
+			log_experimental("%s", msg.text.c_str());
+			break;
+		case ERROR:
+			log_error_with_prefix(msg.prefix.c_str(), "%s", msg.text.c_str());
+		case CMD_ERROR:
+			log_cmd_error("%s", msg.text.c_str());
+		}
+	messages.clear();
+
+	log_debug_suppressed += debug_suppressed;
+	debug_suppressed = 0;
+}
+#endif
+
 void log_spacer()
 {
 	if (log_newline_count < 2) log("\n");
@@ -633,8 +734,13 @@ const char *log_const(const RTLIL::Const &value, bool autoint)
 
 const char *log_id(RTLIL::IdString str)
 {
-	log_id_cache.push_back(strdup(str.c_str()));
-	const char *p = log_id_cache.back();
+	const char *p = strdup(str.c_str());
+	{
+#ifdef YOSYS_ENABLE_THREADS
+		std::lock_guard<std::mutex> lock(log_id_cache_mutex);
+#endif
+		log_id_cache.push_back((char*)p);
+	}
 	if (p[0] != '\\')
 		return p;
 	if (p[1] == '$' || p[1] == '\\' || p[1] == 0)
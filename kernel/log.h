@@ -133,7 +133,7 @@ extern void (*log_error_atexit)();
 
 extern int log_make_debug;
 extern int log_force_debug;
-extern int log_debug_suppressed;
+extern YS_THREAD_LOCAL int log_debug_suppressed;
 
 void logv(const char *format, va_list ap);
 void logv_header(RTLIL::Design *design, const char *format, va_list ap);
@@ -193,6 +193,37 @@ struct LogMakeDebugHdl {
 	}
 };
 
+#ifdef YOSYS_ENABLE_THREADS
+// While a worker thread runs part of a pass (see parallel_for_modules() in
+// kernel/threading.h), its log messages, warnings and errors are collected
+// in a LogCapture and written to the log by the main thread afterwards.
+struct LogCapture
+{
+	enum kind_t { LOG, WARNING, EXPERIMENTAL, ERROR, CMD_ERROR };
+
+	struct message_t {
+		kind_t kind;
+		std::string prefix, text;
+	};
+
+	std::vector<message_t> messages;
+	int debug_suppressed = 0;
+
+	// start and stop capturing the messages of the calling thread
+	void start();
+	void stop();
+
+	// write the captured messages to the log, does not return if an
+	// error was captured
+	void replay();
+};
+
+// thrown in a worker thread after an error was captured
+struct log_capture_error_exception { };
+
+extern thread_local LogCapture *log_capture;
+#endif
+
 void log_spacer();
 void log_push();
 void log_pop();
@@ -373,8 +404,8 @@ void log_dump_val_worker(RTLIL::IdString v);
 void log_dump_val_worker(RTLIL::SigSpec v);
 void log_dump_val_worker(RTLIL::State v);
 
-template<typename K, typename T, typename OPS>
-static inline void log_dump_val_worker(dict<K, T, OPS> &v) {
+template<typename K, typename T, typename OPS, typename INDEX>
+static inline void log_dump_val_worker(dict<K, T, OPS, INDEX> &v) {
 	log("{");
 	bool first = true;
 	for (auto &it : v) {
@@ -387,8 +418,8 @@ static inline void log_dump_val_worker(dict<K, T, OPS> &v) {
 	log(" }");
 }
 
-template<typename K, typename OPS>
-static inline void log_dump_val_worker(pool<K, OPS> &v) {
+template<typename K, typename OPS, typename INDEX>
+static inline void log_dump_val_worker(pool<K, OPS, INDEX> &v) {
 	log("{");
 	bool first = true;
 	for (auto &it : v) {
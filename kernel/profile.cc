@@ -0,0 +1,367 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/yosys.h"
+#include "kernel/profile.h"
+
+#include <atomic>
+#include <chrono>
+#include <new>
+
+#if defined(__linux__) || defined(__FreeBSD__) || defined(__APPLE__)
+#  include <sys/resource.h>
+#  include <unistd.h>
+#endif
+
+// Counting replacements for the global operator new and delete. Only the
+// number and the requested size of the allocations are counted, and only
+// while profiling is enabled.
+
+#ifdef YOSYS_ENABLE_PROFILE_ALLOCS
+
+static std::atomic<bool> alloc_counting(false);
+static std::atomic<uint64_t> alloc_count(0), alloc_bytes(0);
+
+static void *counted_malloc(size_t size)
+{
+	if (alloc_counting.load(std::memory_order_relaxed)) {
+		alloc_count.fetch_add(1, std::memory_order_relaxed);
+		alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+	}
+	if (size == 0)
+		size = 1;
+	while (1) {
+		void *p = malloc(size);
+		if (p != nullptr)
+			return p;
+		std::new_handler handler = std::get_new_handler();
+		if (handler == nullptr)
+			throw std::bad_alloc();
+		handler();
+	}
+}
+
+static void *counted_malloc_nothrow(size_t size) noexcept
+{
+	try {
+		return counted_malloc(size);
+	} catch (...) {
+		return nullptr;
+	}
+}
+
+void *operator new(size_t size) { return counted_malloc(size); }
+void *operator new[](size_t size) { return counted_malloc(size); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept { return counted_malloc_nothrow(size); }
+void *operator new[](size_t size, const std::nothrow_t &) noexcept { return counted_malloc_nothrow(size); }
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { free(p); }
+#ifdef __cpp_sized_deallocation
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+#endif
+
+#endif
+
+YOSYS_NAMESPACE_BEGIN
+
+bool profile_enabled = false;
+std::vector<ProfileEntry> profile_entries;
+YS_THREAD_LOCAL int profile_thread = 0;
+
+// the open entries of each thread
+static dict<int, std::vector<int>> profile_stacks;
+static std::chrono::steady_clock::time_point profile_epoch;
+
+#ifdef YOSYS_ENABLE_THREADS
+static std::mutex profile_mutex;
+#  define PROFILE_LOCK std::lock_guard<std::mutex> lock(profile_mutex)
+#else
+#  define PROFILE_LOCK do { } while (0)
+#endif
+
+static int64_t profile_now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - profile_epoch).count();
+}
+
+static void profile_alloc_totals(uint64_t &count, uint64_t &bytes)
+{
+#ifdef YOSYS_ENABLE_PROFILE_ALLOCS
+	count = alloc_count.load(std::memory_order_relaxed);
+	bytes = alloc_bytes.load(std::memory_order_relaxed);
+#else
+	count = 0;
+	bytes = 0;
+#endif
+}
+
+bool profile_alloc_stats()
+{
+#ifdef YOSYS_ENABLE_PROFILE_ALLOCS
+	return true;
+#else
+	return false;
+#endif
+}
+
+int64_t profile_current_rss()
+{
+#if defined(__linux__)
+	FILE *f = fopen("/proc/self/statm", "r");
+	if (f == nullptr)
+		return 0;
+	long size = 0, resident = 0;
+	if (fscanf(f, "%ld %ld", &size, &resident) != 2)
+		resident = 0;
+	fclose(f);
+	return int64_t(resident) * sysconf(_SC_PAGESIZE);
+#else
+	return 0;
+#endif
+}
+
+int64_t profile_peak_rss()
+{
+#if defined(__linux__) || defined(__FreeBSD__) || defined(__APPLE__)
+	struct rusage ru;
+	if (getrusage(RUSAGE_SELF, &ru) != 0)
+		return 0;
+#  ifdef __APPLE__
+	return ru.ru_maxrss;
+#  else
+	return int64_t(ru.ru_maxrss) * 1024;
+#  endif
+#else
+	return 0;
+#endif
+}
+
+void profile_start()
+{
+	PROFILE_LOCK;
+	profile_entries.clear();
+	profile_stacks.clear();
+	profile_epoch = std::chrono::steady_clock::now();
+	profile_enabled = true;
+#ifdef YOSYS_ENABLE_PROFILE_ALLOCS
+	alloc_counting.store(true);
+#endif
+}
+
+void profile_stop()
+{
+	profile_enabled = false;
+#ifdef YOSYS_ENABLE_PROFILE_ALLOCS
+	alloc_counting.store(false);
+#endif
+}
+
+int profile_begin(const std::string &name, const std::string &args, const std::string &category)
+{
+	if (!profile_enabled)
+		return -1;
+
+	PROFILE_LOCK;
+	int index = GetSize(profile_entries);
+	profile_entries.emplace_back();
+	ProfileEntry &e = profile_entries.back();
+
+	e.name = name;
+	e.args = args;
+	e.category = category;
+	e.thread = profile_thread;
+
+	std::vector<int> &stack = profile_stacks[profile_thread];
+	if (!stack.empty())
+		e.parent = stack.back();
+	else if (profile_thread != 0 && !profile_stacks[0].empty())
+		e.parent = profile_stacks[0].back();
+	if (e.parent >= 0)
+		e.depth = profile_entries[e.parent].depth + 1;
+	stack.push_back(index);
+
+	e.rss_begin = profile_current_rss();
+	e.peak_rss_begin = profile_peak_rss();
+	profile_alloc_totals(e.allocs, e.alloc_bytes);
+	e.cpu_ns = PerformanceTimer::query();
+	e.begin_ns = profile_now_ns();
+	return index;
+}
+
+static void profile_close(int index)
+{
+	ProfileEntry &e = profile_entries[index];
+
+	e.time_ns = profile_now_ns() - e.begin_ns;
+	e.cpu_ns = PerformanceTimer::query() - e.cpu_ns;
+	e.rss_end = profile_current_rss();
+	e.peak_rss_end = profile_peak_rss();
+
+	uint64_t allocs, alloc_bytes;
+	profile_alloc_totals(allocs, alloc_bytes);
+	e.allocs = allocs - e.allocs;
+	e.alloc_bytes = alloc_bytes - e.alloc_bytes;
+
+	// the parent already subtracted the totals of the nested entries
+	e.self_ns += e.time_ns;
+	e.self_cpu_ns += e.cpu_ns;
+	e.self_allocs += e.allocs;
+	e.self_alloc_bytes += e.alloc_bytes;
+
+	if (e.parent >= 0 && profile_entries[e.parent].thread == e.thread) {
+		ProfileEntry &p = profile_entries[e.parent];
+		p.self_ns -= e.time_ns;
+		p.self_cpu_ns -= e.cpu_ns;
+		p.self_allocs -= e.allocs;
+		p.self_alloc_bytes -= e.alloc_bytes;
+	}
+}
+
+void profile_end(int index)
+{
+	if (index < 0)
+		return;
+
+	PROFILE_LOCK;
+	std::vector<int> &stack = profile_stacks[profile_thread];
+	if (std::find(stack.begin(), stack.end(), index) == stack.end())
+		return;
+
+	while (1) {
+		int top = stack.back();
+		stack.pop_back();
+		profile_close(top);
+		if (top == index)
+			break;
+	}
+}
+
+static std::string json_string(const std::string &str)
+{
+	std::string s = "\"";
+	for (char c : str) {
+		if (c == '"' || c == '\\')
+			s += std::string("\\") + c;
+		else if ((unsigned char)c < 0x20)
+			s += stringf("\\u%04x", c);
+		else
+			s += c;
+	}
+	return s + "\"";
+}
+
+// Entries that are still open (e.g. the command that writes the profile) are
+// reported as if they ended now.
+static std::vector<ProfileEntry> profile_snapshot(std::vector<bool> &open)
+{
+	PROFILE_LOCK;
+	std::vector<ProfileEntry> entries = profile_entries;
+	open.assign(GetSize(entries), false);
+	int64_t now_ns = profile_now_ns();
+	for (auto &it : profile_stacks)
+		for (int i = GetSize(it.second)-1; i >= 0; i--) {
+			ProfileEntry &e = entries[it.second[i]];
+			open[it.second[i]] = true;
+			e.time_ns = now_ns - e.begin_ns;
+			e.self_ns += e.time_ns;
+			e.rss_end = profile_current_rss();
+			e.peak_rss_end = profile_peak_rss();
+			e.cpu_ns = e.self_cpu_ns = 0;
+			e.allocs = e.alloc_bytes = e.self_allocs = e.self_alloc_bytes = 0;
+			if (e.parent >= 0 && entries[e.parent].thread == e.thread)
+				entries[e.parent].self_ns -= e.time_ns;
+		}
+	return entries;
+}
+
+void profile_write_json(std::ostream &f)
+{
+	std::vector<bool> open;
+	std::vector<ProfileEntry> entries = profile_snapshot(open);
+
+	f << "{\n";
+	f << "  \"creator\": " << json_string(yosys_version_str) << ",\n";
+	f << "  \"alloc_stats\": " << (profile_alloc_stats() ? "true" : "false") << ",\n";
+	f << "  \"invocations\": [";
+	for (int i = 0; i < GetSize(entries); i++) {
+		const ProfileEntry &e = entries[i];
+		f << (i ? ",\n" : "\n");
+		f << "    { \"id\": " << i << ", \"parent\": " << e.parent << ", \"depth\": " << e.depth;
+		f << ", \"thread\": " << e.thread << ", \"category\": " << json_string(e.category);
+		f << ", \"name\": " << json_string(e.name) << ", \"args\": " << json_string(e.args) << ",\n";
+		f << "      \"begin_us\": " << e.begin_ns / 1000 << ", \"time_us\": " << e.time_ns / 1000;
+		f << ", \"self_time_us\": " << e.self_ns / 1000;
+		f << ", \"cpu_us\": " << e.cpu_ns / 1000 << ", \"self_cpu_us\": " << e.self_cpu_ns / 1000 << ",\n";
+		f << "      \"rss_begin\": " << e.rss_begin << ", \"rss_end\": " << e.rss_end;
+		f << ", \"peak_rss_begin\": " << e.peak_rss_begin << ", \"peak_rss_end\": " << e.peak_rss_end;
+		f << ", \"peak_rss_delta\": " << e.peak_rss_delta() << ",\n";
+		f << "      \"allocs\": " << e.allocs << ", \"alloc_bytes\": " << e.alloc_bytes;
+		f << ", \"self_allocs\": " << e.self_allocs << ", \"self_alloc_bytes\": " << e.self_alloc_bytes;
+		f << (open[i] ? ", \"open\": true" : "") << " }";
+	}
+	f << "\n  ]\n";
+	f << "}\n";
+}
+
+// Chrome trace event format, for chrome://tracing or https://ui.perfetto.dev.
+// The entries are complete events on the track of their thread, the RSS is a
+// counter track.
+void profile_write_trace(std::ostream &f)
+{
+	std::vector<bool> open;
+	std::vector<ProfileEntry> entries = profile_snapshot(open);
+
+	pool<int> threads;
+	threads.insert(0);
+	for (auto &e : entries)
+		threads.insert(e.thread);
+	threads.sort();
+
+	f << "{ \"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+	f << "  { \"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": { \"name\": \"yosys\" } }";
+	for (int thread : threads) {
+		f << ",\n  { \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << thread+1;
+		f << ", \"args\": { \"name\": " << json_string(thread ? stringf("worker %d", thread) : "main") << " } }";
+	}
+	for (auto &e : entries) {
+		f << ",\n  { \"name\": " << json_string(e.name) << ", \"cat\": " << json_string(e.category);
+		f << ", \"ph\": \"X\", \"pid\": 1, \"tid\": " << e.thread+1;
+		f << stringf(", \"ts\": %.3f, \"dur\": %.3f", e.begin_ns / 1000.0, e.time_ns / 1000.0);
+		f << ", \"args\": { \"command\": " << json_string(e.args);
+		f << ", \"self_time_ms\": " << stringf("%.3f", e.self_ns / 1000000.0);
+		f << ", \"peak_rss_delta\": " << e.peak_rss_delta();
+		f << ", \"allocs\": " << e.allocs << ", \"alloc_bytes\": " << e.alloc_bytes;
+		f << ", \"self_allocs\": " << e.self_allocs << ", \"self_alloc_bytes\": " << e.self_alloc_bytes << " } }";
+	}
+	for (auto &e : entries) {
+		if (e.rss_begin == 0 || e.thread != 0)
+			continue;
+		f << ",\n  { \"name\": \"memory\", \"ph\": \"C\", \"pid\": 1" << stringf(", \"ts\": %.3f", e.begin_ns / 1000.0);
+		f << stringf(", \"args\": { \"rss_mb\": %.3f } }", e.rss_begin / 1048576.0);
+		f << ",\n  { \"name\": \"memory\", \"ph\": \"C\", \"pid\": 1" << stringf(", \"ts\": %.3f", (e.begin_ns + e.time_ns) / 1000.0);
+		f << stringf(", \"args\": { \"rss_mb\": %.3f } }", e.rss_end / 1048576.0);
+	}
+	f << "\n] }\n";
+}
+
+YOSYS_NAMESPACE_END
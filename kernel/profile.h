@@ -0,0 +1,106 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "kernel/yosys.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// One invocation of a command, recorded by Pass::pre_execute() and
+// Pass::post_execute() while profiling is enabled (see 'help profile'), or
+// a phase of a command recorded with ProfileScope.
+//
+// The totals include the nested entries, the self_* values only what was
+// spent in the entry itself. Memory sizes are in bytes. peak_rss_* is the
+// high-water mark of the process, so peak_rss_end - peak_rss_begin is how
+// much the command raised the peak. Values that are not available on the
+// host are 0.
+//
+// Entries recorded on a worker thread have the entry that was open on the
+// main thread as parent, but are not subtracted from its self_* values. The
+// CPU time, RSS and allocations are always those of the whole process.
+struct ProfileEntry
+{
+	// category is "pass" for commands, "exec" for external programs,
+	// "worker" for the tasks of parallel_for() and "phase" otherwise
+	std::string name, args, category;
+	int parent = -1, depth = 0, thread = 0;
+
+	// wall clock time since the start of the profile, and CPU time
+	int64_t begin_ns = 0, time_ns = -1, self_ns = 0;
+	int64_t cpu_ns = 0, self_cpu_ns = 0;
+
+	int64_t rss_begin = 0, rss_end = 0;
+	int64_t peak_rss_begin = 0, peak_rss_end = 0;
+
+	// number and size of operator new calls (YOSYS_ENABLE_PROFILE_ALLOCS)
+	uint64_t allocs = 0, alloc_bytes = 0;
+	uint64_t self_allocs = 0, self_alloc_bytes = 0;
+
+	bool done() const { return time_ns >= 0; }
+	int64_t peak_rss_delta() const { return peak_rss_end - peak_rss_begin; }
+};
+
+extern bool profile_enabled;
+extern std::vector<ProfileEntry> profile_entries;
+
+// The trace track of the calling thread: 0 for the main thread, or i+1 for
+// the i-th thread started by parallel_for() and parallel_for_modules().
+extern YS_THREAD_LOCAL int profile_thread;
+
+// Start recording (clears the previous profile) or stop recording.
+void profile_start();
+void profile_stop();
+
+// Open an entry and return its index, or -1 if profiling is disabled.
+// profile_end() also closes the nested entries of the same thread that were
+// left open, e.g. by a command that was aborted with log_cmd_error(). Both
+// can be called from any thread.
+int profile_begin(const std::string &name, const std::string &args = std::string(),
+		const std::string &category = "pass");
+void profile_end(int index);
+
+// Records the lifetime of the object as an entry, e.g. for running an
+// external program or the SAT solver.
+struct ProfileScope
+{
+	int index;
+
+	ProfileScope(const std::string &name, const std::string &args = std::string(), const std::string &category = "phase") :
+			index(profile_begin(name, args, category)) { }
+	~ProfileScope() { profile_end(index); }
+
+	ProfileScope(const ProfileScope &) = delete;
+	ProfileScope &operator=(const ProfileScope &) = delete;
+};
+
+// Returns false if this build does not count allocations.
+bool profile_alloc_stats();
+
+int64_t profile_current_rss();
+int64_t profile_peak_rss();
+
+void profile_write_json(std::ostream &f);
+void profile_write_trace(std::ostream &f);
+
+YOSYS_NAMESPACE_END
+
+#endif
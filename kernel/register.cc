@@ -19,6 +19,11 @@
 
 #include "kernel/yosys.h"
 #include "kernel/satgen.h"
+#include "kernel/profile.h"
+#include "libs/ezsat/ezcmdline.h"
+#ifdef YOSYS_ENABLE_IPASIR
+#  include "libs/ezsat/ezipasir.h"
+#endif
 
 #include <string.h>
 #include <stdlib.h>
@@ -147,11 +152,22 @@ Pass::~Pass()
 {
 }
 
-Pass::pre_post_exec_state_t Pass::pre_execute()
+Pass::pre_post_exec_state_t Pass::pre_execute(const std::vector<std::string> &args)
 {
 	pre_post_exec_state_t state;
 	call_counter++;
 	state.begin_ns = PerformanceTimer::query();
+	state.profile_index = -1;
+	// frontends and backends called by Pass::call() run pre_execute() again
+	if (profile_enabled && current_pass != this) {
+		std::string command = args.empty() ? pass_name : args[0];
+		for (size_t i = 1; i < args.size(); i++)
+			command += " " + args[i];
+		state.profile_index = profile_begin(pass_name, command);
+	}
+#ifdef HASHLIB_STATS
+	hashlib::hash_stats_t::totals(state.begin_hash_lookups, state.begin_hash_collisions);
+#endif
 	state.parent_pass = current_pass;
 	current_pass = this;
 	clear_flags();
@@ -168,6 +184,21 @@ void Pass::post_execute(Pass::pre_post_exec_state_t state)
 	current_pass = state.parent_pass;
 	if (current_pass)
 		current_pass->runtime_ns -= time_ns;
+
+	profile_end(state.profile_index);
+
+#ifdef HASHLIB_STATS
+	uint64_t lookups, collisions;
+	hashlib::hash_stats_t::totals(lookups, collisions);
+	lookups -= state.begin_hash_lookups;
+	collisions -= state.begin_hash_collisions;
+	hash_lookups += lookups;
+	hash_collisions += collisions;
+	if (current_pass) {
+		current_pass->hash_lookups -= lookups;
+		current_pass->hash_collisions -= collisions;
+	}
+#endif
 }
 
 void Pass::help()
@@ -312,7 +343,7 @@ void Pass::call(RTLIL::Design *design, std::vector<std::string> args)
 		log_experimental("%s", args[0].c_str());
 
 	size_t orig_sel_stack_pos = design->selection_stack.size();
-	auto state = pass_register[args[0]]->pre_execute();
+	auto state = pass_register[args[0]]->pre_execute(args);
 	pass_register[args[0]]->execute(args, design);
 	pass_register[args[0]]->post_execute(state);
 	while (design->selection_stack.size() > orig_sel_stack_pos)
@@ -387,6 +418,8 @@ bool ScriptPass::check_label(std::string label, std::string info)
 			if (label == active_run_to)
 				block_active = false;
 		}
+		profile_end(profile_label);
+		profile_label = block_active ? profile_begin(label, pass_name, "phase") : -1;
 		return block_active;
 	}
 }
@@ -423,7 +456,10 @@ void ScriptPass::run_script(RTLIL::Design *design, std::string run_from, std::st
 	block_active = run_from.empty();
 	active_run_from = run_from;
 	active_run_to = run_to;
+	profile_label = -1;
 	script();
+	profile_end(profile_label);
+	profile_label = -1;
 }
 
 void ScriptPass::help_script()
@@ -462,7 +498,7 @@ void Frontend::execute(std::vector<std::string> args, RTLIL::Design *design)
 	do {
 		std::istream *f = NULL;
 		next_args.clear();
-		auto state = pre_execute();
+		auto state = pre_execute(args);
 		execute(f, std::string(), args, design);
 		post_execute(state);
 		args = next_args;
@@ -603,12 +639,12 @@ void Frontend::frontend_call(RTLIL::Design *design, std::istream *f, std::string
 		log_cmd_error("No such frontend: %s\n", args[0].c_str());
 
 	if (f != NULL) {
-		auto state = frontend_register[args[0]]->pre_execute();
+		auto state = frontend_register[args[0]]->pre_execute(args);
 		frontend_register[args[0]]->execute(f, filename, args, design);
 		frontend_register[args[0]]->post_execute(state);
 	} else if (filename == "-") {
 		std::istream *f_cin = &std::cin;
-		auto state = frontend_register[args[0]]->pre_execute();
+		auto state = frontend_register[args[0]]->pre_execute(args);
 		frontend_register[args[0]]->execute(f_cin, "<stdin>", args, design);
 		frontend_register[args[0]]->post_execute(state);
 	} else {
@@ -640,7 +676,7 @@ Backend::~Backend()
 void Backend::execute(std::vector<std::string> args, RTLIL::Design *design)
 {
 	std::ostream *f = NULL;
-	auto state = pre_execute();
+	auto state = pre_execute(args);
 	execute(f, std::string(), args, design);
 	post_execute(state);
 	if (f != &std::cout)
@@ -723,12 +759,12 @@ void Backend::backend_call(RTLIL::Design *design, std::ostream *f, std::string f
 	size_t orig_sel_stack_pos = design->selection_stack.size();
 
 	if (f != NULL) {
-		auto state = backend_register[args[0]]->pre_execute();
+		auto state = backend_register[args[0]]->pre_execute(args);
 		backend_register[args[0]]->execute(f, filename, args, design);
 		backend_register[args[0]]->post_execute(state);
 	} else if (filename == "-") {
 		std::ostream *f_cout = &std::cout;
-		auto state = backend_register[args[0]]->pre_execute();
+		auto state = backend_register[args[0]]->pre_execute(args);
 		backend_register[args[0]]->execute(f_cout, "<stdout>", args, design);
 		backend_register[args[0]]->post_execute(state);
 	} else {
@@ -969,4 +1005,60 @@ struct MinisatSatSolver : public SatSolver {
 	}
 } MinisatSatSolver;
 
+#ifdef YOSYS_ENABLE_IPASIR
+struct IpasirSatSolver : public SatSolver {
+	IpasirSatSolver() : SatSolver("ipasir") { }
+	ezSAT *create() override {
+		return new ezIpasirSAT();
+	}
+} IpasirSatSolver;
+#endif
+
+#if !defined(YOSYS_DISABLE_SPAWN)
+struct CmdlineSatSolver : public SatSolver {
+	std::string command;
+	CmdlineSatSolver(std::string command) : SatSolver("cmdline:" + command), command(command) { }
+	ezSAT *create() override {
+		return new ezCmdlineSAT(command);
+	}
+};
+#endif
+
+SatSolverScope::SatSolverScope(const std::string &name) : prev_solver(yosys_satsolver)
+{
+	if (name.empty())
+		return;
+
+#if !defined(YOSYS_DISABLE_SPAWN)
+	if (name.compare(0, 8, "cmdline:") == 0) {
+		if (name.size() == 8)
+			log_cmd_error("Missing command for SAT solver `cmdline:<command>'.\n");
+		cmdline_solver.reset(new CmdlineSatSolver(name.substr(8)));
+		yosys_satsolver = cmdline_solver.get();
+		log("Using SAT solver command `%s'.\n", name.c_str() + 8);
+		return;
+	}
+#endif
+
+	for (auto solver = yosys_satsolver_list; solver != nullptr; solver = solver->next)
+		if (solver->name == name) {
+			yosys_satsolver = solver;
+			return;
+		}
+
+	std::string available;
+	for (auto solver = yosys_satsolver_list; solver != nullptr; solver = solver->next)
+		if (solver->name.compare(0, 8, "cmdline:") != 0)
+			available += " " + solver->name;
+#if !defined(YOSYS_DISABLE_SPAWN)
+	available += " cmdline:<command>";
+#endif
+	log_cmd_error("Unknown SAT solver `%s'. Available solvers:%s\n", name.c_str(), available.c_str());
+}
+
+SatSolverScope::~SatSolverScope()
+{
+	yosys_satsolver = prev_solver;
+}
+
 YOSYS_NAMESPACE_END
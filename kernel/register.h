@@ -37,6 +37,10 @@ struct Pass
 	int call_counter;
 	int64_t runtime_ns;
 	bool experimental_flag = false;
+#ifdef HASHLIB_STATS
+	// dict<> and pool<> lookups during this pass, see hashlib::hash_stats_t
+	uint64_t hash_lookups = 0, hash_collisions = 0;
+#endif
 
 	void experimental() {
 		experimental_flag = true;
@@ -45,9 +49,13 @@ struct Pass
 	struct pre_post_exec_state_t {
 		Pass *parent_pass;
 		int64_t begin_ns;
+		int profile_index;
+#ifdef HASHLIB_STATS
+		uint64_t begin_hash_lookups, begin_hash_collisions;
+#endif
 	};
 
-	pre_post_exec_state_t pre_execute();
+	pre_post_exec_state_t pre_execute(const std::vector<std::string> &args = std::vector<std::string>());
 	void post_execute(pre_post_exec_state_t state);
 
 	void cmd_log_args(const std::vector<std::string> &args);
@@ -77,6 +85,7 @@ struct ScriptPass : Pass
 	bool block_active, help_mode;
 	RTLIL::Design *active_design;
 	std::string active_run_from, active_run_to;
+	int profile_label = -1;
 
 	ScriptPass(std::string name, std::string short_help = "** document me **") : Pass(name, short_help) { }
 
@@ -20,6 +20,7 @@
 #include "kernel/yosys.h"
 #include "kernel/macc.h"
 #include "kernel/celltypes.h"
+#include "kernel/sigtools.h"
 #include "frontends/verilog/verilog_frontend.h"
 #include "frontends/verilog/preproc.h"
 #include "backends/rtlil/rtlil_backend.h"
@@ -30,17 +31,54 @@
 YOSYS_NAMESPACE_BEGIN
 
 RTLIL::IdString::destruct_guard_t RTLIL::IdString::destruct_guard;
-std::vector<char*> RTLIL::IdString::global_id_storage_;
-dict<char*, int, hash_cstr_ops> RTLIL::IdString::global_id_index_;
-#ifndef YOSYS_NO_IDS_REFCNT
-std::vector<int> RTLIL::IdString::global_refcount_storage_;
-std::vector<int> RTLIL::IdString::global_free_idx_list_;
+RTLIL::IdString::storage_chunk_t *RTLIL::IdString::global_id_chunks_[RTLIL::IdString::id_max_chunks];
+RTLIL::IdString::storage_shard_t RTLIL::IdString::global_id_shards_[RTLIL::IdString::id_shards];
+int RTLIL::IdString::global_id_count_;
+#ifdef YOSYS_ENABLE_THREADS
+std::mutex RTLIL::IdString::global_id_alloc_mutex_;
 #endif
 #ifdef YOSYS_USE_STICKY_IDS
 int RTLIL::IdString::last_created_idx_[8];
 int RTLIL::IdString::last_created_idx_ptr_;
 #endif
 
+int RTLIL::IdString::new_storage_index(int shard)
+{
+#ifndef YOSYS_NO_IDS_REFCNT
+	std::vector<int> &free_idx_list = global_id_shards_[shard].free_idx_list;
+	if (!free_idx_list.empty()) {
+		int idx = free_idx_list.back();
+		free_idx_list.pop_back();
+		return idx;
+	}
+#endif
+
+#ifdef YOSYS_ENABLE_THREADS
+	std::lock_guard<std::mutex> lock(global_id_alloc_mutex_);
+#endif
+
+	log_assert(global_id_count_ < 0x40000000);
+
+	if ((global_id_count_ & (id_chunk_size-1)) == 0) {
+		// new chunks are zero-initialized (null strings, zero reference counts)
+		// and are never freed
+		global_id_chunks_[global_id_count_ >> id_chunk_bits] = new storage_chunk_t();
+		if (global_id_count_ == 0) {
+			// index 0 is the empty string, it is never looked up by name
+			global_id_storage(0) = (char*)"";
+			global_id_count_++;
+		}
+	}
+
+	int idx = global_id_count_++;
+#ifdef YOSYS_ENABLE_THREADS
+	global_id_chunks_[idx >> id_chunk_bits]->shards[idx & (id_chunk_size-1)] = shard;
+#else
+	(void)shard;
+#endif
+	return idx;
+}
+
 #define X(_id) IdString RTLIL::ID::_id;
 #include "kernel/constids.inc"
 #undef X
@@ -192,6 +230,7 @@ RTLIL::Const::Const()
 RTLIL::Const::Const(std::string str)
 {
 	flags = RTLIL::CONST_FLAG_STRING;
+	bits.reserve(str.size() * 8);
 	for (int i = str.size()-1; i >= 0; i--) {
 		unsigned char ch = str[i];
 		for (int j = 0; j < 8; j++) {
@@ -204,31 +243,29 @@ RTLIL::Const::Const(std::string str)
 RTLIL::Const::Const(int val, int width)
 {
 	flags = RTLIL::CONST_FLAG_NONE;
+	bits.reserve(width);
 	for (int i = 0; i < width; i++) {
 		bits.push_back((val & 1) != 0 ? State::S1 : State::S0);
 		val = val >> 1;
 	}
 }
 
-RTLIL::Const::Const(RTLIL::State bit, int width)
+RTLIL::Const::Const(RTLIL::State bit, int width) : bits(max(width, 0), bit)
 {
 	flags = RTLIL::CONST_FLAG_NONE;
-	for (int i = 0; i < width; i++)
-		bits.push_back(bit);
 }
 
 RTLIL::Const::Const(const std::vector<bool> &bits)
 {
 	flags = RTLIL::CONST_FLAG_NONE;
+	this->bits.reserve(bits.size());
 	for (const auto &b : bits)
 		this->bits.emplace_back(b ? State::S1 : State::S0);
 }
 
-RTLIL::Const::Const(const RTLIL::Const &c)
+RTLIL::Const::Const(const RTLIL::Const &c) : bits(c.bits)
 {
 	flags = c.flags;
-	for (const auto &b : c.bits)
-		this->bits.push_back(b);
 }
 
 bool RTLIL::Const::operator <(const RTLIL::Const &other) const
@@ -363,6 +400,123 @@ bool RTLIL::Const::is_fully_undef() const
 	return true;
 }
 
+// Helpers for converting between RTLIL::State vectors and PackedConst planes
+// eight bits at a time: gather_bits() collects the lowest bit of each byte
+// into an 8 bit value, spread_bits() is the inverse operation.
+
+static inline uint64_t load_states(const RTLIL::State *p)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	uint64_t x;
+	memcpy(&x, p, 8);
+	return x;
+#else
+	uint64_t x = 0;
+	for (int i = 0; i < 8; i++)
+		x |= uint64_t(p[i]) << (8*i);
+	return x;
+#endif
+}
+
+static inline void store_states(RTLIL::State *p, uint64_t x)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	memcpy(p, &x, 8);
+#else
+	for (int i = 0; i < 8; i++)
+		p[i] = RTLIL::State((x >> (8*i)) & 0xff);
+#endif
+}
+
+static inline uint64_t gather_bits(uint64_t x)
+{
+	return ((x & 0x0101010101010101ULL) * 0x0102040810204080ULL) >> 56;
+}
+
+static inline uint64_t spread_bits(uint64_t m)
+{
+	return (((m & 0x7f) * 0x0002040810204081ULL) & 0x0101010101010101ULL) | ((m & 0x80) << 49);
+}
+
+RTLIL::PackedConst::PackedConst(const RTLIL::Const &c, int width, bool is_signed)
+{
+	int src_width = GetSize(c.bits);
+	this->width = width < 0 ? src_width : width;
+
+	int nwords = num_words(this->width);
+	val.resize(nwords);
+
+	RTLIL::State padding = is_signed && src_width > 0 ? c.bits.back() : RTLIL::State::S0;
+	const RTLIL::State *src = c.bits.data();
+
+	for (int w = 0; w < nwords; w++)
+	{
+		int base = w * 64, n = min(64, this->width - base);
+		uint64_t v = 0, u = 0;
+		int b = 0;
+
+		// fast path: 8 bits at a time, as long as all are S0, S1, Sx or Sz
+		for (; b + 8 <= n && base + b + 8 <= src_width; b += 8) {
+			uint64_t x = load_states(src + base + b);
+			if (x & 0xfcfcfcfcfcfcfcfcULL)
+				break;
+			v |= gather_bits(x) << b;
+			u |= gather_bits(x >> 1) << b;
+		}
+
+		for (; b < n; b++) {
+			RTLIL::State s = base + b < src_width ? src[base + b] : padding;
+			if (s > RTLIL::State::Sz)
+				s = RTLIL::State::Sx;
+			v |= uint64_t(s & 1) << b;
+			u |= uint64_t(s >> 1) << b;
+		}
+
+		val[w] = v;
+		if (u != 0) {
+			if (undef.empty())
+				undef.resize(nwords);
+			undef[w] = u;
+		}
+	}
+}
+
+void RTLIL::PackedConst::normalize()
+{
+	if (!val.empty()) {
+		val.back() &= top_mask();
+		if (!undef.empty())
+			undef.back() &= top_mask();
+	}
+
+	for (auto u : undef)
+		if (u != 0)
+			return;
+	undef.clear();
+}
+
+RTLIL::Const RTLIL::PackedConst::as_const() const
+{
+	RTLIL::Const c;
+	c.bits.resize(width);
+	RTLIL::State *dst = c.bits.data();
+
+	for (int w = 0; w < words(); w++)
+	{
+		int base = w * 64, n = min(64, width - base);
+		uint64_t v = val[w], u = undef_word(w);
+		int b = 0;
+
+		for (; b + 8 <= n; b += 8)
+			store_states(dst + base + b, spread_bits((v >> b) & 0xff) | spread_bits((u >> b) & 0xff) << 1);
+
+		for (; b < n; b++)
+			dst[base + b] = RTLIL::State(((v >> b) & 1) | ((u >> b) & 1) << 1);
+	}
+
+	return c;
+}
+
 bool RTLIL::AttrObject::has_attribute(RTLIL::IdString id) const
 {
 	return attributes.count(id);
@@ -537,11 +691,11 @@ void RTLIL::Selection::optimize(RTLIL::Design *design)
 RTLIL::Design::Design()
   : verilog_defines (new define_map_t)
 {
-	static unsigned int hashidx_count = 123456789;
-	hashidx_count = mkhash_xorshift(hashidx_count);
-	hashidx_ = hashidx_count;
+	static hashidx_sequence_t hashidx_sequence;
+	hashidx_ = hashidx_sequence.next();
 
 	refcount_modules_ = 0;
+	readonly_scopes_ = 0;
 	selection_stack.push_back(RTLIL::Selection());
 
 #ifdef WITH_PYTHON
@@ -549,10 +703,28 @@ RTLIL::Design::Design()
 #endif
 }
 
+// Removes the design from the designs that hold the module and deletes the
+// module if no other design shares it.
+static void release_module(RTLIL::Design *design, RTLIL::Module *module)
+{
+	std::vector<RTLIL::Design*> &shared = module->shared_designs_;
+	if (shared.empty()) {
+		log_assert(module->design == design);
+		delete module;
+	} else if (module->design == design) {
+		module->design = shared.back();
+		shared.pop_back();
+	} else {
+		auto it = std::find(shared.begin(), shared.end(), design);
+		log_assert(it != shared.end());
+		shared.erase(it);
+	}
+}
+
 RTLIL::Design::~Design()
 {
 	for (auto it = modules_.begin(); it != modules_.end(); ++it)
-		delete it->second;
+		release_module(this, it->second);
 	for (auto n : verilog_packages)
 		delete n;
 	for (auto n : verilog_globals)
@@ -572,12 +744,17 @@ std::map<unsigned int, RTLIL::Design*> *RTLIL::Design::get_all_designs(void)
 
 RTLIL::ObjRange<RTLIL::Module*> RTLIL::Design::modules()
 {
+	unshare_modules();
 	return RTLIL::ObjRange<RTLIL::Module*>(&modules_, &refcount_modules_);
 }
 
 RTLIL::Module *RTLIL::Design::module(RTLIL::IdString name)
 {
-	return modules_.count(name) ? modules_.at(name) : NULL;
+	auto it = modules_.find(name);
+	if (it == modules_.end())
+		return NULL;
+	it->second->unshare(this);
+	return it->second;
 }
 
 RTLIL::Module *RTLIL::Design::top_module()
@@ -599,6 +776,7 @@ void RTLIL::Design::add(RTLIL::Module *module)
 {
 	log_assert(modules_.count(module->name) == 0);
 	log_assert(refcount_modules_ == 0);
+	log_assert(module->shared_designs_.empty());
 	modules_[module->name] = module;
 	module->design = this;
 
@@ -611,6 +789,29 @@ void RTLIL::Design::add(RTLIL::Module *module)
 	}
 }
 
+void RTLIL::Design::share(RTLIL::Module *module)
+{
+	log_assert(modules_.count(module->name) == 0);
+	log_assert(refcount_modules_ == 0);
+	log_assert(module->design != nullptr && module->design != this);
+	modules_[module->name] = module;
+	module->shared_designs_.push_back(this);
+
+	for (auto mon : monitors)
+		mon->notify_module_add(module);
+
+	if (yosys_xtrace) {
+		log("#X# Shared Module: %s\n", log_id(module));
+		log_backtrace("-X- ", yosys_xtrace-1);
+	}
+}
+
+void RTLIL::Design::unshare_modules() const
+{
+	for (auto &it : modules_)
+		it.second->unshare(this);
+}
+
 RTLIL::Module *RTLIL::Design::addModule(RTLIL::IdString name)
 {
 	log_assert(modules_.count(name) == 0);
@@ -710,11 +911,12 @@ void RTLIL::Design::remove(RTLIL::Module *module)
 	log_assert(modules_.at(module->name) == module);
 	log_assert(refcount_modules_ == 0);
 	modules_.erase(module->name);
-	delete module;
+	release_module(this, module);
 }
 
 void RTLIL::Design::rename(RTLIL::Module *module, RTLIL::IdString new_name)
 {
+	module->unshare(this);
 	modules_.erase(module->name);
 	module->name = new_name;
 	add(module);
@@ -722,6 +924,7 @@ void RTLIL::Design::rename(RTLIL::Module *module, RTLIL::IdString new_name)
 
 void RTLIL::Design::sort()
 {
+	unshare_modules();
 	scratchpad.sort();
 	modules_.sort(sort_by_id_str());
 	for (auto &it : modules_)
@@ -732,7 +935,8 @@ void RTLIL::Design::check()
 {
 #ifndef NDEBUG
 	for (auto &it : modules_) {
-		log_assert(this == it.second->design);
+		const std::vector<RTLIL::Design*> &shared = it.second->shared_designs_;
+		log_assert(this == it.second->design || std::count(shared.begin(), shared.end(), this) == 1);
 		log_assert(it.first == it.second->name);
 		log_assert(!it.first.empty());
 		it.second->check();
@@ -742,6 +946,7 @@ void RTLIL::Design::check()
 
 void RTLIL::Design::optimize()
 {
+	unshare_modules();
 	for (auto &it : modules_)
 		it.second->optimize();
 	for (auto &it : selection_stack)
@@ -792,8 +997,10 @@ std::vector<RTLIL::Module*> RTLIL::Design::selected_modules() const
 	std::vector<RTLIL::Module*> result;
 	result.reserve(modules_.size());
 	for (auto &it : modules_)
-		if (selected_module(it.first) && !it.second->get_blackbox_attribute())
+		if (selected_module(it.first) && !it.second->get_blackbox_attribute()) {
+			it.second->unshare(this);
 			result.push_back(it.second);
+		}
 	return result;
 }
 
@@ -802,8 +1009,10 @@ std::vector<RTLIL::Module*> RTLIL::Design::selected_whole_modules() const
 	std::vector<RTLIL::Module*> result;
 	result.reserve(modules_.size());
 	for (auto &it : modules_)
-		if (selected_whole_module(it.first) && !it.second->get_blackbox_attribute())
+		if (selected_whole_module(it.first) && !it.second->get_blackbox_attribute()) {
+			it.second->unshare(this);
 			result.push_back(it.second);
+		}
 	return result;
 }
 
@@ -814,20 +1023,21 @@ std::vector<RTLIL::Module*> RTLIL::Design::selected_whole_modules_warn() const
 	for (auto &it : modules_)
 		if (it.second->get_blackbox_attribute())
 			continue;
-		else if (selected_whole_module(it.first))
+		else if (selected_whole_module(it.first)) {
+			it.second->unshare(this);
 			result.push_back(it.second);
-		else if (selected_module(it.first))
+		} else if (selected_module(it.first))
 			log_warning("Ignoring partially selected module %s.\n", log_id(it.first));
 	return result;
 }
 
 RTLIL::Module::Module()
 {
-	static unsigned int hashidx_count = 123456789;
-	hashidx_count = mkhash_xorshift(hashidx_count);
-	hashidx_ = hashidx_count;
+	static hashidx_sequence_t hashidx_sequence;
+	hashidx_ = hashidx_sequence.next();
 
 	design = nullptr;
+	sigmap_ = nullptr;
 	refcount_wires_ = 0;
 	refcount_cells_ = 0;
 
@@ -838,12 +1048,15 @@ RTLIL::Module::Module()
 
 RTLIL::Module::~Module()
 {
+	log_assert(shared_designs_.empty());
+	delete sigmap_;
+	// the slabs of wire_arena_ and cell_arena_ are freed all at once afterwards
 	for (auto it = wires_.begin(); it != wires_.end(); ++it)
-		delete it->second;
+		destroy(it->second);
 	for (auto it = memories.begin(); it != memories.end(); ++it)
 		delete it->second;
 	for (auto it = cells_.begin(); it != cells_.end(); ++it)
-		delete it->second;
+		destroy(it->second);
 	for (auto it = processes.begin(); it != processes.end(); ++it)
 		delete it->second;
 #ifdef WITH_PYTHON
@@ -872,7 +1085,7 @@ void RTLIL::Module::makeblackbox()
 	memories.clear();
 
 	for (auto it = cells_.begin(); it != cells_.end(); ++it)
-		delete it->second;
+		destroy(it->second);
 	cells_.clear();
 
 	for (auto it = processes.begin(); it != processes.end(); ++it)
@@ -881,6 +1094,13 @@ void RTLIL::Module::makeblackbox()
 
 	connections_.clear();
 
+	for (auto mon : monitors)
+		mon->notify_blackout(this);
+
+	if (design)
+		for (auto mon : design->monitors)
+			mon->notify_blackout(this);
+
 	remove(delwires);
 	set_bool_attribute(ID::blackbox);
 }
@@ -1731,7 +1951,8 @@ void RTLIL::Module::cloneInto(RTLIL::Module *new_mod) const
 		void operator()(RTLIL::SigSpec &sig)
 		{
 			sig.pack();
-			for (auto &c : sig.chunks_)
+			sig.detach();
+			for (auto &c : sig.data_->chunks)
 				if (c.wire != NULL)
 					c.wire = mod->wires_.at(c.wire->name);
 		}
@@ -1751,6 +1972,35 @@ RTLIL::Module *RTLIL::Module::clone() const
 	return new_mod;
 }
 
+void RTLIL::Module::unshare(const RTLIL::Design *keeper)
+{
+	if (shared_designs_.empty() || keeper->readonly_scopes_ > 0)
+		return;
+
+	std::vector<RTLIL::Design*> others;
+	RTLIL::Design *self = nullptr;
+	for (auto d : shared_designs_) {
+		if (d == keeper)
+			self = d;
+		else
+			others.push_back(d);
+	}
+	if (design == keeper)
+		self = design;
+	else
+		others.push_back(design);
+	log_assert(self != nullptr);
+
+	RTLIL::Module *copy = clone();
+	copy->design = others.front();
+	copy->shared_designs_.assign(others.begin() + 1, others.end());
+	for (auto d : others)
+		d->modules_.at(name) = copy;
+
+	design = self;
+	shared_designs_.clear();
+}
+
 bool RTLIL::Module::has_memories() const
 {
 	return !memories.empty();
@@ -1824,7 +2074,8 @@ void RTLIL::Module::remove(const pool<RTLIL::Wire*> &wires)
 
 		void operator()(RTLIL::SigSpec &sig) {
 			sig.pack();
-			for (auto &c : sig.chunks_)
+			sig.detach();
+			for (auto &c : sig.data_->chunks)
 				if (c.wire != NULL && wires_p->count(c.wire)) {
 					c.wire = module->addWire(NEW_ID, c.width);
 					c.offset = 0;
@@ -1835,9 +2086,11 @@ void RTLIL::Module::remove(const pool<RTLIL::Wire*> &wires)
 			log_assert(GetSize(lhs) == GetSize(rhs));
 			lhs.unpack();
 			rhs.unpack();
+			lhs.detach();
+			rhs.detach();
 			for (int i = 0; i < GetSize(lhs); i++) {
-				RTLIL::SigBit &lhs_bit = lhs.bits_[i];
-				RTLIL::SigBit &rhs_bit = rhs.bits_[i];
+				RTLIL::SigBit &lhs_bit = lhs.data_->bits[i];
+				RTLIL::SigBit &rhs_bit = rhs.data_->bits[i];
 				if ((lhs_bit.wire != nullptr && wires_p->count(lhs_bit.wire)) || (rhs_bit.wire != nullptr && wires_p->count(rhs_bit.wire))) {
 					lhs_bit = State::Sx;
 					rhs_bit = State::Sx;
@@ -1854,7 +2107,7 @@ void RTLIL::Module::remove(const pool<RTLIL::Wire*> &wires)
 	for (auto &it : wires) {
 		log_assert(wires_.count(it->name) != 0);
 		wires_.erase(it->name);
-		delete it;
+		destroy(it);
 	}
 }
 
@@ -1866,7 +2119,19 @@ void RTLIL::Module::remove(RTLIL::Cell *cell)
 	log_assert(cells_.count(cell->name) != 0);
 	log_assert(refcount_cells_ == 0);
 	cells_.erase(cell->name);
-	delete cell;
+	destroy(cell);
+}
+
+void RTLIL::Module::destroy(RTLIL::Wire *wire)
+{
+	wire->~Wire();
+	wire_arena_.deallocate(wire);
+}
+
+void RTLIL::Module::destroy(RTLIL::Cell *cell)
+{
+	cell->~Cell();
+	cell_arena_.deallocate(cell);
 }
 
 void RTLIL::Module::rename(RTLIL::Wire *wire, RTLIL::IdString new_name)
@@ -1998,6 +2263,17 @@ void RTLIL::Module::connect(const RTLIL::SigSpec &lhs, const RTLIL::SigSpec &rhs
 	connect(RTLIL::SigSig(lhs, rhs));
 }
 
+// Called after connections_ was modified in place
+void RTLIL::Module::notify_connections_rewritten()
+{
+	for (auto mon : monitors)
+		mon->notify_connect(this, connections_);
+
+	if (design)
+		for (auto mon : design->monitors)
+			mon->notify_connect(this, connections_);
+}
+
 void RTLIL::Module::new_connections(const std::vector<RTLIL::SigSig> &new_conn)
 {
 	for (auto mon : monitors)
@@ -2022,6 +2298,13 @@ const std::vector<RTLIL::SigSig> &RTLIL::Module::connections() const
 	return connections_;
 }
 
+const SigMap &RTLIL::Module::sigmap()
+{
+	if (sigmap_ == nullptr)
+		sigmap_ = new ModuleSigMap(this);
+	return sigmap_->get();
+}
+
 void RTLIL::Module::fixup_ports()
 {
 	std::vector<RTLIL::Wire*> all_ports;
@@ -2043,7 +2326,7 @@ void RTLIL::Module::fixup_ports()
 
 RTLIL::Wire *RTLIL::Module::addWire(RTLIL::IdString name, int width)
 {
-	RTLIL::Wire *wire = new RTLIL::Wire;
+	RTLIL::Wire *wire = new (wire_arena_.allocate()) RTLIL::Wire;
 	wire->name = name;
 	wire->width = width;
 	add(wire);
@@ -2066,7 +2349,7 @@ RTLIL::Wire *RTLIL::Module::addWire(RTLIL::IdString name, const RTLIL::Wire *oth
 
 RTLIL::Cell *RTLIL::Module::addCell(RTLIL::IdString name, RTLIL::IdString type)
 {
-	RTLIL::Cell *cell = new RTLIL::Cell;
+	RTLIL::Cell *cell = new (cell_arena_.allocate()) RTLIL::Cell;
 	cell->name = name;
 	cell->type = type;
 	add(cell);
@@ -2847,9 +3130,8 @@ RTLIL::SigSpec RTLIL::Module::Initstate(RTLIL::IdString name, const std::string
 
 RTLIL::Wire::Wire()
 {
-	static unsigned int hashidx_count = 123456789;
-	hashidx_count = mkhash_xorshift(hashidx_count);
-	hashidx_ = hashidx_count;
+	static hashidx_sequence_t hashidx_sequence;
+	hashidx_ = hashidx_sequence.next();
 
 	module = nullptr;
 	width = 1;
@@ -2882,9 +3164,8 @@ std::map<unsigned int, RTLIL::Wire*> *RTLIL::Wire::get_all_wires(void)
 
 RTLIL::Memory::Memory()
 {
-	static unsigned int hashidx_count = 123456789;
-	hashidx_count = mkhash_xorshift(hashidx_count);
-	hashidx_ = hashidx_count;
+	static hashidx_sequence_t hashidx_sequence;
+	hashidx_ = hashidx_sequence.next();
 
 	width = 1;
 	start_offset = 0;
@@ -2896,9 +3177,8 @@ RTLIL::Memory::Memory()
 
 RTLIL::Cell::Cell() : module(nullptr)
 {
-	static unsigned int hashidx_count = 123456789;
-	hashidx_count = mkhash_xorshift(hashidx_count);
-	hashidx_ = hashidx_count;
+	static hashidx_sequence_t hashidx_sequence;
+	hashidx_ = hashidx_sequence.next();
 
 	// log("#memtrace# %p\n", this);
 	memhasher();
@@ -3241,9 +3521,16 @@ RTLIL::SigSpec::SigSpec()
 	hash_ = 0;
 }
 
+RTLIL::SigSpec::Data RTLIL::SigSpec::empty_data_;
+
 RTLIL::SigSpec::SigSpec(const RTLIL::SigSpec &other)
 {
-	*this = other;
+	cover("kernel.rtlil.sigspec.init.copy");
+
+	width_ = other.width_;
+	hash_ = other.hash_;
+	data_ = other.data_;
+	retain();
 }
 
 RTLIL::SigSpec::SigSpec(std::initializer_list<RTLIL::SigSpec> parts)
@@ -3264,19 +3551,35 @@ RTLIL::SigSpec &RTLIL::SigSpec::operator=(const RTLIL::SigSpec &other)
 {
 	cover("kernel.rtlil.sigspec.assign");
 
+	other.retain();
+	release();
 	width_ = other.width_;
 	hash_ = other.hash_;
-	chunks_ = other.chunks_;
-	bits_ = other.bits_;
+	data_ = other.data_;
 	return *this;
 }
 
+void RTLIL::SigSpec::unshare()
+{
+	if (data_ == &empty_data_) {
+		cover("kernel.rtlil.sigspec.alloc");
+		data_ = new Data;
+		return;
+	}
+
+	cover("kernel.rtlil.sigspec.unshare");
+	Data *new_data = new Data(*data_);
+	release();
+	data_ = new_data;
+}
+
 RTLIL::SigSpec::SigSpec(const RTLIL::Const &value)
 {
 	cover("kernel.rtlil.sigspec.init.const");
 
-	chunks_.emplace_back(value);
-	width_ = chunks_.back().width;
+	detach();
+	data_->chunks.emplace_back(value);
+	width_ = data_->chunks.back().width;
 	hash_ = 0;
 	check();
 }
@@ -3285,8 +3588,9 @@ RTLIL::SigSpec::SigSpec(const RTLIL::SigChunk &chunk)
 {
 	cover("kernel.rtlil.sigspec.init.chunk");
 
-	chunks_.emplace_back(chunk);
-	width_ = chunks_.back().width;
+	detach();
+	data_->chunks.emplace_back(chunk);
+	width_ = data_->chunks.back().width;
 	hash_ = 0;
 	check();
 }
@@ -3295,8 +3599,9 @@ RTLIL::SigSpec::SigSpec(RTLIL::Wire *wire)
 {
 	cover("kernel.rtlil.sigspec.init.wire");
 
-	chunks_.emplace_back(wire);
-	width_ = chunks_.back().width;
+	detach();
+	data_->chunks.emplace_back(wire);
+	width_ = data_->chunks.back().width;
 	hash_ = 0;
 	check();
 }
@@ -3305,8 +3610,9 @@ RTLIL::SigSpec::SigSpec(RTLIL::Wire *wire, int offset, int width)
 {
 	cover("kernel.rtlil.sigspec.init.wire_part");
 
-	chunks_.emplace_back(wire, offset, width);
-	width_ = chunks_.back().width;
+	detach();
+	data_->chunks.emplace_back(wire, offset, width);
+	width_ = data_->chunks.back().width;
 	hash_ = 0;
 	check();
 }
@@ -3315,8 +3621,9 @@ RTLIL::SigSpec::SigSpec(const std::string &str)
 {
 	cover("kernel.rtlil.sigspec.init.str");
 
-	chunks_.emplace_back(str);
-	width_ = chunks_.back().width;
+	detach();
+	data_->chunks.emplace_back(str);
+	width_ = data_->chunks.back().width;
 	hash_ = 0;
 	check();
 }
@@ -3325,7 +3632,8 @@ RTLIL::SigSpec::SigSpec(int val, int width)
 {
 	cover("kernel.rtlil.sigspec.init.int");
 
-	chunks_.emplace_back(val, width);
+	detach();
+	data_->chunks.emplace_back(val, width);
 	width_ = width;
 	hash_ = 0;
 	check();
@@ -3335,7 +3643,8 @@ RTLIL::SigSpec::SigSpec(RTLIL::State bit, int width)
 {
 	cover("kernel.rtlil.sigspec.init.state");
 
-	chunks_.emplace_back(bit, width);
+	detach();
+	data_->chunks.emplace_back(bit, width);
 	width_ = width;
 	hash_ = 0;
 	check();
@@ -3345,11 +3654,12 @@ RTLIL::SigSpec::SigSpec(const RTLIL::SigBit &bit, int width)
 {
 	cover("kernel.rtlil.sigspec.init.bit");
 
+	detach();
 	if (bit.wire == NULL)
-		chunks_.emplace_back(bit.data, width);
+		data_->chunks.emplace_back(bit.data, width);
 	else
 		for (int i = 0; i < width; i++)
-			chunks_.push_back(bit);
+			data_->chunks.push_back(bit);
 	width_ = width;
 	hash_ = 0;
 	check();
@@ -3413,14 +3723,21 @@ void RTLIL::SigSpec::pack() const
 {
 	RTLIL::SigSpec *that = (RTLIL::SigSpec*)this;
 
-	if (that->bits_.empty())
+	if (that->data_->bits.empty())
 		return;
 
 	cover("kernel.rtlil.sigspec.convert.pack");
-	log_assert(that->chunks_.empty());
+	log_assert(that->data_->chunks.empty());
 
+	// Other SigSpecs sharing the data may hold references into it, so a
+	// shared block is left alone and the packed chunks go into a new one.
 	std::vector<RTLIL::SigBit> old_bits;
-	old_bits.swap(that->bits_);
+	if (that->data_->refcount != 1) {
+		old_bits = that->data_->bits;
+		that->release();
+		that->data_ = new Data;
+	} else
+		old_bits.swap(that->data_->bits);
 
 	RTLIL::SigChunk *last = NULL;
 	int last_end_offset = 0;
@@ -3437,8 +3754,8 @@ void RTLIL::SigSpec::pack() const
 				continue;
 			}
 		}
-		that->chunks_.push_back(bit);
-		last = &that->chunks_.back();
+		that->data_->chunks.push_back(bit);
+		last = &that->data_->chunks.back();
 		last_end_offset = bit.offset + 1;
 	}
 
@@ -3449,18 +3766,24 @@ void RTLIL::SigSpec::unpack() const
 {
 	RTLIL::SigSpec *that = (RTLIL::SigSpec*)this;
 
-	if (that->chunks_.empty())
+	if (that->data_->chunks.empty())
 		return;
 
 	cover("kernel.rtlil.sigspec.convert.unpack");
-	log_assert(that->bits_.empty());
+	log_assert(that->data_->bits.empty());
+
+	Data *new_data = that->data_->refcount != 1 ? new Data : that->data_;
 
-	that->bits_.reserve(that->width_);
-	for (auto &c : that->chunks_)
+	new_data->bits.reserve(that->width_);
+	for (auto &c : that->data_->chunks)
 		for (int i = 0; i < c.width; i++)
-			that->bits_.emplace_back(c, i);
+			new_data->bits.emplace_back(c, i);
 
-	that->chunks_.clear();
+	if (new_data != that->data_) {
+		that->release();
+		that->data_ = new_data;
+	} else
+		that->data_->chunks.clear();
 	that->hash_ = 0;
 }
 
@@ -3475,7 +3798,7 @@ void RTLIL::SigSpec::updhash() const
 	that->pack();
 
 	that->hash_ = mkhash_init;
-	for (auto &c : that->chunks_)
+	for (auto &c : that->data_->chunks)
 		if (c.wire == NULL) {
 			for (auto &v : c.data)
 				that->hash_ = mkhash(that->hash_, v);
@@ -3492,8 +3815,9 @@ void RTLIL::SigSpec::updhash() const
 void RTLIL::SigSpec::sort()
 {
 	unpack();
+	detach();
 	cover("kernel.rtlil.sigspec.sort");
-	std::sort(bits_.begin(), bits_.end());
+	std::sort(data_->bits.begin(), data_->bits.end());
 }
 
 void RTLIL::SigSpec::sort_and_unify()
@@ -3504,7 +3828,7 @@ void RTLIL::SigSpec::sort_and_unify()
 	// A copy of the bits vector is used to prevent duplicating the logic from
 	// SigSpec::SigSpec(std::vector<SigBit>).  This incurrs an extra copy but
 	// that isn't showing up as significant in profiles.
-	std::vector<SigBit> unique_bits = bits_;
+	std::vector<SigBit> unique_bits = data_->bits;
 	std::sort(unique_bits.begin(), unique_bits.end());
 	auto last = std::unique(unique_bits.begin(), unique_bits.end());
 	unique_bits.erase(last, unique_bits.end());
@@ -3527,12 +3851,13 @@ void RTLIL::SigSpec::replace(const RTLIL::SigSpec &pattern, const RTLIL::SigSpec
 	with.unpack();
 	unpack();
 	other->unpack();
+	other->detach();
 
-	for (int i = 0; i < GetSize(pattern.bits_); i++) {
-		if (pattern.bits_[i].wire != NULL) {
-			for (int j = 0; j < GetSize(bits_); j++) {
-				if (bits_[j] == pattern.bits_[i]) {
-					other->bits_[j] = with.bits_[i];
+	for (int i = 0; i < GetSize(pattern.data_->bits); i++) {
+		if (pattern.data_->bits[i].wire != NULL) {
+			for (int j = 0; j < GetSize(data_->bits); j++) {
+				if (data_->bits[j] == pattern.data_->bits[i]) {
+					other->data_->bits[j] = with.data_->bits[i];
 				}
 			}
 		}
@@ -3556,11 +3881,12 @@ void RTLIL::SigSpec::replace(const dict<RTLIL::SigBit, RTLIL::SigBit> &rules, RT
 	if (rules.empty()) return;
 	unpack();
 	other->unpack();
+	other->detach();
 
-	for (int i = 0; i < GetSize(bits_); i++) {
-		auto it = rules.find(bits_[i]);
+	for (int i = 0; i < GetSize(data_->bits); i++) {
+		auto it = rules.find(data_->bits[i]);
 		if (it != rules.end())
-			other->bits_[i] = it->second;
+			other->data_->bits[i] = it->second;
 	}
 
 	other->check();
@@ -3581,11 +3907,12 @@ void RTLIL::SigSpec::replace(const std::map<RTLIL::SigBit, RTLIL::SigBit> &rules
 	if (rules.empty()) return;
 	unpack();
 	other->unpack();
+	other->detach();
 
-	for (int i = 0; i < GetSize(bits_); i++) {
-		auto it = rules.find(bits_[i]);
+	for (int i = 0; i < GetSize(data_->bits); i++) {
+		auto it = rules.find(data_->bits[i]);
 		if (it != rules.end())
-			other->bits_[i] = it->second;
+			other->data_->bits[i] = it->second;
 	}
 
 	other->check();
@@ -3610,23 +3937,25 @@ void RTLIL::SigSpec::remove2(const RTLIL::SigSpec &pattern, RTLIL::SigSpec *othe
 		cover("kernel.rtlil.sigspec.remove");
 
 	unpack();
+	detach();
 	if (other != NULL) {
 		log_assert(width_ == other->width_);
 		other->unpack();
+		other->detach();
 	}
 
-	for (int i = GetSize(bits_) - 1; i >= 0; i--)
+	for (int i = GetSize(data_->bits) - 1; i >= 0; i--)
 	{
-		if (bits_[i].wire == NULL) continue;
+		if (data_->bits[i].wire == NULL) continue;
 
 		for (auto &pattern_chunk : pattern.chunks())
-			if (bits_[i].wire == pattern_chunk.wire &&
-				bits_[i].offset >= pattern_chunk.offset &&
-				bits_[i].offset < pattern_chunk.offset + pattern_chunk.width) {
-				bits_.erase(bits_.begin() + i);
+			if (data_->bits[i].wire == pattern_chunk.wire &&
+				data_->bits[i].offset >= pattern_chunk.offset &&
+				data_->bits[i].offset < pattern_chunk.offset + pattern_chunk.width) {
+				data_->bits.erase(data_->bits.begin() + i);
 				width_--;
 				if (other != NULL) {
-					other->bits_.erase(other->bits_.begin() + i);
+					other->data_->bits.erase(other->data_->bits.begin() + i);
 					other->width_--;
 				}
 				break;
@@ -3655,18 +3984,20 @@ void RTLIL::SigSpec::remove2(const pool<RTLIL::SigBit> &pattern, RTLIL::SigSpec
 		cover("kernel.rtlil.sigspec.remove");
 
 	unpack();
+	detach();
 
 	if (other != NULL) {
 		log_assert(width_ == other->width_);
 		other->unpack();
+		other->detach();
 	}
 
-	for (int i = GetSize(bits_) - 1; i >= 0; i--) {
-		if (bits_[i].wire != NULL && pattern.count(bits_[i])) {
-			bits_.erase(bits_.begin() + i);
+	for (int i = GetSize(data_->bits) - 1; i >= 0; i--) {
+		if (data_->bits[i].wire != NULL && pattern.count(data_->bits[i])) {
+			data_->bits.erase(data_->bits.begin() + i);
 			width_--;
 			if (other != NULL) {
-				other->bits_.erase(other->bits_.begin() + i);
+				other->data_->bits.erase(other->data_->bits.begin() + i);
 				other->width_--;
 			}
 		}
@@ -3683,18 +4014,20 @@ void RTLIL::SigSpec::remove2(const std::set<RTLIL::SigBit> &pattern, RTLIL::SigS
 		cover("kernel.rtlil.sigspec.remove");
 
 	unpack();
+	detach();
 
 	if (other != NULL) {
 		log_assert(width_ == other->width_);
 		other->unpack();
+		other->detach();
 	}
 
-	for (int i = GetSize(bits_) - 1; i >= 0; i--) {
-		if (bits_[i].wire != NULL && pattern.count(bits_[i])) {
-			bits_.erase(bits_.begin() + i);
+	for (int i = GetSize(data_->bits) - 1; i >= 0; i--) {
+		if (data_->bits[i].wire != NULL && pattern.count(data_->bits[i])) {
+			data_->bits.erase(data_->bits.begin() + i);
 			width_--;
 			if (other != NULL) {
-				other->bits_.erase(other->bits_.begin() + i);
+				other->data_->bits.erase(other->data_->bits.begin() + i);
 				other->width_--;
 			}
 		}
@@ -3770,6 +4103,7 @@ void RTLIL::SigSpec::replace(int offset, const RTLIL::SigSpec &with)
 	cover("kernel.rtlil.sigspec.replace_pos");
 
 	unpack();
+	detach();
 	with.unpack();
 
 	log_assert(offset >= 0);
@@ -3777,28 +4111,30 @@ void RTLIL::SigSpec::replace(int offset, const RTLIL::SigSpec &with)
 	log_assert(offset+with.width_ <= width_);
 
 	for (int i = 0; i < with.width_; i++)
-		bits_.at(offset + i) = with.bits_.at(i);
+		data_->bits.at(offset + i) = with.data_->bits.at(i);
 
 	check();
 }
 
 void RTLIL::SigSpec::remove_const()
 {
+	detach();
+
 	if (packed())
 	{
 		cover("kernel.rtlil.sigspec.remove_const.packed");
 
 		std::vector<RTLIL::SigChunk> new_chunks;
-		new_chunks.reserve(GetSize(chunks_));
+		new_chunks.reserve(GetSize(data_->chunks));
 
 		width_ = 0;
-		for (auto &chunk : chunks_)
+		for (auto &chunk : data_->chunks)
 			if (chunk.wire != NULL) {
 				new_chunks.push_back(chunk);
 				width_ += chunk.width;
 			}
 
-		chunks_.swap(new_chunks);
+		data_->chunks.swap(new_chunks);
 	}
 	else
 	{
@@ -3807,12 +4143,12 @@ void RTLIL::SigSpec::remove_const()
 		std::vector<RTLIL::SigBit> new_bits;
 		new_bits.reserve(width_);
 
-		for (auto &bit : bits_)
+		for (auto &bit : data_->bits)
 			if (bit.wire != NULL)
 				new_bits.push_back(bit);
 
-		bits_.swap(new_bits);
-		width_ = bits_.size();
+		data_->bits.swap(new_bits);
+		width_ = data_->bits.size();
 	}
 
 	check();
@@ -3823,13 +4159,14 @@ void RTLIL::SigSpec::remove(int offset, int length)
 	cover("kernel.rtlil.sigspec.remove_pos");
 
 	unpack();
+	detach();
 
 	log_assert(offset >= 0);
 	log_assert(length >= 0);
 	log_assert(offset + length <= width_);
 
-	bits_.erase(bits_.begin() + offset, bits_.begin() + offset + length);
-	width_ = bits_.size();
+	data_->bits.erase(data_->bits.begin() + offset, data_->bits.begin() + offset + length);
+	width_ = data_->bits.size();
 
 	check();
 }
@@ -3838,7 +4175,7 @@ RTLIL::SigSpec RTLIL::SigSpec::extract(int offset, int length) const
 {
 	unpack();
 	cover("kernel.rtlil.sigspec.extract_pos");
-	return std::vector<RTLIL::SigBit>(bits_.begin() + offset, bits_.begin() + offset + length);
+	return std::vector<RTLIL::SigBit>(data_->bits.begin() + offset, data_->bits.begin() + offset + length);
 }
 
 void RTLIL::SigSpec::append(const RTLIL::SigSpec &signal)
@@ -3858,10 +4195,12 @@ void RTLIL::SigSpec::append(const RTLIL::SigSpec &signal)
 		signal.pack();
 	}
 
+	detach();
+
 	if (packed())
-		for (auto &other_c : signal.chunks_)
+		for (auto &other_c : signal.data_->chunks)
 		{
-			auto &my_last_c = chunks_.back();
+			auto &my_last_c = data_->chunks.back();
 			if (my_last_c.wire == NULL && other_c.wire == NULL) {
 				auto &this_data = my_last_c.data;
 				auto &other_data = other_c.data;
@@ -3871,10 +4210,10 @@ void RTLIL::SigSpec::append(const RTLIL::SigSpec &signal)
 			if (my_last_c.wire == other_c.wire && my_last_c.offset + my_last_c.width == other_c.offset) {
 				my_last_c.width += other_c.width;
 			} else
-				chunks_.push_back(other_c);
+				data_->chunks.push_back(other_c);
 		}
 	else
-		bits_.insert(bits_.end(), signal.bits_.begin(), signal.bits_.end());
+		data_->bits.insert(data_->bits.end(), signal.data_->bits.begin(), signal.data_->bits.end());
 
 	width_ += signal.width_;
 	check();
@@ -3882,29 +4221,31 @@ void RTLIL::SigSpec::append(const RTLIL::SigSpec &signal)
 
 void RTLIL::SigSpec::append(const RTLIL::SigBit &bit)
 {
+	detach();
+
 	if (packed())
 	{
 		cover("kernel.rtlil.sigspec.append_bit.packed");
 
-		if (chunks_.size() == 0)
-			chunks_.push_back(bit);
+		if (data_->chunks.size() == 0)
+			data_->chunks.push_back(bit);
 		else
 			if (bit.wire == NULL)
-				if (chunks_.back().wire == NULL) {
-					chunks_.back().data.push_back(bit.data);
-					chunks_.back().width++;
+				if (data_->chunks.back().wire == NULL) {
+					data_->chunks.back().data.push_back(bit.data);
+					data_->chunks.back().width++;
 				} else
-					chunks_.push_back(bit);
+					data_->chunks.push_back(bit);
 			else
-				if (chunks_.back().wire == bit.wire && chunks_.back().offset + chunks_.back().width == bit.offset)
-					chunks_.back().width++;
+				if (data_->chunks.back().wire == bit.wire && data_->chunks.back().offset + data_->chunks.back().width == bit.offset)
+					data_->chunks.back().width++;
 				else
-					chunks_.push_back(bit);
+					data_->chunks.push_back(bit);
 	}
 	else
 	{
 		cover("kernel.rtlil.sigspec.append_bit.unpacked");
-		bits_.push_back(bit);
+		data_->bits.push_back(bit);
 	}
 
 	width_++;
@@ -3930,6 +4271,19 @@ void RTLIL::SigSpec::extend_u0(int width, bool is_signed)
 
 }
 
+size_t RTLIL::SigSpec::heap_bytes(pool<const void*, hash_ptr_ops> &seen) const
+{
+	if (data_ == &empty_data_ || !seen.insert(data_).second)
+		return 0;
+
+	size_t bytes = sizeof(Data);
+	bytes += data_->chunks.capacity() * sizeof(RTLIL::SigChunk);
+	bytes += data_->bits.capacity() * sizeof(RTLIL::SigBit);
+	for (auto &c : data_->chunks)
+		bytes += c.data.capacity() * sizeof(RTLIL::State);
+	return bytes;
+}
+
 RTLIL::SigSpec RTLIL::SigSpec::repeat(int num) const
 {
 	cover("kernel.rtlil.sigspec.repeat");
@@ -3952,16 +4306,16 @@ void RTLIL::SigSpec::check() const
 		cover("kernel.rtlil.sigspec.check.packed");
 
 		int w = 0;
-		for (size_t i = 0; i < chunks_.size(); i++) {
-			const RTLIL::SigChunk &chunk = chunks_[i];
+		for (size_t i = 0; i < data_->chunks.size(); i++) {
+			const RTLIL::SigChunk &chunk = data_->chunks[i];
 			if (chunk.wire == NULL) {
 				if (i > 0)
-					log_assert(chunks_[i-1].wire != NULL);
+					log_assert(data_->chunks[i-1].wire != NULL);
 				log_assert(chunk.offset == 0);
 				log_assert(chunk.data.size() == (size_t)chunk.width);
 			} else {
-				if (i > 0 && chunks_[i-1].wire == chunk.wire)
-					log_assert(chunk.offset != chunks_[i-1].offset + chunks_[i-1].width);
+				if (i > 0 && data_->chunks[i-1].wire == chunk.wire)
+					log_assert(chunk.offset != data_->chunks[i-1].offset + data_->chunks[i-1].width);
 				log_assert(chunk.offset >= 0);
 				log_assert(chunk.width >= 0);
 				log_assert(chunk.offset + chunk.width <= chunk.wire->width);
@@ -3970,14 +4324,14 @@ void RTLIL::SigSpec::check() const
 			w += chunk.width;
 		}
 		log_assert(w == width_);
-		log_assert(bits_.empty());
+		log_assert(data_->bits.empty());
 	}
 	else
 	{
 		cover("kernel.rtlil.sigspec.check.unpacked");
 
-		log_assert(width_ == GetSize(bits_));
-		log_assert(chunks_.empty());
+		log_assert(width_ == GetSize(data_->bits));
+		log_assert(data_->chunks.empty());
 	}
 }
 #endif
@@ -3995,8 +4349,8 @@ bool RTLIL::SigSpec::operator <(const RTLIL::SigSpec &other) const
 	pack();
 	other.pack();
 
-	if (chunks_.size() != other.chunks_.size())
-		return chunks_.size() < other.chunks_.size();
+	if (data_->chunks.size() != other.data_->chunks.size())
+		return data_->chunks.size() < other.data_->chunks.size();
 
 	updhash();
 	other.updhash();
@@ -4004,10 +4358,10 @@ bool RTLIL::SigSpec::operator <(const RTLIL::SigSpec &other) const
 	if (hash_ != other.hash_)
 		return hash_ < other.hash_;
 
-	for (size_t i = 0; i < chunks_.size(); i++)
-		if (chunks_[i] != other.chunks_[i]) {
+	for (size_t i = 0; i < data_->chunks.size(); i++)
+		if (data_->chunks[i] != other.data_->chunks[i]) {
 			cover("kernel.rtlil.sigspec.comp_lt.hash_collision");
-			return chunks_[i] < other.chunks_[i];
+			return data_->chunks[i] < other.data_->chunks[i];
 		}
 
 	cover("kernel.rtlil.sigspec.comp_lt.equal");
@@ -4033,7 +4387,7 @@ bool RTLIL::SigSpec::operator ==(const RTLIL::SigSpec &other) const
 	pack();
 	other.pack();
 
-	if (chunks_.size() != other.chunks_.size())
+	if (data_->chunks.size() != other.data_->chunks.size())
 		return false;
 
 	updhash();
@@ -4042,8 +4396,8 @@ bool RTLIL::SigSpec::operator ==(const RTLIL::SigSpec &other) const
 	if (hash_ != other.hash_)
 		return false;
 
-	for (size_t i = 0; i < chunks_.size(); i++)
-		if (chunks_[i] != other.chunks_[i]) {
+	for (size_t i = 0; i < data_->chunks.size(); i++)
+		if (data_->chunks[i] != other.data_->chunks[i]) {
 			cover("kernel.rtlil.sigspec.comp_eq.hash_collision");
 			return false;
 		}
@@ -4057,7 +4411,7 @@ bool RTLIL::SigSpec::is_wire() const
 	cover("kernel.rtlil.sigspec.is_wire");
 
 	pack();
-	return GetSize(chunks_) == 1 && chunks_[0].wire && chunks_[0].wire->width == width_;
+	return GetSize(data_->chunks) == 1 && data_->chunks[0].wire && data_->chunks[0].wire->width == width_;
 }
 
 bool RTLIL::SigSpec::is_chunk() const
@@ -4065,7 +4419,7 @@ bool RTLIL::SigSpec::is_chunk() const
 	cover("kernel.rtlil.sigspec.is_chunk");
 
 	pack();
-	return GetSize(chunks_) == 1;
+	return GetSize(data_->chunks) == 1;
 }
 
 bool RTLIL::SigSpec::is_fully_const() const
@@ -4073,7 +4427,7 @@ bool RTLIL::SigSpec::is_fully_const() const
 	cover("kernel.rtlil.sigspec.is_fully_const");
 
 	pack();
-	for (auto it = chunks_.begin(); it != chunks_.end(); it++)
+	for (auto it = data_->chunks.begin(); it != data_->chunks.end(); it++)
 		if (it->width > 0 && it->wire != NULL)
 			return false;
 	return true;
@@ -4084,7 +4438,7 @@ bool RTLIL::SigSpec::is_fully_zero() const
 	cover("kernel.rtlil.sigspec.is_fully_zero");
 
 	pack();
-	for (auto it = chunks_.begin(); it != chunks_.end(); it++) {
+	for (auto it = data_->chunks.begin(); it != data_->chunks.end(); it++) {
 		if (it->width > 0 && it->wire != NULL)
 			return false;
 		for (size_t i = 0; i < it->data.size(); i++)
@@ -4099,7 +4453,7 @@ bool RTLIL::SigSpec::is_fully_ones() const
 	cover("kernel.rtlil.sigspec.is_fully_ones");
 
 	pack();
-	for (auto it = chunks_.begin(); it != chunks_.end(); it++) {
+	for (auto it = data_->chunks.begin(); it != data_->chunks.end(); it++) {
 		if (it->width > 0 && it->wire != NULL)
 			return false;
 		for (size_t i = 0; i < it->data.size(); i++)
@@ -4114,7 +4468,7 @@ bool RTLIL::SigSpec::is_fully_def() const
 	cover("kernel.rtlil.sigspec.is_fully_def");
 
 	pack();
-	for (auto it = chunks_.begin(); it != chunks_.end(); it++) {
+	for (auto it = data_->chunks.begin(); it != data_->chunks.end(); it++) {
 		if (it->width > 0 && it->wire != NULL)
 			return false;
 		for (size_t i = 0; i < it->data.size(); i++)
@@ -4129,7 +4483,7 @@ bool RTLIL::SigSpec::is_fully_undef() const
 	cover("kernel.rtlil.sigspec.is_fully_undef");
 
 	pack();
-	for (auto it = chunks_.begin(); it != chunks_.end(); it++) {
+	for (auto it = data_->chunks.begin(); it != data_->chunks.end(); it++) {
 		if (it->width > 0 && it->wire != NULL)
 			return false;
 		for (size_t i = 0; i < it->data.size(); i++)
@@ -4144,7 +4498,7 @@ bool RTLIL::SigSpec::has_const() const
 	cover("kernel.rtlil.sigspec.has_const");
 
 	pack();
-	for (auto it = chunks_.begin(); it != chunks_.end(); it++)
+	for (auto it = data_->chunks.begin(); it != data_->chunks.end(); it++)
 		if (it->width > 0 && it->wire == NULL)
 			return true;
 	return false;
@@ -4155,7 +4509,7 @@ bool RTLIL::SigSpec::has_marked_bits() const
 	cover("kernel.rtlil.sigspec.has_marked_bits");
 
 	pack();
-	for (auto it = chunks_.begin(); it != chunks_.end(); it++)
+	for (auto it = data_->chunks.begin(); it != data_->chunks.end(); it++)
 		if (it->width > 0 && it->wire == NULL) {
 			for (size_t i = 0; i < it->data.size(); i++)
 				if (it->data[i] == RTLIL::State::Sm)
@@ -4169,9 +4523,9 @@ bool RTLIL::SigSpec::as_bool() const
 	cover("kernel.rtlil.sigspec.as_bool");
 
 	pack();
-	log_assert(is_fully_const() && GetSize(chunks_) <= 1);
+	log_assert(is_fully_const() && GetSize(data_->chunks) <= 1);
 	if (width_)
-		return RTLIL::Const(chunks_[0].data).as_bool();
+		return RTLIL::Const(data_->chunks[0].data).as_bool();
 	return false;
 }
 
@@ -4180,9 +4534,9 @@ int RTLIL::SigSpec::as_int(bool is_signed) const
 	cover("kernel.rtlil.sigspec.as_int");
 
 	pack();
-	log_assert(is_fully_const() && GetSize(chunks_) <= 1);
+	log_assert(is_fully_const() && GetSize(data_->chunks) <= 1);
 	if (width_)
-		return RTLIL::Const(chunks_[0].data).as_int(is_signed);
+		return RTLIL::Const(data_->chunks[0].data).as_int(is_signed);
 	return 0;
 }
 
@@ -4193,8 +4547,8 @@ std::string RTLIL::SigSpec::as_string() const
 	pack();
 	std::string str;
 	str.reserve(size());
-	for (size_t i = chunks_.size(); i > 0; i--) {
-		const RTLIL::SigChunk &chunk = chunks_[i-1];
+	for (size_t i = data_->chunks.size(); i > 0; i--) {
+		const RTLIL::SigChunk &chunk = data_->chunks[i-1];
 		if (chunk.wire != NULL)
 			str.append(chunk.width, '?');
 		else
@@ -4208,9 +4562,9 @@ RTLIL::Const RTLIL::SigSpec::as_const() const
 	cover("kernel.rtlil.sigspec.as_const");
 
 	pack();
-	log_assert(is_fully_const() && GetSize(chunks_) <= 1);
+	log_assert(is_fully_const() && GetSize(data_->chunks) <= 1);
 	if (width_)
-		return chunks_[0].data;
+		return data_->chunks[0].data;
 	return RTLIL::Const();
 }
 
@@ -4220,7 +4574,7 @@ RTLIL::Wire *RTLIL::SigSpec::as_wire() const
 
 	pack();
 	log_assert(is_wire());
-	return chunks_[0].wire;
+	return data_->chunks[0].wire;
 }
 
 RTLIL::SigChunk RTLIL::SigSpec::as_chunk() const
@@ -4229,7 +4583,7 @@ RTLIL::SigChunk RTLIL::SigSpec::as_chunk() const
 
 	pack();
 	log_assert(is_chunk());
-	return chunks_[0];
+	return data_->chunks[0];
 }
 
 RTLIL::SigBit RTLIL::SigSpec::as_bit() const
@@ -4238,9 +4592,9 @@ RTLIL::SigBit RTLIL::SigSpec::as_bit() const
 
 	log_assert(width_ == 1);
 	if (packed())
-		return RTLIL::SigBit(*chunks_.begin());
+		return RTLIL::SigBit(*data_->chunks.begin());
 	else
-		return bits_[0];
+		return data_->bits[0];
 }
 
 bool RTLIL::SigSpec::match(const char* pattern) const
@@ -4248,9 +4602,9 @@ bool RTLIL::SigSpec::match(const char* pattern) const
 	cover("kernel.rtlil.sigspec.match");
 
 	unpack();
-	log_assert(int(strlen(pattern)) == GetSize(bits_));
+	log_assert(int(strlen(pattern)) == GetSize(data_->bits));
 
-	for (auto it = bits_.rbegin(); it != bits_.rend(); it++, pattern++) {
+	for (auto it = data_->bits.rbegin(); it != data_->bits.rend(); it++, pattern++) {
 		if (*pattern == ' ')
 			continue;
 		if (*pattern == '*') {
@@ -4278,7 +4632,7 @@ std::set<RTLIL::SigBit> RTLIL::SigSpec::to_sigbit_set() const
 
 	pack();
 	std::set<RTLIL::SigBit> sigbits;
-	for (auto &c : chunks_)
+	for (auto &c : data_->chunks)
 		for (int i = 0; i < c.width; i++)
 			sigbits.insert(RTLIL::SigBit(c, i));
 	return sigbits;
@@ -4291,7 +4645,7 @@ pool<RTLIL::SigBit> RTLIL::SigSpec::to_sigbit_pool() const
 	pack();
 	pool<RTLIL::SigBit> sigbits;
 	sigbits.reserve(size());
-	for (auto &c : chunks_)
+	for (auto &c : data_->chunks)
 		for (int i = 0; i < c.width; i++)
 			sigbits.insert(RTLIL::SigBit(c, i));
 	return sigbits;
@@ -4302,7 +4656,7 @@ std::vector<RTLIL::SigBit> RTLIL::SigSpec::to_sigbit_vector() const
 	cover("kernel.rtlil.sigspec.to_sigbit_vector");
 
 	unpack();
-	return bits_;
+	return data_->bits;
 }
 
 std::map<RTLIL::SigBit, RTLIL::SigBit> RTLIL::SigSpec::to_sigbit_map(const RTLIL::SigSpec &other) const
@@ -4316,7 +4670,7 @@ std::map<RTLIL::SigBit, RTLIL::SigBit> RTLIL::SigSpec::to_sigbit_map(const RTLIL
 
 	std::map<RTLIL::SigBit, RTLIL::SigBit> new_map;
 	for (int i = 0; i < width_; i++)
-		new_map[bits_[i]] = other.bits_[i];
+		new_map[data_->bits[i]] = other.data_->bits[i];
 
 	return new_map;
 }
@@ -4333,7 +4687,7 @@ dict<RTLIL::SigBit, RTLIL::SigBit> RTLIL::SigSpec::to_sigbit_dict(const RTLIL::S
 	dict<RTLIL::SigBit, RTLIL::SigBit> new_map;
 	new_map.reserve(size());
 	for (int i = 0; i < width_; i++)
-		new_map[bits_[i]] = other.bits_[i];
+		new_map[data_->bits[i]] = other.data_->bits[i];
 
 	return new_map;
 }
@@ -4475,7 +4829,7 @@ bool RTLIL::SigSpec::parse_rhs(const RTLIL::SigSpec &lhs, RTLIL::SigSpec &sig, R
 		return true;
 	}
 
-	if (lhs.chunks_.size() == 1) {
+	if (lhs.data_->chunks.size() == 1) {
 		char *p = (char*)str.c_str(), *endptr;
 		long int val = strtol(p, &endptr, 10);
 		if (endptr && endptr != p && *endptr == 0) {
@@ -18,12 +18,16 @@
  */
 
 #include "kernel/yosys.h"
+#include "kernel/arena.h"
 
 #ifndef RTLIL_H
 #define RTLIL_H
 
 YOSYS_NAMESPACE_BEGIN
 
+struct SigMap;
+struct ModuleSigMap;
+
 namespace RTLIL
 {
 	enum State : unsigned char {
@@ -54,6 +58,7 @@ namespace RTLIL
 	};
 
 	struct Const;
+	struct PackedConst;
 	struct AttrObject;
 	struct Selection;
 	struct Monitor;
@@ -74,6 +79,31 @@ namespace RTLIL
 
 	typedef std::pair<SigSpec, SigSpec> SigSig;
 
+	// pseudo-random sequence for the hashidx_ values of design objects,
+	// each object type has its own sequence
+	struct hashidx_sequence_t
+	{
+	#ifdef YOSYS_ENABLE_THREADS
+		std::atomic<unsigned int> state;
+	#else
+		unsigned int state;
+	#endif
+
+		hashidx_sequence_t() : state(123456789) { }
+
+		unsigned int next() {
+		#ifdef YOSYS_ENABLE_THREADS
+			unsigned int old_state = state.load(std::memory_order_relaxed), new_state;
+			do new_state = mkhash_xorshift(old_state);
+			while (!state.compare_exchange_weak(old_state, new_state, std::memory_order_relaxed));
+			return new_state;
+		#else
+			state = mkhash_xorshift(state);
+			return state;
+		#endif
+		}
+	};
+
 	struct IdString
 	{
 		#undef YOSYS_XTRACE_GET_PUT
@@ -89,11 +119,56 @@ namespace RTLIL
 			~destruct_guard_t() { ok = false; }
 		} destruct_guard;
 
-		static std::vector<char*> global_id_storage_;
-		static dict<char*, int, hash_cstr_ops> global_id_index_;
-	#ifndef YOSYS_NO_IDS_REFCNT
-		static std::vector<int> global_refcount_storage_;
-		static std::vector<int> global_free_idx_list_;
+		// The strings and their reference counters are stored in fixed-size chunks
+		// that are never moved or freed, so looking up an IdString by index (c_str(),
+		// str(), reference counting) never needs a lock.
+		//
+		// The name -> index table is split into shards by name hash. With
+		// YOSYS_ENABLE_THREADS each shard has its own mutex, the reference counters
+		// are atomic, and fresh slots are allocated under global_id_alloc_mutex_.
+		// Freed slots are recycled only by the shard that freed them, so the shard
+		// of a slot never changes once assigned.
+
+	#ifdef YOSYS_ENABLE_THREADS
+		typedef std::atomic<int> refcount_t;
+		enum : int { id_shard_bits = 4 };
+	#else
+		typedef int refcount_t;
+		enum : int { id_shard_bits = 0 };
+	#endif
+
+		enum : int {
+			id_shards = 1 << id_shard_bits,
+			id_chunk_bits = 14,
+			id_chunk_size = 1 << id_chunk_bits,
+			id_max_chunks = 0x40000000 >> id_chunk_bits
+		};
+
+		struct storage_chunk_t {
+			char *strings[id_chunk_size];
+		#ifndef YOSYS_NO_IDS_REFCNT
+			refcount_t refcounts[id_chunk_size];
+		#endif
+		#ifdef YOSYS_ENABLE_THREADS
+			unsigned char shards[id_chunk_size];
+		#endif
+		};
+
+		struct storage_shard_t {
+			dict<char*, int, hash_cstr_ops> index;
+		#ifndef YOSYS_NO_IDS_REFCNT
+			std::vector<int> free_idx_list;
+		#endif
+		#ifdef YOSYS_ENABLE_THREADS
+			std::mutex mutex;
+		#endif
+		};
+
+		static storage_chunk_t *global_id_chunks_[id_max_chunks];
+		static storage_shard_t global_id_shards_[id_shards];
+		static int global_id_count_;
+	#ifdef YOSYS_ENABLE_THREADS
+		static std::mutex global_id_alloc_mutex_;
 	#endif
 
 	#ifdef YOSYS_USE_STICKY_IDS
@@ -101,15 +176,43 @@ namespace RTLIL
 		static int last_created_idx_[8];
 	#endif
 
+		static inline char *&global_id_storage(int idx) {
+			return global_id_chunks_[idx >> id_chunk_bits]->strings[idx & (id_chunk_size-1)];
+		}
+
+	#ifndef YOSYS_NO_IDS_REFCNT
+		static inline refcount_t &global_refcount_storage(int idx) {
+			return global_id_chunks_[idx >> id_chunk_bits]->refcounts[idx & (id_chunk_size-1)];
+		}
+	#endif
+
+		static inline int global_id_shard(const char *p) {
+		#ifdef YOSYS_ENABLE_THREADS
+			return (hash_cstr_ops::hash(p) * 0x9e3779b9u) >> (32 - id_shard_bits);
+		#else
+			(void)p;
+			return 0;
+		#endif
+		}
+
+		static inline int global_id_shard(int idx) {
+		#ifdef YOSYS_ENABLE_THREADS
+			return global_id_chunks_[idx >> id_chunk_bits]->shards[idx & (id_chunk_size-1)];
+		#else
+			(void)idx;
+			return 0;
+		#endif
+		}
+
 		static inline void xtrace_db_dump()
 		{
 		#ifdef YOSYS_XTRACE_GET_PUT
-			for (int idx = 0; idx < GetSize(global_id_storage_); idx++)
+			for (int idx = 0; idx < global_id_count_; idx++)
 			{
-				if (global_id_storage_.at(idx) == nullptr)
+				if (global_id_storage(idx) == nullptr)
 					log("#X# DB-DUMP index %d: FREE\n", idx);
 				else
-					log("#X# DB-DUMP index %d: '%s' (ref %d)\n", idx, global_id_storage_.at(idx), global_refcount_storage_.at(idx));
+					log("#X# DB-DUMP index %d: '%s' (ref %d)\n", idx, global_id_storage(idx), int(global_refcount_storage(idx)));
 			}
 		#endif
 		}
@@ -125,7 +228,8 @@ namespace RTLIL
 			}
 		#endif
 		#ifdef YOSYS_SORT_ID_FREE_LIST
-			std::sort(global_free_idx_list_.begin(), global_free_idx_list_.end(), std::greater<int>());
+			for (auto &shard : global_id_shards_)
+				std::sort(shard.free_idx_list.begin(), shard.free_idx_list.end(), std::greater<int>());
 		#endif
 		}
 
@@ -133,16 +237,20 @@ namespace RTLIL
 		{
 			if (idx) {
 		#ifndef YOSYS_NO_IDS_REFCNT
-				global_refcount_storage_[idx]++;
+				global_refcount_storage(idx)++;
 		#endif
 		#ifdef YOSYS_XTRACE_GET_PUT
 				if (yosys_xtrace)
-					log("#X# GET-BY-INDEX '%s' (index %d, refcount %d)\n", global_id_storage_.at(idx), idx, global_refcount_storage_.at(idx));
+					log("#X# GET-BY-INDEX '%s' (index %d, refcount %d)\n", global_id_storage(idx), idx, int(global_refcount_storage(idx)));
 		#endif
 			}
 			return idx;
 		}
 
+		// returns an unused slot for a new string in the given shard,
+		// called with the shard locked
+		static int new_storage_index(int shard);
+
 		static int get_reference(const char *p)
 		{
 			log_assert(destruct_guard.ok);
@@ -150,50 +258,37 @@ namespace RTLIL
 			if (!p[0])
 				return 0;
 
-			auto it = global_id_index_.find((char*)p);
-			if (it != global_id_index_.end()) {
+			int idx;
+			{
+				storage_shard_t &shard = global_id_shards_[global_id_shard(p)];
+		#ifdef YOSYS_ENABLE_THREADS
+				std::lock_guard<std::mutex> lock(shard.mutex);
+		#endif
+
+				auto it = shard.index.find((char*)p);
+				if (it != shard.index.end()) {
 		#ifndef YOSYS_NO_IDS_REFCNT
-				global_refcount_storage_.at(it->second)++;
+					global_refcount_storage(it->second)++;
 		#endif
 		#ifdef YOSYS_XTRACE_GET_PUT
-				if (yosys_xtrace)
-					log("#X# GET-BY-NAME '%s' (index %d, refcount %d)\n", global_id_storage_.at(it->second), it->second, global_refcount_storage_.at(it->second));
+					if (yosys_xtrace)
+						log("#X# GET-BY-NAME '%s' (index %d, refcount %d)\n", global_id_storage(it->second), it->second, int(global_refcount_storage(it->second)));
 		#endif
-				return it->second;
-			}
+					return it->second;
+				}
 
-			log_assert(p[0] == '$' || p[0] == '\\');
-			log_assert(p[1] != 0);
-			for (const char *c = p; *c; c++)
-				log_assert((unsigned)*c > (unsigned)' ');
+				log_assert(p[0] == '$' || p[0] == '\\');
+				log_assert(p[1] != 0);
+				for (const char *c = p; *c; c++)
+					log_assert((unsigned)*c > (unsigned)' ');
 
+				idx = new_storage_index(&shard - global_id_shards_);
+				global_id_storage(idx) = strdup(p);
+				shard.index[global_id_storage(idx)] = idx;
 		#ifndef YOSYS_NO_IDS_REFCNT
-			if (global_free_idx_list_.empty()) {
-				if (global_id_storage_.empty()) {
-					global_refcount_storage_.push_back(0);
-					global_id_storage_.push_back((char*)"");
-					global_id_index_[global_id_storage_.back()] = 0;
-				}
-				log_assert(global_id_storage_.size() < 0x40000000);
-				global_free_idx_list_.push_back(global_id_storage_.size());
-				global_id_storage_.push_back(nullptr);
-				global_refcount_storage_.push_back(0);
-			}
-
-			int idx = global_free_idx_list_.back();
-			global_free_idx_list_.pop_back();
-			global_id_storage_.at(idx) = strdup(p);
-			global_id_index_[global_id_storage_.at(idx)] = idx;
-			global_refcount_storage_.at(idx)++;
-		#else
-			if (global_id_storage_.empty()) {
-				global_id_storage_.push_back((char*)"");
-				global_id_index_[global_id_storage_.back()] = 0;
-			}
-			int idx = global_id_storage_.size();
-			global_id_storage_.push_back(strdup(p));
-			global_id_index_[global_id_storage_.back()] = idx;
+				global_refcount_storage(idx)++;
 		#endif
+			}
 
 			if (yosys_xtrace) {
 				log("#X# New IdString '%s' with index %d.\n", p, idx);
@@ -202,7 +297,7 @@ namespace RTLIL
 
 		#ifdef YOSYS_XTRACE_GET_PUT
 			if (yosys_xtrace)
-				log("#X# GET-BY-NAME '%s' (index %d, refcount %d)\n", global_id_storage_.at(idx), idx, global_refcount_storage_.at(idx));
+				log("#X# GET-BY-NAME '%s' (index %d, refcount %d)\n", global_id_storage(idx), idx, int(global_refcount_storage(idx)));
 		#endif
 
 		#ifdef YOSYS_USE_STICKY_IDS
@@ -221,19 +316,19 @@ namespace RTLIL
 		static inline void put_reference(int idx)
 		{
 			// put_reference() may be called from destructors after the destructor of
-			// global_refcount_storage_ has been run. in this case we simply do nothing.
+			// global_id_shards_ has been run. in this case we simply do nothing.
 			if (!destruct_guard.ok || !idx)
 				return;
 
 		#ifdef YOSYS_XTRACE_GET_PUT
 			if (yosys_xtrace) {
-				log("#X# PUT '%s' (index %d, refcount %d)\n", global_id_storage_.at(idx), idx, global_refcount_storage_.at(idx));
+				log("#X# PUT '%s' (index %d, refcount %d)\n", global_id_storage(idx), idx, int(global_refcount_storage(idx)));
 			}
 		#endif
 
-			int &refcount = global_refcount_storage_[idx];
+			int refcount = --global_refcount_storage(idx);
 
-			if (--refcount > 0)
+			if (refcount > 0)
 				return;
 
 			log_assert(refcount == 0);
@@ -241,15 +336,24 @@ namespace RTLIL
 		}
 		static inline void free_reference(int idx)
 		{
+			storage_shard_t &shard = global_id_shards_[global_id_shard(idx)];
+		#ifdef YOSYS_ENABLE_THREADS
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			// another thread may have looked up this name by string (and maybe
+			// released it again) after our reference counter reached zero
+			if (global_refcount_storage(idx) != 0 || global_id_storage(idx) == nullptr)
+				return;
+		#endif
+
 			if (yosys_xtrace) {
-				log("#X# Removed IdString '%s' with index %d.\n", global_id_storage_.at(idx), idx);
+				log("#X# Removed IdString '%s' with index %d.\n", global_id_storage(idx), idx);
 				log_backtrace("-X- ", yosys_xtrace-1);
 			}
 
-			global_id_index_.erase(global_id_storage_.at(idx));
-			free(global_id_storage_.at(idx));
-			global_id_storage_.at(idx) = nullptr;
-			global_free_idx_list_.push_back(idx);
+			shard.index.erase(global_id_storage(idx));
+			free(global_id_storage(idx));
+			global_id_storage(idx) = nullptr;
+			shard.free_idx_list.push_back(idx);
 		}
 	#else
 		static inline void put_reference(int) { }
@@ -282,11 +386,11 @@ namespace RTLIL
 		}
 
 		inline const char *c_str() const {
-			return global_id_storage_.at(index_);
+			return index_ ? global_id_storage(index_) : "";
 		}
 
 		inline std::string str() const {
-			return std::string(global_id_storage_.at(index_));
+			return std::string(c_str());
 		}
 
 		inline bool operator<(const IdString &rhs) const {
@@ -620,6 +724,37 @@ namespace RTLIL
 	};
 };
 
+// Word-packed representation of a constant, used by the const_* functions in
+// calc.cc to operate on 64 bits at a time. Bit i of the constant is bit (i%64)
+// of word (i/64) in two planes that follow the RTLIL::State encoding:
+// S0 = (0,0), S1 = (1,0), Sx = (0,1), Sz = (1,1). Sa and Sm are packed as Sx.
+// The undef plane is kept empty for fully defined values, and bits above
+// the width in the last word are always zero.
+struct RTLIL::PackedConst
+{
+	int width;
+	std::vector<uint64_t> val, undef;
+
+	PackedConst() : width(0) { }
+	explicit PackedConst(int width) : width(width), val(num_words(width)) { }
+	explicit PackedConst(const RTLIL::Const &c, int width = -1, bool is_signed = false);
+
+	static inline int num_words(int width) { return (width + 63) / 64; }
+	inline int words() const { return GetSize(val); }
+	inline bool is_fully_def() const { return undef.empty(); }
+
+	inline uint64_t top_mask() const { return width % 64 ? (uint64_t(1) << (width % 64)) - 1 : ~uint64_t(0); }
+	inline uint64_t word_mask(int w) const { return w == words()-1 ? top_mask() : ~uint64_t(0); }
+	inline uint64_t undef_word(int w) const { return undef.empty() ? 0 : undef[w]; }
+	inline RTLIL::State get(int i) const {
+		int w = i / 64, b = i % 64;
+		return RTLIL::State(((val[w] >> b) & 1) | ((undef_word(w) >> b) & 1) << 1);
+	}
+
+	void normalize();
+	RTLIL::Const as_const() const;
+};
+
 struct RTLIL::Const
 {
 	int flags;
@@ -787,24 +922,62 @@ struct RTLIL::SigSpecConstIterator : public std::iterator<std::input_iterator_ta
 struct RTLIL::SigSpec
 {
 private:
+	// The chunks or bits of a SigSpec are shared between its copies until one
+	// of them is modified (copy-on-write), so copying a SigSpec is O(1). Only
+	// one of the two vectors is in use at a time.
+	struct Data
+	{
+#ifdef YOSYS_ENABLE_THREADS
+		std::atomic<int> refcount;
+#else
+		int refcount;
+#endif
+		std::vector<RTLIL::SigChunk> chunks; // LSB at index 0
+		std::vector<RTLIL::SigBit> bits; // LSB at index 0
+
+		Data() : refcount(1) { }
+		Data(const Data &other) : refcount(1), chunks(other.chunks), bits(other.bits) { }
+	};
+
+	// Empty SigSpecs point to this instead of allocating their own Data
+	static Data empty_data_;
+
 	int width_;
 	unsigned long hash_;
-	std::vector<RTLIL::SigChunk> chunks_; // LSB at index 0
-	std::vector<RTLIL::SigBit> bits_; // LSB at index 0
+	Data *data_ = &empty_data_;
 
 	void pack() const;
 	void unpack() const;
 	void updhash() const;
 
 	inline bool packed() const {
-		return bits_.empty();
+		return data_->bits.empty();
 	}
 
 	inline void inline_unpack() const {
-		if (!chunks_.empty())
+		if (!data_->chunks.empty())
 			unpack();
 	}
 
+	inline void retain() const {
+		if (data_ != &empty_data_)
+			data_->refcount++;
+	}
+
+	inline void release() {
+		if (data_ != &empty_data_ && --data_->refcount == 0)
+			delete data_;
+	}
+
+	// Must be called before modifying the chunks or bits, makes sure that
+	// data_ is not shared with another SigSpec
+	inline void detach() {
+		if (data_ == &empty_data_ || data_->refcount != 1)
+			unshare();
+	}
+
+	void unshare();
+
 	// Only used by Module::remove(const pool<Wire*> &wires)
 	// but cannot be more specific as it isn't yet declared
 	friend struct RTLIL::Module;
@@ -832,31 +1005,46 @@ public:
 	SigSpec(RTLIL::SigSpec &&other) {
 		width_ = other.width_;
 		hash_ = other.hash_;
-		chunks_ = std::move(other.chunks_);
-		bits_ = std::move(other.bits_);
+		data_ = other.data_;
+		other.width_ = 0;
+		other.hash_ = 0;
+		other.data_ = &empty_data_;
 	}
 
 	const RTLIL::SigSpec &operator=(RTLIL::SigSpec &&other) {
-		width_ = other.width_;
-		hash_ = other.hash_;
-		chunks_ = std::move(other.chunks_);
-		bits_ = std::move(other.bits_);
+		if (this != &other) {
+			release();
+			width_ = other.width_;
+			hash_ = other.hash_;
+			data_ = other.data_;
+			other.width_ = 0;
+			other.hash_ = 0;
+			other.data_ = &empty_data_;
+		}
 		return *this;
 	}
 
+	~SigSpec() {
+		release();
+	}
+
 	size_t get_hash() const {
 		if (!hash_) hash();
 		return hash_;
 	}
 
-	inline const std::vector<RTLIL::SigChunk> &chunks() const { pack(); return chunks_; }
-	inline const std::vector<RTLIL::SigBit> &bits() const { inline_unpack(); return bits_; }
+	inline const std::vector<RTLIL::SigChunk> &chunks() const { pack(); return data_->chunks; }
+	inline const std::vector<RTLIL::SigBit> &bits() const { inline_unpack(); return data_->bits; }
 
 	inline int size() const { return width_; }
 	inline bool empty() const { return width_ == 0; }
 
-	inline RTLIL::SigBit &operator[](int index) { inline_unpack(); return bits_.at(index); }
-	inline const RTLIL::SigBit &operator[](int index) const { inline_unpack(); return bits_.at(index); }
+	// heap memory used by the chunks or bits, data shared with a SigSpec
+	// that was already passed the same `seen` set is not counted again
+	size_t heap_bytes(pool<const void*, hash_ptr_ops> &seen) const;
+
+	inline RTLIL::SigBit &operator[](int index) { inline_unpack(); detach(); return data_->bits.at(index); }
+	inline const RTLIL::SigBit &operator[](int index) const { inline_unpack(); return data_->bits.at(index); }
 
 	inline RTLIL::SigSpecIterator begin() { RTLIL::SigSpecIterator it; it.sig_p = this; it.index = 0; return it; }
 	inline RTLIL::SigSpecIterator end() { RTLIL::SigSpecIterator it; it.sig_p = this; it.index = width_; return it; }
@@ -908,7 +1096,7 @@ public:
 
 	RTLIL::SigSpec repeat(int num) const;
 
-	void reverse() { inline_unpack(); std::reverse(bits_.begin(), bits_.end()); }
+	void reverse() { inline_unpack(); detach(); std::reverse(data_->bits.begin(), data_->bits.end()); }
 
 	bool operator <(const RTLIL::SigSpec &other) const;
 	bool operator ==(const RTLIL::SigSpec &other) const;
@@ -995,9 +1183,8 @@ struct RTLIL::Monitor
 	unsigned int hash() const { return hashidx_; }
 
 	Monitor() {
-		static unsigned int hashidx_count = 123456789;
-		hashidx_count = mkhash_xorshift(hashidx_count);
-		hashidx_ = hashidx_count;
+		static hashidx_sequence_t hashidx_sequence;
+		hashidx_ = hashidx_sequence.next();
 	}
 
 	virtual ~Monitor() { }
@@ -1032,6 +1219,12 @@ struct RTLIL::Design
 	Design();
 	~Design();
 
+	// A module can be shared by several designs after 'design -save' or
+	// 'design -load' (see share()). Accessing it through modules(), module(),
+	// top_module() or selected_*modules() of one of the designs gives that
+	// design its own copy first, so the returned modules can always be
+	// modified. Pointers from before the module was shared must be fetched
+	// again, and modules_ must only be accessed directly for reading.
 	RTLIL::ObjRange<RTLIL::Module*> modules();
 	RTLIL::Module *module(RTLIL::IdString name);
 	RTLIL::Module *top_module();
@@ -1045,6 +1238,23 @@ struct RTLIL::Design
 	void remove(RTLIL::Module *module);
 	void rename(RTLIL::Module *module, RTLIL::IdString new_name);
 
+	// Add a module of another design without copying it, and give all
+	// modules shared with other designs their own copy in this design.
+	void share(RTLIL::Module *module);
+	void unshare_modules() const;
+
+	// Lets code that only reads the modules, like the evaluation of
+	// selections, use the accessors without copying shared modules.
+	struct ReadOnlyScope
+	{
+		RTLIL::Design *design;
+		ReadOnlyScope(RTLIL::Design *design) : design(design) { design->readonly_scopes_++; }
+		~ReadOnlyScope() { design->readonly_scopes_--; }
+		ReadOnlyScope(const ReadOnlyScope &) = delete;
+		ReadOnlyScope &operator=(const ReadOnlyScope &) = delete;
+	};
+	int readonly_scopes_;
+
 	void scratchpad_unset(const std::string &varname);
 
 	void scratchpad_set_int(const std::string &varname, int value);
@@ -1118,9 +1328,20 @@ protected:
 	void add(RTLIL::Wire *wire);
 	void add(RTLIL::Cell *cell);
 
+	// storage for the wires and cells of this module, see kernel/arena.h
+	ObjectArena<RTLIL::Wire> wire_arena_;
+	ObjectArena<RTLIL::Cell> cell_arena_;
+	void destroy(RTLIL::Wire *wire);
+	void destroy(RTLIL::Cell *cell);
+
 public:
 	RTLIL::Design *design;
 	pool<RTLIL::Monitor*> monitors;
+	ModuleSigMap *sigmap_;
+
+	// the designs other than `design` that share this module, see
+	// Design::share()
+	std::vector<RTLIL::Design*> shared_designs_;
 
 	int refcount_wires_;
 	int refcount_cells_;
@@ -1152,14 +1373,26 @@ public:
 	void new_connections(const std::vector<RTLIL::SigSig> &new_conn);
 	const std::vector<RTLIL::SigSig> &connections() const;
 
+	// SigMap for the connections of this module, kept up to date while the
+	// module is modified (see ModuleSigMap in kernel/sigtools.h). Call it
+	// again after changing the connections or removing wires instead of
+	// keeping the reference. Passes that add their own mappings must make
+	// a copy.
+	const SigMap &sigmap();
+
 	std::vector<RTLIL::IdString> ports;
 	void fixup_ports();
 
 	template<typename T> void rewrite_sigspecs(T &functor);
 	template<typename T> void rewrite_sigspecs2(T &functor);
+	void notify_connections_rewritten();
 	void cloneInto(RTLIL::Module *new_mod) const;
 	virtual RTLIL::Module *clone() const;
 
+	// Keep this module for the given design and give the other designs that
+	// share it a copy.
+	void unshare(const RTLIL::Design *keeper);
+
 	bool has_memories() const;
 	bool has_processes() const;
 
@@ -1182,6 +1415,9 @@ public:
 		return it == cells_.end() ? nullptr : it->second;
 	}
 
+	ArenaStats wire_arena_stats() const { return wire_arena_.stats(); }
+	ArenaStats cell_arena_stats() const { return cell_arena_.stats(); }
+
 	RTLIL::ObjRange<RTLIL::Wire*> wires() { return RTLIL::ObjRange<RTLIL::Wire*>(&wires_, &refcount_wires_); }
 	RTLIL::ObjRange<RTLIL::Cell*> cells() { return RTLIL::ObjRange<RTLIL::Cell*>(&cells_, &refcount_cells_); }
 
@@ -1615,6 +1851,7 @@ void RTLIL::Module::rewrite_sigspecs(T &functor)
 		functor(it.first);
 		functor(it.second);
 	}
+	notify_connections_rewritten();
 }
 
 template<typename T>
@@ -1627,6 +1864,7 @@ void RTLIL::Module::rewrite_sigspecs2(T &functor)
 	for (auto &it : connections_) {
 		functor(it.first, it.second);
 	}
+	notify_connections_rewritten();
 }
 
 template<typename T>
@@ -61,6 +61,19 @@ struct ezSatPtr : public std::unique_ptr<ezSAT> {
 	ezSatPtr() : unique_ptr<ezSAT>(yosys_satsolver->create()) { }
 };
 
+// Selects the SAT solver that ezSatPtr creates while this object is alive,
+// e.g. for the duration of a pass with a -satsolver option. The name is one
+// of the registered solvers or "cmdline:<command>" for an external DIMACS
+// solver. An empty name keeps the current solver.
+struct SatSolverScope
+{
+	SatSolver *prev_solver;
+	std::unique_ptr<SatSolver> cmdline_solver;
+
+	SatSolverScope(const std::string &name);
+	~SatSolverScope();
+};
+
 struct SatGen
 {
 	ezSAT *ez;
@@ -69,30 +82,50 @@ struct SatGen
 	SigPool initial_state;
 	std::map<std::string, RTLIL::SigSpec> asserts_a, asserts_en;
 	std::map<std::string, RTLIL::SigSpec> assumes_a, assumes_en;
-	std::map<std::string, std::map<RTLIL::SigBit, int>> imported_signals;
 	std::map<std::pair<std::string, int>, bool> initstates;
 	bool ignore_div_by_zero;
 	bool model_undef;
 
+	// Give the literals of imported signals names like "prefix@step:wire [idx]"
+	// (see ezSAT::printInternalState()). Only meant for debugging, as building
+	// the names is much slower than the numeric lookup.
+	bool named_literals;
+
+	// Literals of the imported signals, by (context, timestep, bit). The
+	// context stands for the prefix and whether the bit is the undef bit.
+	dict<std::tuple<int, int, RTLIL::SigBit>, int> imported_signals;
+	dict<std::string, int> prefix_ids;
+	int prefix_id;
+
 	SatGen(ezSAT *ez, SigMap *sigmap, std::string prefix = std::string()) :
-			ez(ez), sigmap(sigmap), prefix(prefix), ignore_div_by_zero(false), model_undef(false)
+			ez(ez), sigmap(sigmap), ignore_div_by_zero(false), model_undef(false), named_literals(false)
 	{
+		setContext(sigmap, prefix);
 	}
 
 	void setContext(SigMap *sigmap, std::string prefix = std::string())
 	{
 		this->sigmap = sigmap;
 		this->prefix = prefix;
+		prefix_id = prefix_ids.insert(std::make_pair(prefix, GetSize(prefix_ids))).first->second;
 	}
 
-	std::vector<int> importSigSpecWorker(RTLIL::SigSpec sig, std::string &pf, bool undef_mode, bool dup_undef)
+	std::string literalName(RTLIL::SigBit bit, int timestep, bool undef_mode)
 	{
+		std::string pf = (undef_mode ? "undef:" : "") + prefix + (timestep == -1 ? "" : stringf("@%d:", timestep));
+		return pf + (bit.wire->width == 1 ? stringf("%s", log_id(bit.wire)) : stringf("%s [%d]", log_id(bit.wire->name), bit.offset));
+	}
+
+	std::vector<int> importSigSpecWorker(RTLIL::SigSpec sig, int timestep, bool undef_mode, bool dup_undef)
+	{
+		log_assert(timestep != 0);
 		log_assert(!undef_mode || model_undef);
 		sigmap->apply(sig);
 
 		std::vector<int> vec;
 		vec.reserve(GetSize(sig));
 
+		int context = 2*prefix_id + undef_mode;
 		for (auto &bit : sig)
 			if (bit.wire == NULL) {
 				if (model_undef && dup_undef && bit == RTLIL::State::Sx)
@@ -100,60 +133,48 @@ struct SatGen
 				else
 					vec.push_back(bit == (undef_mode ? RTLIL::State::Sx : RTLIL::State::S1) ? ez->CONST_TRUE : ez->CONST_FALSE);
 			} else {
-				std::string name = pf + (bit.wire->width == 1 ? stringf("%s", log_id(bit.wire)) : stringf("%s [%d]", log_id(bit.wire->name), bit.offset));
-				vec.push_back(ez->frozen_literal(name));
-				imported_signals[pf][bit] = vec.back();
+				auto it = imported_signals.insert(std::make_pair(std::make_tuple(context, timestep, bit), 0));
+				if (it.second)
+					it.first->second = named_literals ? ez->frozen_literal(literalName(bit, timestep, undef_mode)) : ez->frozen_literal();
+				vec.push_back(it.first->second);
 			}
 		return vec;
 	}
 
 	std::vector<int> importSigSpec(RTLIL::SigSpec sig, int timestep = -1)
 	{
-		log_assert(timestep != 0);
-		std::string pf = prefix + (timestep == -1 ? "" : stringf("@%d:", timestep));
-		return importSigSpecWorker(sig, pf, false, false);
+		return importSigSpecWorker(sig, timestep, false, false);
 	}
 
 	std::vector<int> importDefSigSpec(RTLIL::SigSpec sig, int timestep = -1)
 	{
-		log_assert(timestep != 0);
-		std::string pf = prefix + (timestep == -1 ? "" : stringf("@%d:", timestep));
-		return importSigSpecWorker(sig, pf, false, true);
+		return importSigSpecWorker(sig, timestep, false, true);
 	}
 
 	std::vector<int> importUndefSigSpec(RTLIL::SigSpec sig, int timestep = -1)
 	{
-		log_assert(timestep != 0);
-		std::string pf = "undef:" + prefix + (timestep == -1 ? "" : stringf("@%d:", timestep));
-		return importSigSpecWorker(sig, pf, true, false);
+		return importSigSpecWorker(sig, timestep, true, false);
 	}
 
 	int importSigBit(RTLIL::SigBit bit, int timestep = -1)
 	{
-		log_assert(timestep != 0);
-		std::string pf = prefix + (timestep == -1 ? "" : stringf("@%d:", timestep));
-		return importSigSpecWorker(bit, pf, false, false).front();
+		return importSigSpecWorker(bit, timestep, false, false).front();
 	}
 
 	int importDefSigBit(RTLIL::SigBit bit, int timestep = -1)
 	{
-		log_assert(timestep != 0);
-		std::string pf = prefix + (timestep == -1 ? "" : stringf("@%d:", timestep));
-		return importSigSpecWorker(bit, pf, false, true).front();
+		return importSigSpecWorker(bit, timestep, false, true).front();
 	}
 
 	int importUndefSigBit(RTLIL::SigBit bit, int timestep = -1)
 	{
-		log_assert(timestep != 0);
-		std::string pf = "undef:" + prefix + (timestep == -1 ? "" : stringf("@%d:", timestep));
-		return importSigSpecWorker(bit, pf, true, false).front();
+		return importSigSpecWorker(bit, timestep, true, false).front();
 	}
 
 	bool importedSigBit(RTLIL::SigBit bit, int timestep = -1)
 	{
 		log_assert(timestep != 0);
-		std::string pf = prefix + (timestep == -1 ? "" : stringf("@%d:", timestep));
-		return imported_signals[pf].count(bit) != 0;
+		return imported_signals.count(std::make_tuple(2*prefix_id, timestep, bit)) != 0;
 	}
 
 	void getAsserts(RTLIL::SigSpec &sig_a, RTLIL::SigSpec &sig_en, int timestep = -1)
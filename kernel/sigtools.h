@@ -342,6 +342,61 @@ struct SigMap
 	}
 };
 
+// The SigMap returned by RTLIL::Module::sigmap(). It is attached to the module
+// as a monitor and merges the bits of each new connection as it is added,
+// which gives the same result as rebuilding it with SigMap::set(). Changes
+// that can split nets (replacing or rewriting the connections, removing
+// wires, blackout) invalidate it, and it is rebuilt on the next access.
+struct ModuleSigMap : RTLIL::Monitor
+{
+	RTLIL::Module *module;
+	SigMap sigmap;
+	bool valid;
+
+	ModuleSigMap(RTLIL::Module *module) : module(module), valid(false)
+	{
+		module->monitors.insert(this);
+	}
+
+	~ModuleSigMap()
+	{
+		module->monitors.erase(this);
+	}
+
+	const SigMap &get()
+	{
+		if (!valid) {
+			sigmap.set(module);
+			valid = true;
+		}
+		return sigmap;
+	}
+
+	void notify_connect(RTLIL::Module*, const RTLIL::SigSig &conn) override
+	{
+		// Module::connect() calls itself again without the bits that have
+		// a constant on the left hand side, those connections are ignored.
+		if (valid && !conn.first.has_const())
+			sigmap.add(conn.first, conn.second);
+	}
+
+	void invalidate()
+	{
+		sigmap.clear();
+		valid = false;
+	}
+
+	void notify_connect(RTLIL::Module*, const std::vector<RTLIL::SigSig>&) override
+	{
+		invalidate();
+	}
+
+	void notify_blackout(RTLIL::Module*) override
+	{
+		invalidate();
+	}
+};
+
 YOSYS_NAMESPACE_END
 
 #endif /* SIGTOOLS_H */
@@ -0,0 +1,179 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/threading.h"
+#include "kernel/profile.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+int yosys_threads = 1;
+
+#ifdef YOSYS_ENABLE_THREADS
+// returns the modules grouped by their depth in the hierarchy below them,
+// or an empty vector if the instances form a loop
+static std::vector<std::vector<int>> module_levels(const std::vector<RTLIL::Module*> &modules)
+{
+	dict<RTLIL::IdString, int> module_index;
+	for (int i = 0; i < GetSize(modules); i++)
+		module_index[modules[i]->name] = i;
+
+	std::vector<int> level(GetSize(modules), -1);
+	bool found_loop = false;
+
+	std::function<int(int)> get_level = [&](int i) -> int {
+		if (level[i] == -2)
+			found_loop = true;
+		if (level[i] < 0 && !found_loop) {
+			level[i] = -2;
+			int l = 0;
+			for (auto cell : modules[i]->cells()) {
+				auto it = module_index.find(cell->type);
+				if (it != module_index.end())
+					l = std::max(l, get_level(it->second) + 1);
+			}
+			level[i] = l;
+		}
+		return level[i];
+	};
+
+	std::vector<std::vector<int>> levels;
+	for (int i = 0; i < GetSize(modules); i++) {
+		int l = get_level(i);
+		if (found_loop)
+			return std::vector<std::vector<int>>();
+		if (l >= GetSize(levels))
+			levels.resize(l+1);
+		levels[l].push_back(i);
+	}
+	return levels;
+}
+#endif
+
+#ifdef YOSYS_ENABLE_THREADS
+// run the tasks level by level, each level on up to the given number of threads
+static void run_levels(const std::vector<std::vector<int>> &levels, int n, int threads,
+		const std::function<void(int)> &worker, const std::function<std::string(int)> &task_name)
+{
+	std::vector<LogCapture> captures(n);
+	std::vector<std::exception_ptr> exceptions(n);
+	std::vector<int> autoidx_end(n, autoidx);
+	std::vector<char> done(n), failed(n);
+	std::atomic<bool> stop(false);
+
+	for (auto &level : levels)
+	{
+		if (stop)
+			break;
+
+		// tasks are picked in order, so when a task fails all tasks with a
+		// lower index on this level have been started and will complete
+		std::atomic<int> next_task(0);
+		auto thread_main = [&](int t) {
+			int k;
+			profile_thread = t+1;
+			while (!stop && (k = next_task++) < GetSize(level)) {
+				int i = level[k];
+				int local_autoidx = autoidx;
+				autoidx_local = &local_autoidx;
+				captures[i].start();
+				int profile_index = profile_enabled ? profile_begin(task_name(i), std::string(), "worker") : -1;
+				try {
+					worker(i);
+				} catch (log_capture_error_exception&) {
+					failed[i] = true;
+				} catch (...) {
+					exceptions[i] = std::current_exception();
+					failed[i] = true;
+				}
+				profile_end(profile_index);
+				captures[i].stop();
+				autoidx_local = nullptr;
+				autoidx_end[i] = local_autoidx;
+				done[i] = true;
+				if (failed[i])
+					stop = true;
+			}
+		};
+
+		std::vector<std::thread> pool;
+		for (int t = 0; t < std::min(threads, GetSize(level)); t++)
+			pool.emplace_back(thread_main, t);
+		for (auto &th : pool)
+			th.join();
+	}
+
+	for (int i = 0; i < n; i++)
+		autoidx = std::max(autoidx, autoidx_end[i]);
+
+	// replay everything up to and including the first failed task
+	for (int i = 0; i < n; i++) {
+		if (!done[i])
+			continue;
+		captures[i].replay();
+		if (exceptions[i])
+			std::rethrow_exception(exceptions[i]);
+		if (failed[i])
+			break;
+	}
+}
+#endif
+
+void parallel_for_modules(RTLIL::Design *design, const std::vector<RTLIL::Module*> &modules, int threads,
+		const std::function<void(int)> &worker)
+{
+#ifdef YOSYS_ENABLE_THREADS
+	std::vector<std::vector<int>> levels;
+	if (threads > 1 && GetSize(modules) > 1 && design->monitors.empty())
+		levels = module_levels(modules);
+
+	if (!levels.empty()) {
+		// the workers may look up any module of the design, which must not
+		// copy modules shared with saved designs concurrently
+		design->unshare_modules();
+		run_levels(levels, GetSize(modules), threads, worker, [&](int i) { return RTLIL::unescape_id(modules[i]->name); });
+		return;
+	}
+#else
+	(void)design;
+	(void)threads;
+#endif
+
+	for (int i = 0; i < GetSize(modules); i++)
+		worker(i);
+}
+
+void parallel_for(int n, int threads, const std::function<void(int)> &worker)
+{
+#ifdef YOSYS_ENABLE_THREADS
+	if (threads > 1 && n > 1) {
+		std::vector<std::vector<int>> levels(1);
+		for (int i = 0; i < n; i++)
+			levels[0].push_back(i);
+		run_levels(levels, n, threads, worker, [](int i) { return stringf("task %d", i); });
+		return;
+	}
+#else
+	(void)threads;
+#endif
+
+	for (int i = 0; i < n; i++)
+		worker(i);
+}
+
+YOSYS_NAMESPACE_END
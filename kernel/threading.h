@@ -0,0 +1,55 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef THREADING_H
+#define THREADING_H
+
+#include "kernel/yosys.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// default for the -threads option of passes that use parallel_for_modules(),
+// set with the -j command line option
+extern int yosys_threads;
+
+// Call worker(i) for each module modules[i], using up to the given number of
+// threads. A module is never processed at the same time as a module it
+// instantiates, so workers can look at the ports of other modules, but must
+// not modify anything outside of their own module (in particular they must
+// not touch the design scratchpad).
+//
+// Log output of the workers is written to the log in the order of the
+// modules after all of them are done, so it does not depend on the number
+// of threads. In parallel mode, each worker numbers its NEW_ID names starting
+// from the same autoidx value, so the names only depend on the module.
+//
+// The workers run one after another on the calling thread if threads < 2,
+// if Yosys was built without thread support, or if there are monitors
+// attached to the design.
+void parallel_for_modules(RTLIL::Design *design, const std::vector<RTLIL::Module*> &modules, int threads,
+		const std::function<void(int)> &worker);
+
+// Call worker(i) for i = 0 .. n-1, using up to the given number of threads.
+// The tasks must be independent of each other and must not modify the design.
+// Log output and NEW_ID numbering are handled like in parallel_for_modules().
+void parallel_for(int n, int threads, const std::function<void(int)> &worker);
+
+YOSYS_NAMESPACE_END
+
+#endif
@@ -0,0 +1,387 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/vcdreader.h"
+
+#if defined(_WIN32) || defined(__wasm)
+#  define VCDREADER_NO_MMAP
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+YOSYS_NAMESPACE_BEGIN
+
+// consumed parts of a mapped file are handed back to the OS in this granularity
+static const size_t release_granularity = 64 << 20;
+
+static const size_t chunk_size = 1 << 20;
+
+VcdReader::VcdReader(const std::string &filename) : filename(filename)
+{
+#ifndef VCDREADER_NO_MMAP
+	fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		log_error("Can't open VCD file `%s' for reading: %s\n", filename.c_str(), strerror(errno));
+
+	struct stat st;
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+		void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p != MAP_FAILED) {
+			data = (char*)p;
+			data_size = st.st_size;
+			madvise(data, data_size, MADV_SEQUENTIAL);
+			pos = data;
+			end = data + data_size;
+		}
+	}
+
+	// Fall back to reading in chunks, e.g. for pipes
+	if (data == nullptr) {
+		file = fdopen(fd, "rb");
+		fd = -1;
+	}
+#else
+	file = fopen(filename.c_str(), "rb");
+	if (file == nullptr)
+		log_error("Can't open VCD file `%s' for reading: %s\n", filename.c_str(), strerror(errno));
+#endif
+
+	if (file != nullptr) {
+		buffer.resize(chunk_size);
+		pos = end = buffer.data();
+	}
+
+	parse_header();
+}
+
+VcdReader::~VcdReader()
+{
+#ifndef VCDREADER_NO_MMAP
+	if (data != nullptr)
+		munmap(data, data_size);
+	if (fd >= 0)
+		close(fd);
+#endif
+	if (file != nullptr)
+		fclose(file);
+}
+
+// Reads more data in chunked mode, keeping the bytes from start on in the
+// buffer. Returns false at the end of the file (and always in mmap mode).
+bool VcdReader::refill(const char *&start)
+{
+	if (file == nullptr)
+		return false;
+
+	size_t offset = start - buffer.data();
+	size_t keep = end - start;
+
+	if (2*keep > buffer.size())
+		buffer.resize(2*buffer.size());
+
+	memmove(buffer.data(), buffer.data() + offset, keep);
+	size_t n = fread(buffer.data() + keep, 1, buffer.size() - keep, file);
+
+	start = buffer.data();
+	end = start + keep + n;
+	return n > 0;
+}
+
+// Returns the next whitespace-separated token. The token stays valid until
+// the next call.
+bool VcdReader::next_token(const char *&token, int &len)
+{
+	while (1) {
+		while (pos < end && isspace((unsigned char)*pos))
+			pos++;
+		if (pos < end)
+			break;
+		if (!refill(pos))
+			return false;
+	}
+
+	const char *start = pos;
+	while (1) {
+		while (pos < end && !isspace((unsigned char)*pos))
+			pos++;
+		if (pos < end)
+			break;
+		size_t n = pos - start;
+		if (!refill(start))
+			break;
+		pos = start + n;
+	}
+
+	token = start;
+	len = pos - start;
+	return true;
+}
+
+static bool token_is(const char *token, int len, const char *str)
+{
+	return len == (int)strlen(str) && memcmp(token, str, len) == 0;
+}
+
+void VcdReader::skip_to_end()
+{
+	const char *token;
+	int len;
+
+	while (next_token(token, len))
+		if (token_is(token, len, "$end"))
+			return;
+
+	log_error("Unexpected end of VCD file `%s'.\n", filename.c_str());
+}
+
+static int64_t pack_id(const char *id, int len)
+{
+	// identifier codes only use the printable ASCII range
+	int64_t key = 0;
+	for (int i = 0; i < len; i++)
+		key = (key << 8) | (id[i] & 0x7f);
+	return key;
+}
+
+int VcdReader::lookup_id(const char *id, int len) const
+{
+	if (len <= 8) {
+		auto it = short_ids.find(pack_id(id, len));
+		return it == short_ids.end() ? -1 : it->second;
+	}
+	auto it = long_ids.find(std::string(id, len));
+	return it == long_ids.end() ? -1 : it->second;
+}
+
+void VcdReader::parse_header()
+{
+	std::vector<std::string> scopes;
+	const char *token;
+	int len;
+
+	while (1)
+	{
+		if (!next_token(token, len))
+			log_error("Unexpected end of VCD file `%s' in the header.\n", filename.c_str());
+
+		if (token_is(token, len, "$enddefinitions")) {
+			skip_to_end();
+			break;
+		}
+
+		if (token_is(token, len, "$timescale")) {
+			while (next_token(token, len) && !token_is(token, len, "$end"))
+				timescale += std::string(token, len);
+			continue;
+		}
+
+		if (token_is(token, len, "$scope")) {
+			std::vector<std::string> args;
+			while (next_token(token, len) && !token_is(token, len, "$end"))
+				args.push_back(std::string(token, len));
+			if (args.empty())
+				log_error("Malformed $scope in VCD file `%s'.\n", filename.c_str());
+			scopes.push_back(args.back());
+			continue;
+		}
+
+		if (token_is(token, len, "$upscope")) {
+			if (scopes.empty())
+				log_error("Unbalanced $upscope in VCD file `%s'.\n", filename.c_str());
+			scopes.pop_back();
+			skip_to_end();
+			continue;
+		}
+
+		if (token_is(token, len, "$var"))
+		{
+			std::vector<std::string> args;
+			while (next_token(token, len) && !token_is(token, len, "$end"))
+				args.push_back(std::string(token, len));
+			if (GetSize(args) < 4)
+				log_error("Malformed $var in VCD file `%s'.\n", filename.c_str());
+
+			Var var;
+			for (auto &scope : scopes)
+				var.scope += (var.scope.empty() ? "" : ".") + scope;
+			var.name = args[3];
+			var.width = atoi(args[1].c_str());
+			var.msb = var.lsb = -1;
+
+			std::string range = GetSize(args) > 4 ? args[4] : std::string();
+			size_t bracket = var.name.find('[');
+			if (range.empty() && bracket != std::string::npos && bracket > 0) {
+				range = var.name.substr(bracket);
+				var.name = var.name.substr(0, bracket);
+			}
+			if (!range.empty() && range[0] == '[') {
+				const char *p = range.c_str() + 1;
+				char *q;
+				var.msb = var.lsb = strtol(p, &q, 10);
+				if (*q == ':')
+					var.lsb = strtol(q + 1, &q, 10);
+			}
+
+			const std::string &id = args[2];
+			var.signal = lookup_id(id.data(), GetSize(id));
+			if (var.signal < 0) {
+				var.signal = GetSize(widths);
+				if (GetSize(id) <= 8)
+					short_ids[pack_id(id.data(), GetSize(id))] = var.signal;
+				else
+					long_ids[id] = var.signal;
+				widths.push_back(var.width);
+			}
+
+			vars.push_back(var);
+			continue;
+		}
+
+		if (token[0] == '$') {
+			skip_to_end();
+			continue;
+		}
+
+		log_error("Unexpected token `%s' in the header of VCD file `%s'.\n", std::string(token, len).c_str(), filename.c_str());
+	}
+
+	watched.resize(GetSize(widths));
+	values.resize(GetSize(widths));
+	changed_step.resize(GetSize(widths), -1);
+}
+
+void VcdReader::watch(int signal)
+{
+	if (watched.at(signal))
+		return;
+
+	watched[signal] = true;
+	values[signal] = Const(State::Sx, widths[signal]);
+}
+
+static State vcd_state(char c)
+{
+	switch (c) {
+		case '0': return State::S0;
+		case '1': return State::S1;
+		case 'z': case 'Z': return State::Sz;
+		default: return State::Sx;
+	}
+}
+
+void VcdReader::set_value(const char *id, int id_len, const char *bits, int len)
+{
+	int signal = lookup_id(id, id_len);
+	if (signal < 0)
+		log_error("Unknown identifier code `%s' in VCD file `%s'.\n", std::string(id, id_len).c_str(), filename.c_str());
+
+	if (!watched[signal])
+		return;
+
+	// Values are written MSB first. Shorter values are extended with
+	// their leftmost bit if it is x or z, and with zeros otherwise.
+	Const &value = values[signal];
+	int width = GetSize(value);
+	State pad = len > 0 && (bits[0] == 'x' || bits[0] == 'X' || bits[0] == 'z' || bits[0] == 'Z') ? vcd_state(bits[0]) : State::S0;
+
+	for (int i = 0; i < width; i++)
+		value.bits[i] = i < len ? vcd_state(bits[len - 1 - i]) : pad;
+
+	changed_step[signal] = num_steps;
+}
+
+static int64_t parse_time(const char *p, int len)
+{
+	int64_t t = 0;
+	for (int i = 0; i < len && p[i] >= '0' && p[i] <= '9'; i++)
+		t = 10*t + (p[i] - '0');
+	return t;
+}
+
+void VcdReader::release_consumed()
+{
+#ifndef VCDREADER_NO_MMAP
+	if (data == nullptr)
+		return;
+
+	size_t consumed = (pos - data) & ~(size_t(sysconf(_SC_PAGESIZE)) - 1);
+	if (consumed - released >= release_granularity) {
+		madvise(data + released, consumed - released, MADV_DONTNEED);
+		released = consumed;
+	}
+#endif
+}
+
+bool VcdReader::step(int64_t &t)
+{
+	const char *token;
+	int len;
+	bool got_time = false;
+
+	num_steps++;
+
+	while (next_token(token, len))
+	{
+		char c = token[0];
+
+		if (c == '#') {
+			if (got_time) {
+				pos = token;
+				break;
+			}
+			time = parse_time(token + 1, len - 1);
+			got_time = true;
+			continue;
+		}
+
+		if (c == '$') {
+			// $dumpvars, $dumpall etc. only wrap value changes
+			if (token_is(token, len, "$comment"))
+				skip_to_end();
+			continue;
+		}
+
+		if (c == 'b' || c == 'B' || c == 'r' || c == 'R' || c == 's' || c == 'S') {
+			vector_value.assign(token + 1, len - 1);
+			if (!next_token(token, len))
+				log_error("Unexpected end of VCD file `%s'.\n", filename.c_str());
+			if (c == 'b' || c == 'B')
+				set_value(token, len, vector_value.data(), GetSize(vector_value));
+			continue;
+		}
+
+		if (strchr("01xXzZ", c) != nullptr && len > 1) {
+			set_value(token + 1, len - 1, token, 1);
+			continue;
+		}
+
+		log_error("Unexpected token `%s' in VCD file `%s'.\n", std::string(token, len).c_str(), filename.c_str());
+	}
+
+	release_consumed();
+
+	if (got_time)
+		t = time;
+	return got_time;
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,98 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef VCDREADER_H
+#define VCDREADER_H
+
+#include "kernel/yosys.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// Streaming reader for VCD files. The file is memory-mapped (or read in
+// chunks where mmap is not available) and parsed one time step at a time,
+// so only the current value of each watched signal is kept in memory.
+struct VcdReader
+{
+	struct Var
+	{
+		// hierarchical scope name, with the scope names separated by '.'
+		std::string scope;
+		// reference name without the bit range
+		std::string name;
+		int width;
+		// bit range from the reference, or -1 if the reference has none
+		int msb, lsb;
+		// index of the value, vars with the same identifier code share it
+		int signal;
+	};
+
+	std::string timescale;
+	std::vector<Var> vars;
+
+	// Opens the file and parses the header, calls log_error() on failure.
+	VcdReader(const std::string &filename);
+	~VcdReader();
+
+	// Only changes of watched signals are decoded, all others are skipped.
+	void watch(int signal);
+
+	// Reads the next time step, i.e. the next timestamp and all value
+	// changes following it. Changes before the first timestamp are part
+	// of the first step. Returns false at the end of the file.
+	bool step(int64_t &time);
+
+	// Current value of a watched signal, all-x before the first change
+	const Const &value(int signal) const { return values.at(signal); }
+
+	// Returns true if the signal changed in the last step
+	bool changed(int signal) const { return changed_step.at(signal) == num_steps; }
+
+private:
+	std::string filename;
+	std::string vector_value;
+	int fd = -1;
+	FILE *file = nullptr;
+	char *data = nullptr;
+	size_t data_size = 0;
+	std::vector<char> buffer;
+	const char *pos = nullptr, *end = nullptr;
+	size_t released = 0;
+
+	// identifier codes of up to 8 characters are packed into an integer
+	dict<int64_t, int> short_ids;
+	dict<std::string, int> long_ids;
+	std::vector<int> widths;
+	std::vector<bool> watched;
+	std::vector<Const> values;
+	std::vector<int> changed_step;
+	int num_steps = 0;
+	int64_t time = 0;
+
+	bool refill(const char *&start);
+	bool next_token(const char *&token, int &len);
+	void skip_to_end();
+	void parse_header();
+	int lookup_id(const char *id, int len) const;
+	void set_value(const char *id, int id_len, const char *bits, int len);
+	void release_consumed();
+};
+
+YOSYS_NAMESPACE_END
+
+#endif
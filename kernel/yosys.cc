@@ -19,6 +19,7 @@
 
 #include "kernel/yosys.h"
 #include "kernel/celltypes.h"
+#include "kernel/profile.h"
 
 #ifdef YOSYS_ENABLE_READLINE
 #  include <readline/readline.h>
@@ -75,6 +76,9 @@
 YOSYS_NAMESPACE_BEGIN
 
 int autoidx = 1;
+#ifdef YOSYS_ENABLE_THREADS
+thread_local int *autoidx_local;
+#endif
 int yosys_xtrace = 0;
 RTLIL::Design *yosys_design = NULL;
 CellTypes yosys_celltypes;
@@ -341,6 +345,11 @@ bool patmatch(const char *pattern, const char *string)
 #if !defined(YOSYS_DISABLE_SPAWN)
 int run_command(const std::string &command, std::function<void(const std::string&)> process_line)
 {
+	// the entry covers the time spent waiting for the program
+	size_t program_begin = std::min(command.find_first_not_of(' '), command.size());
+	std::string program = command.substr(program_begin, command.find(' ', program_begin) - program_begin);
+	ProfileScope profile(program.substr(program.find_last_of("/\\") + 1), command, "exec");
+
 	if (!process_line)
 		return system(command.c_str());
 
@@ -605,7 +614,19 @@ RTLIL::IdString new_id(std::string file, int line, std::string func)
 	if (pos != std::string::npos)
 		func = func.substr(pos+1);
 
-	return stringf("$auto$%s:%d:%s$%d", file.c_str(), line, func.c_str(), autoidx++);
+	return stringf("$auto$%s:%d:%s$%d", file.c_str(), line, func.c_str(), next_autoidx());
+}
+
+int next_autoidx()
+{
+#ifdef YOSYS_ENABLE_THREADS
+	if (autoidx_local != nullptr)
+		return (*autoidx_local)++;
+
+	static std::mutex autoidx_mutex;
+	std::lock_guard<std::mutex> lock(autoidx_mutex);
+#endif
+	return autoidx++;
 }
 
 RTLIL::Design *yosys_get_design()
@@ -931,6 +952,8 @@ void run_frontend(std::string filename, std::string command, std::string *backen
 			command = "json";
 		else if (filename_trim.size() > 3 && filename_trim.compare(filename_trim.size()-3, std::string::npos, ".il") == 0)
 			command = "rtlil";
+		else if (filename_trim.size() > 4 && filename_trim.compare(filename_trim.size()-4, std::string::npos, ".yss") == 0)
+			command = "snapshot";
 		else if (filename_trim.size() > 3 && filename_trim.compare(filename_trim.size()-3, std::string::npos, ".ys") == 0)
 			command = "script";
 		else if (filename_trim.size() > 3 && filename_trim.compare(filename_trim.size()-4, std::string::npos, ".tcl") == 0)
@@ -959,6 +982,7 @@ void run_frontend(std::string filename, std::string command, std::string *backen
 		}
 
 		log("\n-- Executing script file `%s' --\n", filename.c_str());
+		ProfileScope profile("script", filename);
 
 		FILE *f = stdin;
 
@@ -1054,6 +1078,8 @@ void run_backend(std::string filename, std::string command, RTLIL::Design *desig
 			command = "verilog -sv";
 		else if (filename.size() > 3 && filename.compare(filename.size()-3, std::string::npos, ".il") == 0)
 			command = "rtlil";
+		else if (filename.size() > 4 && filename.compare(filename.size()-4, std::string::npos, ".yss") == 0)
+			command = "snapshot";
 		else if (filename.size() > 3 && filename.compare(filename.size()-3, std::string::npos, ".cc") == 0)
 			command = "cxxrtl";
 		else if (filename.size() > 4 && filename.compare(filename.size()-4, std::string::npos, ".aig") == 0)
@@ -71,6 +71,12 @@
 #include <Python.h>
 #endif
 
+#ifdef YOSYS_ENABLE_THREADS
+#  include <atomic>
+#  include <mutex>
+#  include <thread>
+#endif
+
 #ifndef _YOSYS_
 #  error It looks like you are trying to build Yosys without the config defines set. \
          When building Yosys with a custom make system, make sure you set all the \
@@ -162,6 +168,12 @@ extern Tcl_Obj *Tcl_ObjSetVar2(Tcl_Interp *interp, Tcl_Obj *part1Ptr, Tcl_Obj *p
 #  define YS_FALLTHROUGH
 #endif
 
+#ifdef YOSYS_ENABLE_THREADS
+#  define YS_THREAD_LOCAL thread_local
+#else
+#  define YS_THREAD_LOCAL
+#endif
+
 YOSYS_NAMESPACE_BEGIN
 
 // Note: All headers included in hashlib.h must be included
@@ -206,6 +218,8 @@ using hashlib::hash_ops;
 using hashlib::hash_cstr_ops;
 using hashlib::hash_ptr_ops;
 using hashlib::hash_obj_ops;
+using hashlib::hash_chained;
+using hashlib::hash_probed;
 using hashlib::dict;
 using hashlib::idict;
 using hashlib::pool;
@@ -287,6 +301,15 @@ int GetSize(RTLIL::Wire *wire);
 extern int autoidx;
 extern int yosys_xtrace;
 
+#ifdef YOSYS_ENABLE_THREADS
+// when set, new_id() on this thread counts here instead of in autoidx
+// (see parallel_for_modules() in kernel/threading.h)
+extern thread_local int *autoidx_local;
+#endif
+
+// returns autoidx++, or the next value of autoidx_local in a worker thread
+int next_autoidx();
+
 YOSYS_NAMESPACE_END
 
 #include "kernel/log.h"
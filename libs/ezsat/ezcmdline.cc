@@ -0,0 +1,91 @@
+/*
+ *  ezSAT -- A simple and easy to use CNF generator for SAT solvers
+ *
+ *  Copyright (C) 2013  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/yosys.h"
+#include "ezcmdline.h"
+
+ezCmdlineSAT::ezCmdlineSAT(const std::string &command) : command(command)
+{
+}
+
+ezCmdlineSAT::~ezCmdlineSAT()
+{
+}
+
+bool ezCmdlineSAT::solver(const std::vector<int> &modelExpressions, std::vector<bool> &modelValues, const std::vector<int> &assumptions)
+{
+	preSolverCallback();
+
+	solverTimoutStatus = false;
+
+	std::vector<int> modelIdx;
+	for (auto id : modelExpressions)
+		modelIdx.push_back(bind(id));
+
+	std::vector<std::vector<int>> extraClauses;
+	for (auto id : assumptions)
+		extraClauses.push_back({bind(id)});
+
+	std::string tempdir_name = Yosys::make_temp_dir("/tmp/yosys-sat-XXXXXX");
+	std::string cnf_filename = tempdir_name + "/problem.cnf";
+
+	FILE *f = fopen(cnf_filename.c_str(), "w");
+	if (f == NULL)
+		Yosys::log_error("Can't open SAT solver input file `%s' for writing: %s\n", cnf_filename.c_str(), strerror(errno));
+	printDIMACS(f, false, extraClauses);
+	fclose(f);
+
+	bool status_sat = false, status_unsat = false;
+	std::vector<bool> values(numCnfVariables() + 1);
+
+	auto process_line = [&](const std::string &line) {
+		if (line.compare(0, 13, "s SATISFIABLE") == 0)
+			status_sat = true;
+		if (line.compare(0, 15, "s UNSATISFIABLE") == 0)
+			status_unsat = true;
+		if (line.compare(0, 2, "v ") == 0) {
+			const char *p = line.c_str() + 2;
+			char *endp;
+			for (long lit = strtol(p, &endp, 10); endp != p; lit = strtol(p, &endp, 10)) {
+				if (lit != 0 && std::abs(lit) < long(values.size()))
+					values[std::abs(lit)] = lit > 0;
+				p = endp;
+			}
+		}
+	};
+
+	int retcode = Yosys::run_command(command + " " + cnf_filename, process_line);
+	Yosys::remove_directory(tempdir_name);
+
+	if (!status_sat && !status_unsat)
+		Yosys::log_error("SAT solver command `%s' returned %d without a result.\n", command.c_str(), retcode);
+
+	if (status_unsat)
+		return false;
+
+	modelValues.clear();
+	modelValues.resize(modelIdx.size());
+
+	for (size_t i = 0; i < modelIdx.size(); i++) {
+		int idx = modelIdx[i];
+		modelValues[i] = idx > 0 ? values.at(idx) : !values.at(-idx);
+	}
+
+	return true;
+}
@@ -105,7 +105,7 @@ struct CheckPass : public Pass {
 
 			log("checking module %s..\n", log_id(module));
 
-			SigMap sigmap(module);
+			const SigMap &sigmap = module->sigmap();
 			dict<SigBit, vector<string>> wire_drivers;
 			dict<SigBit, int> wire_drivers_count;
 			pool<SigBit> used_wires;
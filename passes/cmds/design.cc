@@ -49,6 +49,10 @@ struct DesignPass : public Pass {
 		log("\n");
 		log("Save the current design under the given name.\n");
 		log("\n");
+		log("Saving, stashing, pushing and loading designs does not copy the modules. The\n");
+		log("designs share the modules until a command accesses them in one of the designs,\n");
+		log("which then gets its own copy of only those modules.\n");
+		log("\n");
 		log("\n");
 		log("    design -stash <name>\n");
 		log("\n");
@@ -218,13 +222,15 @@ struct DesignPass : public Pass {
 				argidx = args.size();
 			}
 
-			for (auto mod : copy_from_design->modules()) {
-				if (sel.selected_whole_module(mod->name)) {
-					copy_src_modules.push_back(mod);
+			// the modules are only read, so that modules shared with
+			// other designs stay shared (see RTLIL::Design::share())
+			for (auto &it : copy_from_design->modules_) {
+				if (sel.selected_whole_module(it.first)) {
+					copy_src_modules.push_back(it.second);
 					continue;
 				}
-				if (sel.selected_module(mod->name))
-					log_cmd_error("Module %s is only partly selected.\n", log_id(mod->name));
+				if (sel.selected_module(it.first))
+					log_cmd_error("Module %s is only partly selected.\n", log_id(it.first));
 			}
 
 			if (import_mode) {
@@ -260,8 +266,8 @@ struct DesignPass : public Pass {
 			pool<Module*> queue;
 			dict<IdString, IdString> done;
 
-			if (copy_to_design->module(prefix) != nullptr)
-				copy_to_design->remove(copy_to_design->module(prefix));
+			if (copy_to_design->has(prefix))
+				copy_to_design->remove(copy_to_design->modules_.at(prefix));
 
 			if (GetSize(copy_src_modules) != 1)
 				log_cmd_error("No top module found in source design.\n");
@@ -288,19 +294,19 @@ struct DesignPass : public Pass {
 				for (auto mod : old_queue)
 				for (auto cell : mod->cells())
 				{
-					Module *fmod = copy_from_design->module(cell->type);
-
-					if (fmod == nullptr)
+					if (!copy_from_design->has(cell->type))
 						continue;
 
+					Module *fmod = copy_from_design->modules_.at(cell->type);
+
 					if (done.count(cell->type) == 0)
 					{
 						std::string trg_name = prefix + "." + (cell->type.c_str() + (*cell->type.c_str() == '\\'));
 
 						log("Importing %s as %s.\n", log_id(fmod), log_id(trg_name));
 
-						if (copy_to_design->module(trg_name) != nullptr)
-							copy_to_design->remove(copy_to_design->module(trg_name));
+						if (copy_to_design->has(trg_name))
+							copy_to_design->remove(copy_to_design->modules_.at(trg_name));
 
 						RTLIL::Module *t = fmod->clone();
 						t->name = trg_name;
@@ -326,8 +332,13 @@ struct DesignPass : public Pass {
 			{
 				std::string trg_name = as_name.empty() ? mod->name.str() : RTLIL::escape_id(as_name);
 
-				if (copy_to_design->module(trg_name) != nullptr)
-					copy_to_design->remove(copy_to_design->module(trg_name));
+				if (copy_to_design->has(trg_name))
+					copy_to_design->remove(copy_to_design->modules_.at(trg_name));
+
+				if (mod->name == trg_name) {
+					copy_to_design->share(mod);
+					continue;
+				}
 
 				RTLIL::Module *t = mod->clone();
 				t->name = trg_name;
@@ -340,8 +351,8 @@ struct DesignPass : public Pass {
 		{
 			RTLIL::Design *design_copy = new RTLIL::Design;
 
-			for (auto mod : design->modules())
-				design_copy->add(mod->clone());
+			for (auto &it : design->modules_)
+				design_copy->share(it.second);
 
 			design_copy->selection_stack = design->selection_stack;
 			design_copy->selection_vars = design->selection_vars;
@@ -358,7 +369,10 @@ struct DesignPass : public Pass {
 
 		if (reset_mode || !load_name.empty() || push_mode || pop_mode)
 		{
-			for (auto mod : design->modules().to_vector())
+			std::vector<RTLIL::Module*> modules;
+			for (auto &it : design->modules_)
+				modules.push_back(it.second);
+			for (auto mod : modules)
 				design->remove(mod);
 
 			design->selection_stack.clear();
@@ -385,8 +399,8 @@ struct DesignPass : public Pass {
 		{
 			RTLIL::Design *saved_design = pop_mode ? pushed_designs.back() : saved_designs.at(load_name);
 
-			for (auto mod : saved_design->modules())
-				design->add(mod->clone());
+			for (auto &it : saved_design->modules_)
+				design->share(it.second);
 
 			design->selection_stack = saved_design->selection_stack;
 			design->selection_vars = saved_design->selection_vars;
@@ -51,7 +51,7 @@ struct EdgetypePass : public Pass {
 
 		for (auto module : design->selected_modules())
 		{
-			SigMap sigmap(module);
+			const SigMap &sigmap = module->sigmap();
 			dict<SigBit, pool<tuple<IdString, IdString, int>>> bit_sources, bit_sinks;
 			pool<std::pair<IdString, IdString>> multibit_ports;
 
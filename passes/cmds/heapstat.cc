@@ -0,0 +1,280 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/yosys.h"
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+struct heapdata_t
+{
+	size_t wires = 0, cells = 0, connections = 0, attributes = 0;
+	size_t constants = 0, memories = 0, processes = 0, hashlib = 0;
+
+	heapdata_t &operator+=(const heapdata_t &other)
+	{
+		wires += other.wires;
+		cells += other.cells;
+		connections += other.connections;
+		attributes += other.attributes;
+		constants += other.constants;
+		memories += other.memories;
+		processes += other.processes;
+		hashlib += other.hashlib;
+		return *this;
+	}
+
+	size_t total() const
+	{
+		return wires + cells + connections + attributes + constants + memories + processes + hashlib;
+	}
+
+	void log_data() const
+	{
+		size_t sum = total();
+		auto line = [sum](const char *name, size_t bytes) {
+			log("   %-28s %12zu  %5.1f%%\n", name, bytes, sum ? 100.0 * bytes / sum : 0.0);
+		};
+		line("Wires:", wires);
+		line("Cells:", cells);
+		line("Cell connections:", connections);
+		line("Attributes:", attributes);
+		line("Parameters and init values:", constants);
+		line("Memories:", memories);
+		line("Processes:", processes);
+		line("Hash table overhead:", hashlib);
+		log("   %-28s %12zu\n", "Total:", sum);
+	}
+};
+
+// Adds up the approximate heap usage of a module. The containers count
+// their entries toward the category they belong to and only the unused
+// capacity and the hash table toward `hashlib`. SigSpecs that share their
+// data (see RTLIL::SigSpec) are counted once per design.
+struct HeapStatWorker
+{
+	pool<const void*, hash_ptr_ops> seen;
+	heapdata_t data;
+
+	static size_t const_bytes(const RTLIL::Const &value)
+	{
+		return value.bits.capacity() * sizeof(RTLIL::State);
+	}
+
+	template<typename C>
+	void add_container(const C &container)
+	{
+		data.hashlib += container.heap_bytes() - container.size() * sizeof(*container.begin());
+	}
+
+	void add_attributes(const RTLIL::AttrObject *obj)
+	{
+		add_container(obj->attributes);
+		for (auto &it : obj->attributes) {
+			size_t bytes = sizeof(it) + const_bytes(it.second);
+			if (it.first == ID::init)
+				data.constants += bytes;
+			else
+				data.attributes += bytes;
+		}
+	}
+
+	size_t sigspec_bytes(const RTLIL::SigSpec &sig)
+	{
+		return sig.heap_bytes(seen);
+	}
+
+	size_t sigsig_bytes(const std::vector<RTLIL::SigSig> &actions)
+	{
+		size_t bytes = actions.capacity() * sizeof(RTLIL::SigSig);
+		for (auto &it : actions)
+			bytes += sigspec_bytes(it.first) + sigspec_bytes(it.second);
+		return bytes;
+	}
+
+	size_t case_bytes(const RTLIL::CaseRule *cs)
+	{
+		add_attributes(cs);
+		size_t bytes = cs->compare.capacity() * sizeof(RTLIL::SigSpec);
+		for (auto &sig : cs->compare)
+			bytes += sigspec_bytes(sig);
+		bytes += sigsig_bytes(cs->actions);
+		bytes += cs->switches.capacity() * sizeof(RTLIL::SwitchRule*);
+		for (auto sw : cs->switches) {
+			add_attributes(sw);
+			bytes += sizeof(RTLIL::SwitchRule) + sigspec_bytes(sw->signal);
+			bytes += sw->cases.capacity() * sizeof(RTLIL::CaseRule*);
+			for (auto sub : sw->cases)
+				bytes += sizeof(RTLIL::CaseRule) + case_bytes(sub);
+		}
+		return bytes;
+	}
+
+	heapdata_t run(RTLIL::Module *module)
+	{
+		data = heapdata_t();
+
+		add_attributes(module);
+		add_container(module->wires_);
+		add_container(module->cells_);
+		add_container(module->memories);
+		add_container(module->processes);
+		add_container(module->parameter_default_values);
+		add_container(module->avail_parameters);
+
+		// the arenas include the slots of removed wires and cells that
+		// have not been reused yet
+		data.wires += module->wire_arena_stats().bytes;
+		data.cells += module->cell_arena_stats().bytes;
+
+		for (auto wire : module->wires())
+			add_attributes(wire);
+
+		for (auto cell : module->cells()) {
+			add_attributes(cell);
+			add_container(cell->connections_);
+			add_container(cell->parameters);
+			for (auto &it : cell->connections_)
+				data.connections += sizeof(it) + sigspec_bytes(it.second);
+			for (auto &it : cell->parameters)
+				data.constants += sizeof(it) + const_bytes(it.second);
+		}
+
+		data.connections += sigsig_bytes(module->connections_);
+
+		for (auto &it : module->parameter_default_values)
+			data.constants += sizeof(it) + const_bytes(it.second);
+		data.constants += module->avail_parameters.size() * sizeof(RTLIL::IdString);
+
+		for (auto &it : module->memories) {
+			add_attributes(it.second);
+			data.memories += sizeof(RTLIL::Memory);
+		}
+
+		for (auto &it : module->processes) {
+			RTLIL::Process *proc = it.second;
+			add_attributes(proc);
+			data.processes += sizeof(RTLIL::Process) + case_bytes(&proc->root_case);
+			data.processes += proc->syncs.capacity() * sizeof(RTLIL::SyncRule*);
+			for (auto sync : proc->syncs)
+				data.processes += sizeof(RTLIL::SyncRule) + sigspec_bytes(sync->signal) + sigsig_bytes(sync->actions);
+		}
+
+		return data;
+	}
+};
+
+struct HeapStatPass : public Pass {
+	HeapStatPass() : Pass("heapstat", "print approximate memory usage of the design") { }
+	void help() override
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    heapstat [options] [selection]\n");
+		log("\n");
+		log("Print the approximate heap memory used by the selected modules, in bytes,\n");
+		log("broken down by the kind of object it is used for. Modules are always counted\n");
+		log("as a whole, even if they are only partially selected.\n");
+		log("\n");
+		log("The numbers include the unused capacity of vectors and hash tables, but not\n");
+		log("the overhead of the memory allocator. SigSpecs that share their data with\n");
+		log("other copies are only counted once. Identifier strings are shared by all\n");
+		log("modules and are only reported for the whole design.\n");
+		log("\n");
+		log("The total for all selected modules is also stored in the scratchpad entry\n");
+		log("'heapstat.total'.\n");
+		log("\n");
+		log("    -total\n");
+		log("        only print the total for all selected modules\n");
+		log("\n");
+		log("    -top <N>\n");
+		log("        only print the N modules that use the most memory\n");
+		log("\n");
+	}
+	void execute(std::vector<std::string> args, RTLIL::Design *design) override
+	{
+		bool total_only = false;
+		int top_n = -1;
+
+		log_header(design, "Printing memory usage statistics.\n");
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++)
+		{
+			if (args[argidx] == "-total") {
+				total_only = true;
+				continue;
+			}
+			if (args[argidx] == "-top" && argidx+1 < args.size()) {
+				top_n = atoi(args[++argidx].c_str());
+				continue;
+			}
+			break;
+		}
+		extra_args(args, argidx, design);
+
+		HeapStatWorker worker;
+		std::vector<std::pair<heapdata_t, RTLIL::Module*>> mod_data;
+		heapdata_t total;
+
+		for (auto mod : design->selected_modules()) {
+			mod_data.push_back(std::make_pair(worker.run(mod), mod));
+			total += mod_data.back().first;
+		}
+
+		std::stable_sort(mod_data.begin(), mod_data.end(), [](const std::pair<heapdata_t, RTLIL::Module*> &a,
+				const std::pair<heapdata_t, RTLIL::Module*> &b) { return a.first.total() > b.first.total(); });
+		if (top_n >= 0 && top_n < GetSize(mod_data))
+			mod_data.resize(top_n);
+
+		if (!total_only)
+			for (auto &it : mod_data) {
+				log("\n");
+				log("=== %s ===\n", log_id(it.second));
+				log("\n");
+				it.first.log_data();
+			}
+
+		log("\n");
+		log("=== all selected modules (%d) ===\n", GetSize(design->selected_modules()));
+		log("\n");
+		total.log_data();
+		design->scratchpad_set_string("heapstat.total", stringf("%zu", total.total()));
+
+		size_t id_count = 0, id_bytes = 0;
+		for (int idx = 1; idx < RTLIL::IdString::global_id_count_; idx++) {
+			const char *p = RTLIL::IdString::global_id_storage(idx);
+			if (p != nullptr)
+				id_count++, id_bytes += strlen(p) + 1;
+		}
+		size_t id_chunks = (RTLIL::IdString::global_id_count_ + RTLIL::IdString::id_chunk_size - 1) >> RTLIL::IdString::id_chunk_bits;
+		size_t id_table = id_chunks * sizeof(RTLIL::IdString::storage_chunk_t);
+		for (auto &shard : RTLIL::IdString::global_id_shards_)
+			id_table += shard.index.heap_bytes() + shard.free_idx_list.capacity() * sizeof(int);
+
+		log("\n");
+		log("=== identifiers (%zu) ===\n", id_count);
+		log("\n");
+		log("   %-28s %12zu\n", "Strings:", id_bytes);
+		log("   %-28s %12zu\n", "Index:", id_table);
+		log("\n");
+	}
+} HeapStatPass;
+
+PRIVATE_NAMESPACE_END
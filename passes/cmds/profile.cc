@@ -0,0 +1,211 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/yosys.h"
+#include "kernel/profile.h"
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+struct profile_summary_t
+{
+	int calls = 0;
+	int64_t self_ns = 0, self_cpu_ns = 0, peak_rss_delta = 0;
+	uint64_t self_allocs = 0, self_alloc_bytes = 0;
+};
+
+static void write_profile(const std::string &filename, bool trace)
+{
+	std::ofstream f;
+	f.open(filename.c_str(), std::ofstream::trunc);
+	yosys_output_files.insert(filename);
+	if (f.fail())
+		log_error("Can't open file `%s' for writing: %s\n", filename.c_str(), strerror(errno));
+
+	log("Writing %s of %d command invocations to `%s'.\n", trace ? "trace" : "profile",
+			GetSize(profile_entries), filename.c_str());
+	if (trace)
+		profile_write_trace(f);
+	else
+		profile_write_json(f);
+}
+
+static void log_summary()
+{
+	dict<std::string, profile_summary_t> summary;
+	for (auto &e : profile_entries) {
+		if (!e.done() || e.category == "worker")
+			continue;
+		profile_summary_t &s = summary[e.name];
+		s.calls++;
+		s.self_ns += e.self_ns;
+		s.self_cpu_ns += e.self_cpu_ns;
+		s.peak_rss_delta = std::max(s.peak_rss_delta, e.peak_rss_delta());
+		s.self_allocs += e.self_allocs;
+		s.self_alloc_bytes += e.self_alloc_bytes;
+	}
+
+	std::vector<std::pair<std::string, profile_summary_t>> sorted(summary.begin(), summary.end());
+	std::stable_sort(sorted.begin(), sorted.end(), [](const std::pair<std::string, profile_summary_t> &a,
+			const std::pair<std::string, profile_summary_t> &b) { return a.second.self_ns > b.second.self_ns; });
+
+	log("   %6s %10s %10s %10s %12s %10s  %s\n", "calls", "wall [s]", "cpu [s]", "peak+ [MB]",
+			"allocs", "alloc [MB]", "command");
+	for (auto &it : sorted) {
+		const profile_summary_t &s = it.second;
+		log("   %6d %10.3f %10.3f %10.2f %12llu %10.2f  %s\n", s.calls, s.self_ns / 1e9, s.self_cpu_ns / 1e9,
+				s.peak_rss_delta / 1048576.0, (unsigned long long)s.self_allocs, s.self_alloc_bytes / 1048576.0,
+				it.first.c_str());
+	}
+}
+
+static void log_list()
+{
+	log("   %10s %10s %10s %12s %10s  %s\n", "wall [s]", "self [s]", "peak+ [MB]", "allocs", "alloc [MB]", "command");
+	for (auto &e : profile_entries) {
+		if (!e.done())
+			continue;
+		std::string command = std::string(2*e.depth, ' ') + e.args;
+		if (GetSize(command) > 60)
+			command = command.substr(0, 57) + "...";
+		log("   %10.3f %10.3f %10.2f %12llu %10.2f  %s\n", e.time_ns / 1e9, e.self_ns / 1e9,
+				e.peak_rss_delta() / 1048576.0, (unsigned long long)e.allocs, e.alloc_bytes / 1048576.0,
+				command.c_str());
+	}
+}
+
+struct ProfilePass : public Pass {
+	ProfilePass() : Pass("profile", "record time and memory used by each command") { }
+	void help() override
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    profile -start\n");
+		log("    profile -stop\n");
+		log("\n");
+		log("Start or stop recording a profile of the executed commands. For each invocation\n");
+		log("of a command the following is recorded:\n");
+		log("\n");
+		log("  - the wall clock time and CPU time (including child processes)\n");
+		log("  - the resident set size (RSS) before and after the command\n");
+		log("  - how much the command raised the peak RSS of the process\n");
+		log("  - the number and total size of the memory allocations\n");
+		log("\n");
+		log("Nested commands (e.g. the passes called by 'synth') are recorded separately.\n");
+		log("Their parents report the totals, which include the nested commands, as well as\n");
+		log("the self time and allocations, which do not. The allocations are only counted\n");
+		log("if Yosys was built with ENABLE_PROFILE_ALLOCS=1. '-start' clears the previous\n");
+		log("profile.\n");
+		log("\n");
+		log("The profile also contains the script files and the labels of scripts like\n");
+		log("'synth', the external programs run by commands (e.g. ABC), the calls of the SAT\n");
+		log("solver by 'sat', and the tasks of commands that use worker threads (see the -j\n");
+		log("command line option). Time and memory are always measured for the whole\n");
+		log("process. To record a trace of a whole run, use the -R command line option.\n");
+		log("\n");
+		log("\n");
+		log("    profile [options]\n");
+		log("\n");
+		log("Print or write the recorded profile. Without options, a summary of the self time\n");
+		log("and allocations of each command is printed, not including the worker tasks.\n");
+		log("\n");
+		log("    -list\n");
+		log("        print each recorded invocation, indented by nesting level\n");
+		log("\n");
+		log("    -json <filename>\n");
+		log("        write the recorded invocations to a JSON file\n");
+		log("\n");
+		log("    -trace <filename>\n");
+		log("        write the recorded invocations in Chrome trace event format, which can\n");
+		log("        be viewed with chrome://tracing or https://ui.perfetto.dev. Each worker\n");
+		log("        thread has its own track.\n");
+		log("\n");
+		log("Commands that have not finished yet, like the 'script' command running this\n");
+		log("command, are written as if they ended now.\n");
+		log("\n");
+	}
+	void execute(std::vector<std::string> args, RTLIL::Design *design) override
+	{
+		bool start_mode = false, stop_mode = false, list_mode = false;
+		std::string json_file, trace_file;
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++)
+		{
+			if (args[argidx] == "-start") {
+				start_mode = true;
+				continue;
+			}
+			if (args[argidx] == "-stop") {
+				stop_mode = true;
+				continue;
+			}
+			if (args[argidx] == "-list") {
+				list_mode = true;
+				continue;
+			}
+			if (args[argidx] == "-json" && argidx+1 < args.size()) {
+				json_file = args[++argidx];
+				continue;
+			}
+			if (args[argidx] == "-trace" && argidx+1 < args.size()) {
+				trace_file = args[++argidx];
+				continue;
+			}
+			break;
+		}
+		extra_args(args, argidx, design, false);
+
+		if (start_mode && stop_mode)
+			log_cmd_error("Options -start and -stop are exclusive.\n");
+
+		if (start_mode) {
+			log("Starting to record the profile.\n");
+			profile_start();
+			return;
+		}
+
+		if (stop_mode) {
+			log("Stopping to record the profile.\n");
+			profile_stop();
+			return;
+		}
+
+		if (!json_file.empty())
+			write_profile(json_file, false);
+
+		if (!trace_file.empty())
+			write_profile(trace_file, true);
+
+		if (json_file.empty() && trace_file.empty()) {
+			if (profile_entries.empty()) {
+				log("No profile recorded. Use 'profile -start' to start recording.\n");
+				return;
+			}
+			log("\n");
+			if (list_mode)
+				log_list();
+			else
+				log_summary();
+			log("\n");
+		}
+	}
+} ProfilePass;
+
+PRIVATE_NAMESPACE_END
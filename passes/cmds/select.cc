@@ -279,7 +279,7 @@ static void select_op_alias(RTLIL::Design *design, RTLIL::Selection &lhs)
 		if (!lhs.selected_module(mod->name))
 			continue;
 
-		SigMap sigmap(mod);
+		const SigMap &sigmap = mod->sigmap();
 		SigPool selected_bits;
 
 		for (auto wire : mod->wires())
@@ -632,6 +632,8 @@ static void select_filter_active_mod(RTLIL::Design *design, RTLIL::Selection &se
 
 static void select_stmt(RTLIL::Design *design, std::string arg, bool disable_empty_warning = false)
 {
+	RTLIL::Design::ReadOnlyScope readonly(design);
+
 	std::string arg_mod, arg_memb;
 	std::unordered_map<std::string, bool> arg_mod_found;
 	std::unordered_map<std::string, bool> arg_memb_found;
@@ -1252,6 +1254,7 @@ struct SelectPass : public Pass {
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
 	{
+		RTLIL::Design::ReadOnlyScope readonly(design);
 		bool add_mode = false;
 		bool del_mode = false;
 		bool clear_mode = false;
@@ -1615,6 +1618,7 @@ struct CdPass : public Pass {
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
 	{
+		RTLIL::Design::ReadOnlyScope readonly(design);
 		if (args.size() != 1 && args.size() != 2)
 			log_cmd_error("Invalid number of arguments.\n");
 
@@ -1706,6 +1710,7 @@ struct LsPass : public Pass {
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
 	{
+		RTLIL::Design::ReadOnlyScope readonly(design);
 		size_t argidx = 1;
 		extra_args(args, argidx, design);
 
@@ -70,7 +70,7 @@ struct TorderPass : public Pass {
 		{
 			log("module %s\n", log_id(module));
 
-			SigMap sigmap(module);
+			const SigMap &sigmap = module->sigmap();
 			dict<SigBit, pool<IdString>> bit_drivers, bit_users;
 			TopoSort<IdString, RTLIL::sort_by_id_str> toposort;
 
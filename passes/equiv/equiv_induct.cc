@@ -181,6 +181,11 @@ struct EquivInductPass : public Pass {
 		log("    -seq <N>\n");
 		log("        the max. number of time steps to be considered (default = 4)\n");
 		log("\n");
+		log("    -satsolver <solver>\n");
+		log("        use the given SAT solver. <solver> is \"minisat\" (the default), another\n");
+		log("        registered solver such as \"ipasir\", or \"cmdline:<command>\" to run an\n");
+		log("        external DIMACS solver executable.\n");
+		log("\n");
 		log("This command is very effective in proving complex sequential circuits, when\n");
 		log("the internal state of the circuit quickly propagates to $equiv cells.\n");
 		log("\n");
@@ -199,6 +204,7 @@ struct EquivInductPass : public Pass {
 		int success_counter = 0;
 		bool model_undef = false;
 		int max_seq = 4;
+		std::string satsolver;
 
 		log_header(design, "Executing EQUIV_INDUCT pass.\n");
 
@@ -212,10 +218,16 @@ struct EquivInductPass : public Pass {
 				max_seq = atoi(args[++argidx].c_str());
 				continue;
 			}
+			if (args[argidx] == "-satsolver" && argidx+1 < args.size()) {
+				satsolver = args[++argidx];
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
 
+		SatSolverScope satsolver_scope(satsolver);
+
 		for (auto module : design->selected_modules())
 		{
 			pool<Cell*> unproven_equiv_cells;
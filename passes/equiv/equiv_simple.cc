@@ -297,12 +297,18 @@ struct EquivSimplePass : public Pass {
 		log("    -seq <N>\n");
 		log("        the max. number of time steps to be considered (default = 1)\n");
 		log("\n");
+		log("    -satsolver <solver>\n");
+		log("        use the given SAT solver. <solver> is \"minisat\" (the default), another\n");
+		log("        registered solver such as \"ipasir\", or \"cmdline:<command>\" to run an\n");
+		log("        external DIMACS solver executable.\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, Design *design) override
 	{
 		bool verbose = false, short_cones = false, model_undef = false, nogroup = false;
 		int success_counter = 0;
 		int max_seq = 1;
+		std::string satsolver;
 
 		log_header(design, "Executing EQUIV_SIMPLE pass.\n");
 
@@ -328,10 +334,16 @@ struct EquivSimplePass : public Pass {
 				max_seq = atoi(args[++argidx].c_str());
 				continue;
 			}
+			if (args[argidx] == "-satsolver" && argidx+1 < args.size()) {
+				satsolver = args[++argidx];
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
 
+		SatSolverScope satsolver_scope(satsolver);
+
 		CellTypes ct;
 		ct.setup_internals();
 		ct.setup_stdcells();
@@ -62,6 +62,9 @@ struct OptPass : public Pass {
 		log("Note: Options in square brackets (such as [-keepdc]) are passed through to\n");
 		log("the opt_* commands when given to 'opt'.\n");
 		log("\n");
+		log("The option -threads <N> is passed through to opt_expr, opt_merge, opt_reduce,\n");
+		log("opt_dff and opt_clean.\n");
+		log("\n");
 		log("\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
@@ -132,6 +135,15 @@ struct OptPass : public Pass {
 				opt_merge_args += " -share_all";
 				continue;
 			}
+			if (args[argidx] == "-threads" && argidx+1 < args.size()) {
+				std::string threads_arg = " -threads " + args[++argidx];
+				opt_expr_args += threads_arg;
+				opt_reduce_args += threads_arg;
+				opt_merge_args += threads_arg;
+				opt_dff_args += threads_arg;
+				opt_clean_args += threads_arg;
+				continue;
+			}
 			if (args[argidx] == "-fast") {
 				fast_mode = true;
 				continue;
@@ -21,6 +21,7 @@
 #include "kernel/sigtools.h"
 #include "kernel/log.h"
 #include "kernel/celltypes.h"
+#include "kernel/threading.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <set>
@@ -90,7 +91,8 @@ struct keep_cache_t
 
 keep_cache_t keep_cache;
 CellTypes ct_reg, ct_all;
-int count_rm_cells, count_rm_wires;
+YS_THREAD_LOCAL int count_rm_cells, count_rm_wires;
+YS_THREAD_LOCAL bool did_something;
 
 void rmunused_module_cells(Module *module, bool verbose)
 {
@@ -192,7 +194,7 @@ void rmunused_module_cells(Module *module, bool verbose)
 	for (auto cell : unused) {
 		if (verbose)
 			log_debug("  removing unused `%s' cell `%s'.\n", cell->type.c_str(), cell->name.c_str());
-		module->design->scratchpad_set_bool("opt.did_something", true);
+		did_something = true;
 		module->remove(cell);
 		count_rm_cells++;
 	}
@@ -449,7 +451,7 @@ bool rmunused_module_signals(RTLIL::Module *module, bool purge_mode, bool verbos
 		log_debug("  removed %d unused temporary wires.\n", del_temp_wires_count);
 
 	if (!del_wires_queue.empty())
-		module->design->scratchpad_set_bool("opt.did_something", true);
+		did_something = true;
 
 	return !del_wires_queue.empty();
 }
@@ -530,7 +532,7 @@ bool rmunused_module_init(RTLIL::Module *module, bool verbose)
 	}
 
 	if (did_something)
-		module->design->scratchpad_set_bool("opt.did_something", true);
+		did_something = true;
 
 	return did_something;
 }
@@ -557,7 +559,7 @@ void rmunused_module(RTLIL::Module *module, bool purge_mode, bool verbose, bool
 		module->remove(cell);
 	}
 	if (!delcells.empty())
-		module->design->scratchpad_set_bool("opt.did_something", true);
+		did_something = true;
 
 	rmunused_module_cells(module, verbose);
 	while (rmunused_module_signals(module, purge_mode, verbose)) { }
@@ -566,6 +568,36 @@ void rmunused_module(RTLIL::Module *module, bool purge_mode, bool verbose, bool
 		while (rmunused_module_signals(module, purge_mode, verbose)) { }
 }
 
+void rmunused_modules(Design *design, const std::vector<Module*> &modules, bool purge_mode, bool verbose, int threads)
+{
+	// the workers must not modify the cache, so it is filled up front
+	if (threads > 1)
+		for (auto module : design->modules())
+			keep_cache.query(module);
+
+	std::vector<int> rm_cells(GetSize(modules)), rm_wires(GetSize(modules));
+	std::vector<char> module_did_something(GetSize(modules));
+
+	parallel_for_modules(design, modules, threads, [&](int i) {
+		count_rm_cells = 0;
+		count_rm_wires = 0;
+		did_something = false;
+		rmunused_module(modules[i], purge_mode, verbose, true);
+		rm_cells[i] = count_rm_cells;
+		rm_wires[i] = count_rm_wires;
+		module_did_something[i] = did_something;
+	});
+
+	count_rm_cells = 0;
+	count_rm_wires = 0;
+	for (int i = 0; i < GetSize(modules); i++) {
+		count_rm_cells += rm_cells[i];
+		count_rm_wires += rm_wires[i];
+		if (module_did_something[i])
+			design->scratchpad_set_bool("opt.did_something", true);
+	}
+}
+
 struct OptCleanPass : public Pass {
 	OptCleanPass() : Pass("opt_clean", "remove unused cells and wires") { }
 	void help() override
@@ -584,10 +616,14 @@ struct OptCleanPass : public Pass {
 		log("    -purge\n");
 		log("        also remove internal nets if they have a public name\n");
 		log("\n");
+		log("    -threads <N>\n");
+		log("        clean up to N modules in parallel (default is set with 'yosys -j')\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
 	{
 		bool purge_mode = false;
+		int threads = yosys_threads;
 
 		log_header(design, "Executing OPT_CLEAN pass (remove unused cells and wires).\n");
 		log_push();
@@ -598,6 +634,10 @@ struct OptCleanPass : public Pass {
 				purge_mode = true;
 				continue;
 			}
+			if (args[argidx] == "-threads" && argidx+1 < args.size()) {
+				threads = atoi(args[++argidx].c_str());
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
@@ -609,14 +649,12 @@ struct OptCleanPass : public Pass {
 
 		ct_all.setup(design);
 
-		count_rm_cells = 0;
-		count_rm_wires = 0;
+		std::vector<Module*> modules;
+		for (auto module : design->selected_whole_modules_warn())
+			if (!module->has_processes_warn())
+				modules.push_back(module);
 
-		for (auto module : design->selected_whole_modules_warn()) {
-			if (module->has_processes_warn())
-				continue;
-			rmunused_module(module, purge_mode, true, true);
-		}
+		rmunused_modules(design, modules, purge_mode, true, threads);
 
 		if (count_rm_cells > 0 || count_rm_wires > 0)
 			log("Removed %d unused cells and %d unused wires.\n", count_rm_cells, count_rm_wires);
@@ -648,6 +686,9 @@ struct CleanPass : public Pass {
 		log("When commands are separated using the ';;;' token, this command will be executed\n");
 		log("in -purge mode between the commands.\n");
 		log("\n");
+		log("The modules are cleaned in parallel when the default number of threads is set\n");
+		log("with 'yosys -j'.\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
 	{
@@ -670,14 +711,12 @@ struct CleanPass : public Pass {
 
 		ct_all.setup(design);
 
-		count_rm_cells = 0;
-		count_rm_wires = 0;
+		std::vector<Module*> modules;
+		for (auto module : design->selected_whole_modules())
+			if (!module->has_processes())
+				modules.push_back(module);
 
-		for (auto module : design->selected_whole_modules()) {
-			if (module->has_processes())
-				continue;
-			rmunused_module(module, purge_mode, ys_debug(), true);
-		}
+		rmunused_modules(design, modules, purge_mode, ys_debug(), yosys_threads);
 
 		log_suppressed();
 		if (count_rm_cells > 0 || count_rm_wires > 0)
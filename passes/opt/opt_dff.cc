@@ -25,6 +25,7 @@
 #include "kernel/sigtools.h"
 #include "kernel/ffinit.h"
 #include "kernel/ff.h"
+#include "kernel/threading.h"
 #include "passes/techmap/simplemap.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -797,7 +798,7 @@ struct OptDffPass : public Pass {
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
 		log("\n");
-		log("    opt_dff [-nodffe] [-nosdff] [-keepdc] [-sat] [selection]\n");
+		log("    opt_dff [-nodffe] [-nosdff] [-keepdc] [-sat] [-threads N] [selection]\n");
 		log("\n");
 		log("This pass converts flip-flops to a more suitable type by merging clock enables\n");
 		log("and synchronous reset multiplexers, removing unused control inputs, or potentially\n");
@@ -822,6 +823,9 @@ struct OptDffPass : public Pass {
 		log("        all result bits to be set to x. this behavior changes when 'a+0' is\n");
 		log("        replaced by 'a'. the -keepdc option disables all such optimizations.\n");
 		log("\n");
+		log("    -threads <N>\n");
+		log("        optimize up to N modules in parallel (default is set with 'yosys -j').\n");
+		log("\n");
 	}
 
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
@@ -833,6 +837,7 @@ struct OptDffPass : public Pass {
 		opt.simple_dffe = false;
 		opt.keepdc = false;
 		opt.sat = false;
+		int threads = yosys_threads;
 
 		size_t argidx;
 		for (argidx = 1; argidx < args.size(); argidx++) {
@@ -856,19 +861,25 @@ struct OptDffPass : public Pass {
 				opt.sat = true;
 				continue;
 			}
+			if (args[argidx] == "-threads" && argidx+1 < args.size()) {
+				threads = atoi(args[++argidx].c_str());
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
 
-		bool did_something = false;
-		for (auto mod : design->selected_modules()) {
-			OptDffWorker worker(opt, mod);
-			if (worker.run())
-				did_something = true;
-		}
+		std::vector<RTLIL::Module*> modules = design->selected_modules();
+		std::vector<char> module_did_something(GetSize(modules));
+
+		parallel_for_modules(design, modules, threads, [&](int i) {
+			OptDffWorker worker(opt, modules[i]);
+			module_did_something[i] = worker.run();
+		});
 
-		if (did_something)
-			design->scratchpad_set_bool("opt.did_something", true);
+		for (auto flag : module_did_something)
+			if (flag)
+				design->scratchpad_set_bool("opt.did_something", true);
 	}
 } OptDffPass;
 
@@ -21,6 +21,7 @@
 #include "kernel/sigtools.h"
 #include "kernel/celltypes.h"
 #include "kernel/utils.h"
+#include "kernel/threading.h"
 #include "kernel/log.h"
 #include <stdlib.h>
 #include <stdio.h>
@@ -29,7 +30,7 @@
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
-bool did_something;
+YS_THREAD_LOCAL bool did_something;
 
 void replace_undriven(RTLIL::Module *module, const CellTypes &ct)
 {
@@ -2079,6 +2080,9 @@ struct OptExprPass : public Pass {
 		log("        all result bits to be set to x. this behavior changes when 'a+0' is\n");
 		log("        replaced by 'a'. the -keepdc option disables all such optimizations.\n");
 		log("\n");
+		log("    -threads <N>\n");
+		log("        optimize up to N modules in parallel (default is set with 'yosys -j').\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
 	{
@@ -2088,6 +2092,7 @@ struct OptExprPass : public Pass {
 		bool noclkinv = false;
 		bool do_fine = false;
 		bool keepdc = false;
+		int threads = yosys_threads;
 
 		log_header(design, "Executing OPT_EXPR pass (perform const folding).\n");
 		log_push();
@@ -2125,20 +2130,28 @@ struct OptExprPass : public Pass {
 				keepdc = true;
 				continue;
 			}
+			if (args[argidx] == "-threads" && argidx+1 < args.size()) {
+				threads = atoi(args[++argidx].c_str());
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
 
 		CellTypes ct(design);
-		for (auto module : design->selected_modules())
+		std::vector<RTLIL::Module*> modules = design->selected_modules();
+		std::vector<char> module_did_something(GetSize(modules));
+
+		parallel_for_modules(design, modules, threads, [&](int i)
 		{
+			RTLIL::Module *module = modules[i];
 			log("Optimizing module %s.\n", log_id(module));
 
 			if (undriven) {
 				did_something = false;
 				replace_undriven(module, ct);
 				if (did_something)
-					design->scratchpad_set_bool("opt.did_something", true);
+					module_did_something[i] = true;
 			}
 
 			do {
@@ -2146,16 +2159,20 @@ struct OptExprPass : public Pass {
 					did_something = false;
 					replace_const_cells(design, module, false /* consume_x */, mux_undef, mux_bool, do_fine, keepdc, noclkinv);
 					if (did_something)
-						design->scratchpad_set_bool("opt.did_something", true);
+						module_did_something[i] = true;
 				} while (did_something);
 				if (!keepdc)
 					replace_const_cells(design, module, true /* consume_x */, mux_undef, mux_bool, do_fine, keepdc, noclkinv);
 				if (did_something)
-					design->scratchpad_set_bool("opt.did_something", true);
+					module_did_something[i] = true;
 			} while (did_something);
 
 			log_suppressed();
-		}
+		});
+
+		for (auto flag : module_did_something)
+			if (flag)
+				design->scratchpad_set_bool("opt.did_something", true);
 
 		log_pop();
 	}
@@ -21,7 +21,7 @@
 #include "kernel/sigtools.h"
 #include "kernel/log.h"
 #include "kernel/celltypes.h"
-#include "libs/sha1/sha1.h"
+#include "kernel/threading.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <set>
@@ -40,7 +40,6 @@ struct OptMergeWorker
 
 	CellTypes ct;
 	int total_count;
-	SHA1 checksum;
 
 	static void sort_pmux_conn(dict<RTLIL::IdString, RTLIL::SigSpec> &conn)
 	{
@@ -65,92 +64,166 @@ struct OptMergeWorker
 		}
 	}
 
-	std::string int_to_hash_string(unsigned int v)
+	static bool is_commutative(RTLIL::IdString type)
 	{
-		if (v == 0)
-			return "0";
-		std::string str = "";
-		while (v > 0) {
-			str += 'a' + (v & 15);
-			v = v >> 4;
-		}
-		return str;
+		return type.in(ID($and), ID($or), ID($xor), ID($xnor), ID($add), ID($mul),
+				ID($logic_and), ID($logic_or), ID($_AND_), ID($_OR_), ID($_XOR_));
+	}
+
+	unsigned int hash_signal(const RTLIL::SigSpec &sig)
+	{
+		unsigned int h = mkhash_init;
+		for (auto &chunk : sig.chunks())
+			for (int i = 0; i < chunk.width; i++)
+				h = mkhash(h, assign_map(RTLIL::SigBit(chunk, i)).hash());
+		return h;
 	}
 
-	std::string hash_cell_parameters_and_connections(const RTLIL::Cell *cell)
+	unsigned int hash_init_value(const RTLIL::SigSpec &sig)
 	{
-		vector<string> hash_conn_strings;
-		std::string hash_string = cell->type.str() + "\n";
-
-		const dict<RTLIL::IdString, RTLIL::SigSpec> *conn = &cell->connections();
-		dict<RTLIL::IdString, RTLIL::SigSpec> alt_conn;
-
-		if (cell->type.in(ID($and), ID($or), ID($xor), ID($xnor), ID($add), ID($mul),
-				ID($logic_and), ID($logic_or), ID($_AND_), ID($_OR_), ID($_XOR_))) {
-			alt_conn = *conn;
-			if (assign_map(alt_conn.at(ID::A)) < assign_map(alt_conn.at(ID::B))) {
-				alt_conn[ID::A] = conn->at(ID::B);
-				alt_conn[ID::B] = conn->at(ID::A);
+		unsigned int h = mkhash_init;
+		for (auto &chunk : sig.chunks())
+			for (int i = 0; i < chunk.width; i++) {
+				RTLIL::SigBit bit = dff_init_map(RTLIL::SigBit(chunk, i));
+				h = mkhash(h, bit.wire ? RTLIL::State::Sx : bit.data);
 			}
-			conn = &alt_conn;
-		} else
-		if (cell->type.in(ID($reduce_xor), ID($reduce_xnor))) {
-			alt_conn = *conn;
-			assign_map.apply(alt_conn.at(ID::A));
-			alt_conn.at(ID::A).sort();
-			conn = &alt_conn;
-		} else
-		if (cell->type.in(ID($reduce_and), ID($reduce_or), ID($reduce_bool))) {
-			alt_conn = *conn;
-			assign_map.apply(alt_conn.at(ID::A));
-			alt_conn.at(ID::A).sort_and_unify();
-			conn = &alt_conn;
-		} else
-		if (cell->type == ID($pmux)) {
-			alt_conn = *conn;
-			assign_map.apply(alt_conn.at(ID::A));
-			assign_map.apply(alt_conn.at(ID::B));
-			assign_map.apply(alt_conn.at(ID::S));
-			sort_pmux_conn(alt_conn);
-			conn = &alt_conn;
-		}
+		return h;
+	}
+
+	// Hash over the same canonical form that compare_cell_parameters_and_connections()
+	// compares. Ports and parameters are combined with a sum, so that the order of
+	// the dicts does not matter, and the two inputs of commutative cells are hashed
+	// under the same name, so that they can be swapped.
+	unsigned int hash_cell_parameters_and_connections(const RTLIL::Cell *cell)
+	{
+		unsigned int hash_conn = 0;
+		bool commutative = is_commutative(cell->type);
 
-		for (auto &it : *conn) {
-			RTLIL::SigSpec sig;
+		for (auto &it : cell->connections()) {
+			unsigned int h;
 			if (cell->output(it.first)) {
 				if (it.first == ID::Q && RTLIL::builtin_ff_cell_types().count(cell->type)) {
 					// For the 'Q' output of state elements,
 					//   use its (* init *) attribute value
-					for (const auto &b : dff_init_map(it.second))
-						sig.append(b.wire ? State::Sx : b);
+					h = hash_init_value(it.second);
 				}
 				else
 					continue;
 			}
-			else
-				sig = assign_map(it.second);
-			string s = "C " + it.first.str() + "=";
-			for (auto &chunk : sig.chunks()) {
-				if (chunk.wire)
-					s += "{" + chunk.wire->name.str() + " " +
-							int_to_hash_string(chunk.offset) + " " +
-							int_to_hash_string(chunk.width) + "}";
-				else
-					s += RTLIL::Const(chunk.data).as_string();
+			else if (it.first == ID::A && cell->type.in(ID($reduce_xor), ID($reduce_xnor))) {
+				RTLIL::SigSpec sig = assign_map(it.second);
+				sig.sort();
+				h = hash_signal(sig);
 			}
-			hash_conn_strings.push_back(s + "\n");
+			else if (it.first == ID::A && cell->type.in(ID($reduce_and), ID($reduce_or), ID($reduce_bool))) {
+				RTLIL::SigSpec sig = assign_map(it.second);
+				sig.sort_and_unify();
+				h = hash_signal(sig);
+			}
+			else if (cell->type == ID($pmux) && it.first.in(ID::B, ID::S))
+				continue;
+			else
+				h = hash_signal(it.second);
+			RTLIL::IdString name = commutative && it.first == ID::B ? ID::A : it.first;
+			hash_conn += mkhash(name.hash(), h);
+		}
+
+		if (cell->type == ID($pmux)) {
+			dict<RTLIL::IdString, RTLIL::SigSpec> conn;
+			conn[ID::B] = assign_map(cell->getPort(ID::B));
+			conn[ID::S] = assign_map(cell->getPort(ID::S));
+			sort_pmux_conn(conn);
+			hash_conn += mkhash(ID::B.hash(), hash_signal(conn.at(ID::B)));
+			hash_conn += mkhash(ID::S.hash(), hash_signal(conn.at(ID::S)));
+		}
+
+		unsigned int hash_param = 0;
+		for (auto &it : cell->parameters) {
+			unsigned int h = mkhash_init;
+			for (auto bit : it.second.bits)
+				h = mkhash(h, bit);
+			hash_param += mkhash(it.first.hash(), h);
+		}
+
+		return mkhash(mkhash(cell->type.hash(), hash_conn), hash_param);
+	}
+
+	// Entry of the table of known cells, compared exactly on equal hashes.
+	// A key without worker only matches the entry of the same cell.
+	struct CellRef
+	{
+		OptMergeWorker *worker;
+		RTLIL::Cell *cell;
+		unsigned int hash_;
+
+		bool operator==(const CellRef &other) const {
+			if (cell == other.cell)
+				return true;
+			return worker && other.worker && hash_ == other.hash_ &&
+					worker->compare_cell_parameters_and_connections(cell, other.cell);
+		}
+		unsigned int hash() const { return hash_; }
+	};
+
+	// The table of known cells is kept for the whole module. When the outputs
+	// of a merged cell are redirected, the readers of the old signal are taken
+	// out of the table and queued again, so only the fanout of a merge is hashed
+	// a second time.
+	pool<CellRef> known_cells;
+	dict<RTLIL::Cell*, unsigned int> cell_hash;
+	dict<RTLIL::SigBit, std::vector<RTLIL::Cell*>> fanout;
+	std::vector<RTLIL::Cell*> worklist;
+
+	void add_fanout(RTLIL::Cell *cell)
+	{
+		for (auto &it : cell->connections()) {
+			if (cell->output(it.first))
+				continue;
+			for (auto bit : assign_map(it.second))
+				if (bit.wire)
+					fanout[bit].push_back(cell);
 		}
+	}
 
-		for (auto &it : cell->parameters)
-			hash_conn_strings.push_back("P " + it.first.str() + "=" + it.second.as_string() + "\n");
+	void requeue_fanout(const RTLIL::SigBit &old_bit, const RTLIL::SigBit &new_bit)
+	{
+		auto it = fanout.find(old_bit);
+		if (it == fanout.end())
+			return;
 
-		std::sort(hash_conn_strings.begin(), hash_conn_strings.end());
+		std::vector<RTLIL::Cell*> readers;
+		readers.swap(it->second);
+		fanout.erase(it);
 
-		for (auto it : hash_conn_strings)
-			hash_string += it;
+		for (auto cell : readers) {
+			auto jt = cell_hash.find(cell);
+			if (jt == cell_hash.end())
+				continue;
+			known_cells.erase(CellRef{nullptr, cell, jt->second});
+			cell_hash.erase(jt);
+			worklist.push_back(cell);
+		}
 
-		checksum.update(hash_string);
-		return checksum.final();
+		if (new_bit.wire) {
+			auto &new_readers = fanout[new_bit];
+			new_readers.insert(new_readers.end(), readers.begin(), readers.end());
+		}
+	}
+
+	void redirect_signal(const RTLIL::SigSpec &sig, const RTLIL::SigSpec &other_sig)
+	{
+		for (int i = 0; i < GetSize(sig); i++) {
+			RTLIL::SigBit old_bit = assign_map(sig[i]);
+			RTLIL::SigBit old_other_bit = assign_map(other_sig[i]);
+			if (old_bit == old_other_bit)
+				continue;
+			assign_map.add(sig[i], other_sig[i]);
+			RTLIL::SigBit new_bit = assign_map(sig[i]);
+			if (old_bit != new_bit)
+				requeue_fanout(old_bit, new_bit);
+			if (old_other_bit != new_bit)
+				requeue_fanout(old_other_bit, new_bit);
+		}
 	}
 
 	bool compare_cell_parameters_and_connections(const RTLIL::Cell *cell1, const RTLIL::Cell *cell2)
@@ -194,8 +267,7 @@ struct OptMergeWorker
 			}
 		}
 
-		if (cell1->type == ID($and) || cell1->type == ID($or) || cell1->type == ID($xor) || cell1->type == ID($xnor) || cell1->type == ID($add) || cell1->type == ID($mul) ||
-				cell1->type == ID($logic_and) || cell1->type == ID($logic_or) || cell1->type == ID($_AND_) || cell1->type == ID($_OR_) || cell1->type == ID($_XOR_)) {
+		if (is_commutative(cell1->type)) {
 			if (conn1.at(ID::A) < conn1.at(ID::B)) {
 				RTLIL::SigSpec tmp = conn1[ID::A];
 				conn1[ID::A] = conn1[ID::B];
@@ -256,64 +328,64 @@ struct OptMergeWorker
 						dff_init_map.add(SigBit(it.second, i), initval[i]);
 			}
 
-		bool did_something = true;
-		while (did_something)
+		for (auto &it : module->cells_) {
+			if (!design->selected(module, it.second))
+				continue;
+			if (ct.cell_known(it.second->type) || (mode_share_all && it.second->known())) {
+				worklist.push_back(it.second);
+				add_fanout(it.second);
+			}
+		}
+
+		for (int k = 0; k < GetSize(worklist); k++)
 		{
-			std::vector<RTLIL::Cell*> cells;
-			cells.reserve(module->cells_.size());
-			for (auto &it : module->cells_) {
-				if (!design->selected(module, it.second))
-					continue;
-				if (ct.cell_known(it.second->type) || (mode_share_all && it.second->known()))
-					cells.push_back(it.second);
+			RTLIL::Cell *cell = worklist[k];
+
+			if ((!mode_share_all && !ct.cell_known(cell->type)) || !cell->known())
+				continue;
+
+			CellRef ref = {this, cell, hash_cell_parameters_and_connections(cell)};
+			auto r = known_cells.insert(ref);
+			if (r.second) {
+				cell_hash[cell] = ref.hash_;
+				continue;
 			}
 
-			did_something = false;
-			dict<std::string, RTLIL::Cell*> sharemap;
-			for (auto cell : cells)
-			{
-				if ((!mode_share_all && !ct.cell_known(cell->type)) || !cell->known())
+			RTLIL::Cell *other = r.first->cell;
+			if (cell->has_keep_attr()) {
+				if (other->has_keep_attr())
 					continue;
+				known_cells.erase(r.first);
+				known_cells.insert(ref);
+				cell_hash.erase(other);
+				cell_hash[cell] = ref.hash_;
+				std::swap(other, cell);
+			}
 
-				auto hash = hash_cell_parameters_and_connections(cell);
-				auto r = sharemap.insert(std::make_pair(hash, cell));
-				if (!r.second) {
-					if (compare_cell_parameters_and_connections(cell, r.first->second)) {
-						if (cell->has_keep_attr()) {
-							if (r.first->second->has_keep_attr())
+			log_debug("  Cell `%s' is identical to cell `%s'.\n", cell->name.c_str(), other->name.c_str());
+			for (auto &it : cell->connections()) {
+				if (cell->output(it.first)) {
+					RTLIL::SigSpec other_sig = other->getPort(it.first);
+					log_debug("    Redirecting output %s: %s = %s\n", it.first.c_str(),
+							log_signal(it.second), log_signal(other_sig));
+					module->connect(RTLIL::SigSig(it.second, other_sig));
+					redirect_signal(it.second, other_sig);
+
+					if (it.first == ID::Q && RTLIL::builtin_ff_cell_types().count(cell->type)) {
+						for (auto c : it.second.chunks()) {
+							auto jt = c.wire->attributes.find(ID::init);
+							if (jt == c.wire->attributes.end())
 								continue;
-							std::swap(r.first->second, cell);
+							for (int i = c.offset; i < c.offset + c.width; i++)
+								jt->second[i] = State::Sx;
 						}
-
-
-						did_something = true;
-						log_debug("  Cell `%s' is identical to cell `%s'.\n", cell->name.c_str(), r.first->second->name.c_str());
-						for (auto &it : cell->connections()) {
-							if (cell->output(it.first)) {
-								RTLIL::SigSpec other_sig = r.first->second->getPort(it.first);
-								log_debug("    Redirecting output %s: %s = %s\n", it.first.c_str(),
-										log_signal(it.second), log_signal(other_sig));
-								module->connect(RTLIL::SigSig(it.second, other_sig));
-								assign_map.add(it.second, other_sig);
-
-								if (it.first == ID::Q && RTLIL::builtin_ff_cell_types().count(cell->type)) {
-									for (auto c : it.second.chunks()) {
-										auto jt = c.wire->attributes.find(ID::init);
-										if (jt == c.wire->attributes.end())
-											continue;
-										for (int i = c.offset; i < c.offset + c.width; i++)
-											jt->second[i] = State::Sx;
-									}
-									dff_init_map.add(it.second, Const(State::Sx, GetSize(it.second)));
-								}
-							}
-						}
-						log_debug("    Removing %s cell `%s' from module `%s'.\n", cell->type.c_str(), cell->name.c_str(), module->name.c_str());
-						module->remove(cell);
-						total_count++;
+						dff_init_map.add(it.second, Const(State::Sx, GetSize(it.second)));
 					}
 				}
 			}
+			log_debug("    Removing %s cell `%s' from module `%s'.\n", cell->type.c_str(), cell->name.c_str(), module->name.c_str());
+			module->remove(cell);
+			total_count++;
 		}
 
 		log_suppressed();
@@ -337,6 +409,9 @@ struct OptMergePass : public Pass {
 		log("    -share_all\n");
 		log("        Operate on all cell types, not just built-in types.\n");
 		log("\n");
+		log("    -threads <N>\n");
+		log("        Process up to N modules in parallel (default is set with 'yosys -j').\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
 	{
@@ -344,6 +419,7 @@ struct OptMergePass : public Pass {
 
 		bool mode_nomux = false;
 		bool mode_share_all = false;
+		int threads = yosys_threads;
 
 		size_t argidx;
 		for (argidx = 1; argidx < args.size(); argidx++) {
@@ -356,15 +432,25 @@ struct OptMergePass : public Pass {
 				mode_share_all = true;
 				continue;
 			}
+			if (arg == "-threads" && argidx+1 < args.size()) {
+				threads = atoi(args[++argidx].c_str());
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
 
+		std::vector<RTLIL::Module*> modules = design->selected_modules();
+		std::vector<int> module_count(GetSize(modules));
+
+		parallel_for_modules(design, modules, threads, [&](int i) {
+			OptMergeWorker worker(design, modules[i], mode_nomux, mode_share_all);
+			module_count[i] = worker.total_count;
+		});
+
 		int total_count = 0;
-		for (auto module : design->selected_modules()) {
-			OptMergeWorker worker(design, module, mode_nomux, mode_share_all);
-			total_count += worker.total_count;
-		}
+		for (int count : module_count)
+			total_count += count;
 
 		if (total_count)
 			design->scratchpad_set_bool("opt.did_something", true);
@@ -21,6 +21,7 @@
 #include "kernel/sigtools.h"
 #include "kernel/log.h"
 #include "kernel/celltypes.h"
+#include "kernel/threading.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <set>
@@ -352,10 +353,14 @@ struct OptReducePass : public Pass {
 		log("    -full\n");
 		log("      alias for -fine\n");
 		log("\n");
+		log("    -threads <N>\n");
+		log("      optimize up to N modules in parallel (default is set with 'yosys -j')\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
 	{
 		bool do_fine = false;
+		int threads = yosys_threads;
 
 		log_header(design, "Executing OPT_REDUCE pass (consolidate $*mux and $reduce_* inputs).\n");
 
@@ -369,18 +374,29 @@ struct OptReducePass : public Pass {
 				do_fine = true;
 				continue;
 			}
+			if (args[argidx] == "-threads" && argidx+1 < args.size()) {
+				threads = atoi(args[++argidx].c_str());
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
 
-		int total_count = 0;
-		for (auto module : design->selected_modules())
+		std::vector<RTLIL::Module*> modules = design->selected_modules();
+		std::vector<int> module_count(GetSize(modules));
+
+		parallel_for_modules(design, modules, threads, [&](int i) {
 			while (1) {
-				OptReduceWorker worker(design, module, do_fine);
-				total_count += worker.total_count;
+				OptReduceWorker worker(design, modules[i], do_fine);
+				module_count[i] += worker.total_count;
 				if (worker.total_count == 0)
 					break;
 			}
+		});
+
+		int total_count = 0;
+		for (int count : module_count)
+			total_count += count;
 
 		if (total_count)
 			design->scratchpad_set_bool("opt.did_something", true);
@@ -1475,10 +1475,16 @@ struct SharePass : public Pass {
 		log("  -limit N\n");
 		log("    Only perform the first N merges, then stop. This is useful for debugging.\n");
 		log("\n");
+		log("  -satsolver <solver>\n");
+		log("    Use the given SAT solver. <solver> is \"minisat\" (the default), another\n");
+		log("    registered solver such as \"ipasir\", or \"cmdline:<command>\" to run an\n");
+		log("    external DIMACS solver executable.\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
 	{
 		ShareWorkerConfig config;
+		std::string satsolver;
 
 		config.limit = -1;
 		config.opt_force = false;
@@ -1545,10 +1551,16 @@ struct SharePass : public Pass {
 				config.limit = atoi(args[++argidx].c_str());
 				continue;
 			}
+			if (args[argidx] == "-satsolver" && argidx+1 < args.size()) {
+				satsolver = args[++argidx];
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
 
+		SatSolverScope satsolver_scope(satsolver);
+
 		ShareWorker sw(config, design);
 
 		for (auto module : design->selected_modules())
@@ -784,6 +784,11 @@ struct FreducePass : public Pass {
 		log("        dump the design to <prefix>_<module>_<num>.il after each reduction\n");
 		log("        operation. this is mostly used for debugging the freduce command.\n");
 		log("\n");
+		log("    -satsolver <solver>\n");
+		log("        use the given SAT solver. <solver> is \"minisat\" (the default), another\n");
+		log("        registered solver such as \"ipasir\", or \"cmdline:<command>\" to run an\n");
+		log("        external DIMACS solver executable.\n");
+		log("\n");
 		log("This pass is undef-aware, i.e. it considers don't-care values for detecting\n");
 		log("equivalent nodes.\n");
 		log("\n");
@@ -798,6 +803,7 @@ struct FreducePass : public Pass {
 		verbose_level = 0;
 		inv_mode = false;
 		dump_prefix = std::string();
+		std::string satsolver;
 
 		log_header(design, "Executing FREDUCE pass (perform functional reduction).\n");
 
@@ -823,10 +829,16 @@ struct FreducePass : public Pass {
 				dump_prefix = args[++argidx];
 				continue;
 			}
+			if (args[argidx] == "-satsolver" && argidx+1 < args.size()) {
+				satsolver = args[++argidx];
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
 
+		SatSolverScope satsolver_scope(satsolver);
+
 		int bitcount = 0;
 		for (auto module : design->selected_modules()) {
 			bitcount += FreduceWorker(design, module).run();
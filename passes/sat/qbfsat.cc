@@ -260,6 +260,7 @@ QbfSolutionType qbf_solve(RTLIL::Module *mod, const QbfSolveOptions &opt) {
 	log_assert(module->design != nullptr);
 
 	Pass::call(design, "design -push-copy");
+	module = design->module(module_name);
 
 	//Replace input wires with wires assigned $allconst cells:
 	pool<std::string> input_wires = validate_design_and_get_inputs(module, opt.assume_outputs);
@@ -307,6 +308,7 @@ QbfSolutionType qbf_solve(RTLIL::Module *mod, const QbfSolveOptions &opt) {
 		//If maximizing, grow until we get a failure.  Then bisect success and failure.
 		while (failure == 0 || difference(success, failure) > 1) {
 			Pass::call(design, "design -push-copy");
+			module = design->module(module_name);
 			log_header(design, "Preparing QBF-SAT problem.\n");
 
 			if (cur_thresh != 0) {
@@ -324,6 +326,7 @@ QbfSolutionType qbf_solve(RTLIL::Module *mod, const QbfSolveOptions &opt) {
 
 			if (!ret.unknown && ret.sat) {
 				Pass::call(design, "design -push-copy");
+				module = design->module(module_name);
 				specialize(module, ret, true);
 
 				RTLIL::SigSpec wire, value, undef;
@@ -27,6 +27,7 @@
 #include "kernel/sigtools.h"
 #include "kernel/log.h"
 #include "kernel/satgen.h"
+#include "kernel/profile.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <algorithm>
@@ -436,6 +437,7 @@ struct SatHelper
 	bool solve(const std::vector<int> &assumptions)
 	{
 		log_assert(gotTimeout == false);
+		ProfileScope profile("sat_solve");
 		ez->setSolverTimeout(timeout);
 		bool success = ez->solve(modelExpressions, modelValues, assumptions);
 		if (ez->getSolverTimoutStatus())
@@ -446,6 +448,7 @@ struct SatHelper
 	bool solve(int a = 0, int b = 0, int c = 0, int d = 0, int e = 0, int f = 0)
 	{
 		log_assert(gotTimeout == false);
+		ProfileScope profile("sat_solve");
 		ez->setSolverTimeout(timeout);
 		bool success = ez->solve(modelExpressions, modelValues, a, b, c, d, e, f);
 		if (ez->getSolverTimoutStatus())
@@ -876,6 +879,13 @@ void print_timeout()
 	log("\n");
 }
 
+void log_step_time(const char *step_name, int step, int64_t setup_start, int64_t solve_start)
+{
+	int64_t solve_end = PerformanceTimer::query();
+	log("[%s %d] Setup took %.2f seconds, SAT solver took %.2f seconds.\n", step_name, step,
+			(solve_start - setup_start) * 1e-9, (solve_end - solve_start) * 1e-9);
+}
+
 void print_qed()
 {
 	log("\n");
@@ -955,7 +965,13 @@ struct SatPass : public Pass {
 		log("        be numbered from 1 to N.\n");
 		log("\n");
 		log("        note: for large <N> it can be significantly faster to use\n");
-		log("        -tempinduct-baseonly -maxsteps <N> instead of -seq <N>.\n");
+		log("        -seq-incremental <N> instead of -seq <N>.\n");
+		log("\n");
+		log("    -seq-incremental <N>\n");
+		log("        like -seq <N>, but prove the condition one time step at a time\n");
+		log("        (bounded model checking). each step only adds the new clauses to the\n");
+		log("        solver, which keeps what it learned in the previous steps. the proof\n");
+		log("        stops at the first time step with a counterexample.\n");
 		log("\n");
 		log("    -set-at <N> <signal> <value>\n");
 		log("    -unset-at <N> <signal>\n");
@@ -1047,6 +1063,11 @@ struct SatPass : public Pass {
 		log("    -timeout <N>\n");
 		log("        Maximum number of seconds a single SAT instance may take.\n");
 		log("\n");
+		log("    -satsolver <solver>\n");
+		log("        use the given SAT solver. <solver> is \"minisat\" (the default), another\n");
+		log("        registered solver such as \"ipasir\", or \"cmdline:<command>\" to run an\n");
+		log("        external DIMACS solver executable (-timeout is not enforced for it).\n");
+		log("\n");
 		log("    -verify\n");
 		log("        Return an error and stop the synthesis script if the proof fails.\n");
 		log("\n");
@@ -1073,8 +1094,10 @@ struct SatPass : public Pass {
 		bool show_regs = false, show_public = false, show_all = false;
 		bool ignore_unknown_cells = false, falsify = false, tempinduct_def = false, set_init_def = false;
 		bool tempinduct_baseonly = false, tempinduct_inductonly = false, set_assumes = false;
+		bool seq_incremental = false;
 		int tempinduct_skip = 0, stepsize = 1;
 		std::string vcd_file_name, json_file_name, cnf_file_name;
+		std::string satsolver;
 
 		log_header(design, "Executing SAT pass (solving SAT problems in the circuit).\n");
 
@@ -1106,6 +1129,10 @@ struct SatPass : public Pass {
 				timeout = atoi(args[++argidx].c_str());
 				continue;
 			}
+			if (args[argidx] == "-satsolver" && argidx+1 < args.size()) {
+				satsolver = args[++argidx];
+				continue;
+			}
 			if (args[argidx] == "-max" && argidx+1 < args.size()) {
 				loopcount = atoi(args[++argidx].c_str());
 				continue;
@@ -1214,6 +1241,11 @@ struct SatPass : public Pass {
 				seq_len = atoi(args[++argidx].c_str());
 				continue;
 			}
+			if (args[argidx] == "-seq-incremental" && argidx+1 < args.size()) {
+				seq_len = atoi(args[++argidx].c_str());
+				seq_incremental = true;
+				continue;
+			}
 			if (args[argidx] == "-set-at" && argidx+3 < args.size()) {
 				int timestep = atoi(args[++argidx].c_str());
 				std::string lhs = args[++argidx];
@@ -1312,6 +1344,8 @@ struct SatPass : public Pass {
 		}
 		extra_args(args, argidx, design);
 
+		SatSolverScope satsolver_scope(satsolver);
+
 		RTLIL::Module *module = NULL;
 		for (auto mod : design->selected_modules()) {
 			if (module)
@@ -1324,6 +1358,12 @@ struct SatPass : public Pass {
 		if (!prove.size() && !prove_x.size() && !prove_asserts && tempinduct)
 			log_cmd_error("Got -tempinduct but nothing to prove!\n");
 
+		if (seq_incremental && !prove.size() && !prove_x.size() && !prove_asserts)
+			log_cmd_error("Got -seq-incremental but nothing to prove!\n");
+
+		if (seq_incremental && tempinduct)
+			log_cmd_error("Options -seq-incremental and -tempinduct don't work with each other. Use -seq instead.\n");
+
 		if (prove_skip && tempinduct)
 			log_cmd_error("Options -prove-skip and -tempinduct don't work with each other. Use -seq instead of -prove-skip.\n");
 
@@ -1439,6 +1479,7 @@ struct SatPass : public Pass {
 
 				if (!tempinduct_inductonly)
 				{
+					int64_t setup_start = PerformanceTimer::query();
 					basecase.setup(seq_len + inductlen, seq_len + inductlen == 1);
 					int property = basecase.setup_proof(seq_len + inductlen);
 					basecase.generate_model();
@@ -1452,7 +1493,11 @@ struct SatPass : public Pass {
 								inductlen, basecase.ez->numCnfVariables(), basecase.ez->numCnfClauses());
 						log_flush();
 
-						if (basecase.solve(basecase.ez->NOT(property))) {
+						int64_t solve_start = PerformanceTimer::query();
+						bool found_model = basecase.solve(basecase.ez->NOT(property));
+						log_step_time("base case", inductlen, setup_start, solve_start);
+
+						if (found_model) {
 							log("SAT temporal induction proof finished - model found for base case: FAIL!\n");
 							print_proof_failed();
 							basecase.print_model();
@@ -1482,6 +1527,7 @@ struct SatPass : public Pass {
 
 				if (!tempinduct_baseonly)
 				{
+					int64_t setup_start = PerformanceTimer::query();
 					inductstep.setup(inductlen + 1);
 					int property = inductstep.setup_proof(inductlen + 1);
 					inductstep.generate_model();
@@ -1524,7 +1570,11 @@ struct SatPass : public Pass {
 								inductlen, inductstep.ez->numCnfVariables(), inductstep.ez->numCnfClauses());
 						log_flush();
 
-						if (!inductstep.solve(inductstep.ez->NOT(property))) {
+						int64_t solve_start = PerformanceTimer::query();
+						bool found_model = inductstep.solve(inductstep.ez->NOT(property));
+						log_step_time("induction step", inductlen, setup_start, solve_start);
+
+						if (!found_model) {
 							if (inductstep.gotTimeout)
 								goto timeout;
 							log("Induction step proven: SUCCESS!\n");
@@ -1597,6 +1647,38 @@ struct SatPass : public Pass {
 				sathelper.setup();
 				if (sathelper.prove.size() || sathelper.prove_x.size() || sathelper.prove_asserts)
 					sathelper.ez->assume(sathelper.ez->NOT(sathelper.setup_proof()));
+			} else if (seq_incremental) {
+				for (int timestep = 1; timestep <= seq_len; timestep++) {
+					int64_t setup_start = PerformanceTimer::query();
+					sathelper.setup(timestep, timestep == 1);
+					if (timestep <= prove_skip)
+						continue;
+					int property = sathelper.setup_proof(timestep);
+					if (timestep == seq_len) {
+						sathelper.ez->assume(sathelper.ez->NOT(property));
+						break;
+					}
+
+					log("\n[step %d] Solving problem with %d variables and %d clauses..\n",
+							timestep, sathelper.ez->numCnfVariables(), sathelper.ez->numCnfClauses());
+					log_flush();
+
+					int64_t solve_start = PerformanceTimer::query();
+					bool found_model = sathelper.solve(sathelper.ez->NOT(property));
+					log_step_time("step", timestep, setup_start, solve_start);
+
+					if (sathelper.gotTimeout)
+						goto timeout;
+
+					if (found_model) {
+						log("Found a counterexample in step %d.\n", timestep);
+						sathelper.ez->assume(sathelper.ez->NOT(property));
+						break;
+					}
+
+					log("Proof for step %d finished: SUCCESS!\n", timestep);
+					sathelper.ez->assume(property);
+				}
 			} else {
 				std::vector<int> prove_bits;
 				for (int timestep = 1; timestep <= seq_len; timestep++) {
@@ -21,6 +21,7 @@
 #include "kernel/sigtools.h"
 #include "kernel/celltypes.h"
 #include "kernel/mem.h"
+#include "kernel/vcdreader.h"
 
 #include <ctime>
 
@@ -617,9 +618,1164 @@ struct SimInstance
 	}
 };
 
+struct SimCompiled
+{
+	// Levelized simulation engine: the design hierarchy is flattened into
+	// a single array of nets, and the combinational cells are sorted into
+	// a topological order once, so that each settle step is a single pass
+	// over the dirty cells instead of a fixpoint iteration over hash maps.
+	//
+	// Each net holds up to 64 independent simulation lanes in a machine
+	// word, so that random stimulus for 64 test vectors can be evaluated
+	// in lockstep. With a single lane this is the plain compiled engine.
+
+	SimShared *shared;
+
+	struct scope_t
+	{
+		Module *module;
+		Cell *instance;
+		scope_t *parent;
+		SigMap sigmap;
+		dict<SigBit, int> nets;
+		dict<Cell*, scope_t*> children;
+		pool<Cell*> formal_database;
+		std::vector<Mem> memories;
+		dict<Wire*, pair<int, Const>> vcd_database;
+
+		scope_t(Module *module, Cell *instance, scope_t *parent) :
+				module(module), instance(instance), parent(parent), sigmap(module) { }
+
+		~scope_t()
+		{
+			for (auto child : children)
+				delete child.second;
+		}
+
+		IdString name() const
+		{
+			if (instance != nullptr)
+				return instance->name;
+			return module->name;
+		}
+
+		std::string hiername() const
+		{
+			if (instance != nullptr)
+				return parent->hiername() + "." + log_id(instance->name);
+
+			return log_id(module->name);
+		}
+	};
+
+	enum node_op_t
+	{
+		OP_GENERIC, OP_MEMRD, OP_MUX, OP_PMUX,
+		OP_NOT, OP_POS, OP_AND, OP_OR, OP_XOR, OP_XNOR, OP_NAND, OP_NOR, OP_ANDNOT, OP_ORNOT, OP_AOI3, OP_OAI3,
+		OP_NEG, OP_REDUCE_AND, OP_REDUCE_OR, OP_REDUCE_XOR, OP_REDUCE_XNOR,
+		OP_LOGIC_NOT, OP_LOGIC_AND, OP_LOGIC_OR,
+		OP_EQ, OP_NE, OP_LT, OP_LE, OP_GT, OP_GE,
+		OP_ADD, OP_SUB, OP_MUL, OP_SHL, OP_SHR, OP_SSHL, OP_SSHR
+	};
+
+	struct node_t
+	{
+		Cell *cell = nullptr;
+		int op = OP_GENERIC;
+		int mem = -1;
+		bool has_c = false, has_s = false;
+		bool signed_a = false, signed_b = false;
+		std::vector<int> a, b, c, s, y;
+	};
+
+	// Saved values of a signal, one pair of lane words per bit
+	struct lanes_t
+	{
+		std::vector<uint64_t> val, unk;
+
+		lanes_t(int width = 0) : val(width, 0), unk(width, ~uint64_t(0)) { }
+	};
+
+	struct ff_t
+	{
+		Cell *cell;
+		int clk;
+		bool clkpol;
+		std::vector<int> d, q;
+		lanes_t past_clock;
+		lanes_t past_d;
+	};
+
+	struct mem_t
+	{
+		Mem *mem;
+		int node = -1;
+		std::vector<std::vector<int>> rd_addr, rd_data;
+		std::vector<int> wr_clk;
+		std::vector<std::vector<int>> wr_en, wr_addr, wr_data;
+		std::vector<lanes_t> past_wr_clk;
+		std::vector<lanes_t> past_wr_en;
+		std::vector<lanes_t> past_wr_addr;
+		std::vector<lanes_t> past_wr_data;
+		std::vector<Const> data;
+	};
+
+	struct formal_t
+	{
+		Cell *cell;
+		scope_t *scope;
+		int a, en;
+	};
+
+	struct vcd_t
+	{
+		int id;
+		std::vector<int> nets;
+		Const value;
+	};
+
+	scope_t *top = nullptr;
+	std::vector<scope_t*> scopes;
+
+	// Lane l of net n is stored as bit l of net_val[n] and net_unk[n]:
+	// 0 = (0,0), 1 = (1,0), x = (0,1), z = (1,1). Nets 0..3 are the constants.
+	int num_lanes;
+	uint64_t lane_mask;
+	int num_nets = 4;
+	std::vector<uint64_t> net_val, net_unk;
+	std::vector<int> reader_start, readers;
+
+	std::vector<node_t> nodes;
+	std::vector<uint64_t> dirty_nodes;
+	std::vector<ff_t> ffs;
+	std::vector<mem_t> mems;
+	std::vector<formal_t> formals;
+	std::vector<vcd_t> vcd_entries;
+	std::vector<uint64_t> result_val, result_unk;
+
+	// Current cycle, and the first cycle in which an assertion failed
+	// for each lane (or -1)
+	int cycle = 0;
+	std::vector<int> lane_failed;
+
+	SimCompiled(SimShared *shared, int num_lanes = 1) : shared(shared), num_lanes(num_lanes)
+	{
+		log_assert(num_lanes >= 1 && num_lanes <= 64);
+		lane_mask = num_lanes == 64 ? ~uint64_t(0) : (uint64_t(1) << num_lanes) - 1;
+		lane_failed.resize(num_lanes, -1);
+	}
+
+	~SimCompiled()
+	{
+		delete top;
+	}
+
+	static int const_net(State s)
+	{
+		switch (s) {
+			case State::S0: return 0;
+			case State::S1: return 1;
+			case State::Sz: return 3;
+			default: return 2;
+		}
+	}
+
+	int net(scope_t *scope, SigBit bit) const
+	{
+		bit = scope->sigmap(bit);
+		if (bit.wire == nullptr)
+			return const_net(bit.data);
+		return scope->nets.at(bit);
+	}
+
+	std::vector<int> nets(scope_t *scope, const SigSpec &sig) const
+	{
+		std::vector<int> result;
+		result.reserve(GetSize(sig));
+		for (auto bit : sig)
+			result.push_back(net(scope, bit));
+		return result;
+	}
+
+	static State lane_state(uint64_t val, uint64_t unk, int lane)
+	{
+		int v = (val >> lane) & 1;
+		int u = (unk >> lane) & 1;
+		return u ? (v ? State::Sz : State::Sx) : (v ? State::S1 : State::S0);
+	}
+
+	static void set_lane_state(uint64_t &val, uint64_t &unk, int lane, State s)
+	{
+		uint64_t mask = uint64_t(1) << lane;
+		val = (s == State::S1 || s == State::Sz) ? val | mask : val & ~mask;
+		unk = (s != State::S0 && s != State::S1) ? unk | mask : unk & ~mask;
+	}
+
+	State get_net(int n, int lane) const
+	{
+		return lane_state(net_val[n], net_unk[n], lane);
+	}
+
+	bool set_net(int n, uint64_t val, uint64_t unk)
+	{
+		if (n < 4)
+			return false;
+
+		val &= lane_mask, unk &= lane_mask;
+		if (net_val[n] == val && net_unk[n] == unk)
+			return false;
+
+		net_val[n] = val;
+		net_unk[n] = unk;
+
+		for (int i = reader_start[n]; i < reader_start[n+1]; i++)
+			dirty_nodes[readers[i] >> 6] |= uint64_t(1) << (readers[i] & 63);
+		return true;
+	}
+
+	bool set_net(int n, State s, int lane)
+	{
+		if (n < 4)
+			return false;
+
+		uint64_t val = net_val[n], unk = net_unk[n];
+		set_lane_state(val, unk, lane, s);
+		return set_net(n, val, unk);
+	}
+
+	Const get_const(const std::vector<int> &sig, int lane) const
+	{
+		Const value;
+		value.bits.reserve(sig.size());
+		for (int n : sig)
+			value.bits.push_back(get_net(n, lane));
+		return value;
+	}
+
+	bool set_const(const std::vector<int> &sig, const Const &value, int lane)
+	{
+		bool did_something = false;
+		log_assert(GetSize(sig) <= GetSize(value));
+		for (int i = 0; i < GetSize(sig); i++)
+			if (set_net(sig[i], value[i], lane))
+				did_something = true;
+		return did_something;
+	}
+
+	// Sets all lanes of a net to the same value
+	bool fill_net(int n, State s)
+	{
+		uint64_t val = (s == State::S1 || s == State::Sz) ? lane_mask : 0;
+		uint64_t unk = (s != State::S0 && s != State::S1) ? lane_mask : 0;
+		return set_net(n, val, unk);
+	}
+
+	void save_lanes(lanes_t &value, const std::vector<int> &sig) const
+	{
+		for (int i = 0; i < GetSize(sig); i++) {
+			value.val[i] = net_val[sig[i]];
+			value.unk[i] = net_unk[sig[i]];
+		}
+	}
+
+	static Const get_const(const lanes_t &value, int lane)
+	{
+		Const result;
+		result.bits.reserve(value.val.size());
+		for (int i = 0; i < GetSize(value.val); i++)
+			result.bits.push_back(lane_state(value.val[i], value.unk[i], lane));
+		return result;
+	}
+
+	// Zero-initialize: everything except '1' becomes '0'
+	static void zinit_lanes(lanes_t &value)
+	{
+		for (int i = 0; i < GetSize(value.val); i++) {
+			value.val[i] &= ~value.unk[i];
+			value.unk[i] = 0;
+		}
+	}
+
+	// Reads up to 64 nets of one lane as an integer
+	uint64_t lane_word(const std::vector<int> &sig, int lane) const
+	{
+		uint64_t value = 0;
+		for (int i = 0; i < GetSize(sig); i++)
+			value |= ((net_val[sig[i]] >> lane) & 1) << i;
+		return value;
+	}
+
+	static uint64_t word_mask(int width)
+	{
+		return width >= 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+	}
+
+	static uint64_t word_extend(uint64_t value, int width, bool is_signed)
+	{
+		if (is_signed && width > 0 && width < 64 && ((value >> (width-1)) & 1))
+			value |= ~word_mask(width);
+		return value;
+	}
+
+	static bool word_parity(uint64_t value)
+	{
+		value ^= value >> 32;
+		value ^= value >> 16;
+		value ^= value >> 8;
+		value ^= value >> 4;
+		value ^= value >> 2;
+		value ^= value >> 1;
+		return value & 1;
+	}
+
+	// Union-find over the nets while the hierarchy is flattened
+	std::vector<int> net_parent;
+
+	int find_net(int n)
+	{
+		while (net_parent[n] != n)
+			n = net_parent[n] = net_parent[net_parent[n]];
+		return n;
+	}
+
+	void unite_nets(int a, int b)
+	{
+		a = find_net(a), b = find_net(b);
+		if (a != b)
+			net_parent[std::max(a, b)] = std::min(a, b);
+	}
+
+	void create_scope(scope_t *scope)
+	{
+		scopes.push_back(scope);
+
+		for (auto wire : scope->module->wires())
+			for (auto bit : scope->sigmap(wire))
+				if (bit.wire != nullptr && scope->nets.count(bit) == 0) {
+					scope->nets[bit] = GetSize(net_parent);
+					net_parent.push_back(GetSize(net_parent));
+				}
+
+		scope->memories = Mem::get_all_memories(scope->module);
+
+		for (auto cell : scope->module->cells())
+		{
+			Module *mod = scope->module->design->module(cell->type);
+
+			if (mod != nullptr) {
+				scope_t *child = new scope_t(mod, cell, scope);
+				scope->children[cell] = child;
+				create_scope(child);
+
+				for (auto &conn : cell->connections()) {
+					Wire *w = mod->wire(conn.first);
+					if (w == nullptr || (!w->port_input && !w->port_output))
+						continue;
+					for (int i = 0; i < GetSize(conn.second) && i < GetSize(w); i++)
+						unite_nets(net(scope, conn.second[i]), net(child, SigBit(w, i)));
+				}
+			}
+
+			if (cell->type.in(ID($assert), ID($cover), ID($assume)))
+				scope->formal_database.insert(cell);
+		}
+	}
+
+	void add_vcd_entries(scope_t *scope)
+	{
+		for (auto &it : scope->vcd_database) {
+			vcd_t entry;
+			entry.id = it.second.first;
+			entry.nets = nets(scope, it.first);
+			vcd_entries.push_back(entry);
+		}
+
+		for (auto child : scope->children)
+			add_vcd_entries(child.second);
+	}
+
+	void add_formal_entries(scope_t *scope)
+	{
+		for (auto cell : scope->formal_database) {
+			formal_t formal;
+			formal.cell = cell;
+			formal.scope = scope;
+			formal.a = net(scope, cell->getPort(ID::A)[0]);
+			formal.en = net(scope, cell->getPort(ID::EN)[0]);
+			formals.push_back(formal);
+		}
+
+		for (auto child : scope->children)
+			add_formal_entries(child.second);
+	}
+
+	void add_cell_node(scope_t *scope, Cell *cell)
+	{
+		static const dict<IdString, int> fast_ops = {
+			{ID($mux), OP_MUX}, {ID($_MUX_), OP_MUX}, {ID($pmux), OP_PMUX},
+			{ID($not), OP_NOT}, {ID($_NOT_), OP_NOT}, {ID($pos), OP_POS}, {ID($_BUF_), OP_POS}, {ID($neg), OP_NEG},
+			{ID($and), OP_AND}, {ID($_AND_), OP_AND}, {ID($or), OP_OR}, {ID($_OR_), OP_OR},
+			{ID($xor), OP_XOR}, {ID($_XOR_), OP_XOR}, {ID($xnor), OP_XNOR}, {ID($_XNOR_), OP_XNOR},
+			{ID($_NAND_), OP_NAND}, {ID($_NOR_), OP_NOR}, {ID($_ANDNOT_), OP_ANDNOT}, {ID($_ORNOT_), OP_ORNOT},
+			{ID($_AOI3_), OP_AOI3}, {ID($_OAI3_), OP_OAI3},
+			{ID($reduce_and), OP_REDUCE_AND}, {ID($reduce_or), OP_REDUCE_OR}, {ID($reduce_bool), OP_REDUCE_OR},
+			{ID($reduce_xor), OP_REDUCE_XOR}, {ID($reduce_xnor), OP_REDUCE_XNOR},
+			{ID($logic_not), OP_LOGIC_NOT}, {ID($logic_and), OP_LOGIC_AND}, {ID($logic_or), OP_LOGIC_OR},
+			{ID($eq), OP_EQ}, {ID($ne), OP_NE}, {ID($lt), OP_LT}, {ID($le), OP_LE}, {ID($gt), OP_GT}, {ID($ge), OP_GE},
+			{ID($add), OP_ADD}, {ID($sub), OP_SUB}, {ID($mul), OP_MUL},
+			{ID($shl), OP_SHL}, {ID($sshl), OP_SSHL}, {ID($shr), OP_SHR}, {ID($sshr), OP_SSHR},
+		};
+
+		bool has_a = cell->hasPort(ID::A);
+		bool has_b = cell->hasPort(ID::B);
+		bool has_c = cell->hasPort(ID::C);
+		bool has_d = cell->hasPort(ID::D);
+		bool has_s = cell->hasPort(ID::S);
+		bool has_y = cell->hasPort(ID::Y);
+
+		// Same port patterns as SimInstance::update_cell()
+		if (!(has_a && !has_c && !has_d && !has_s && has_y) &&
+				!(has_a && has_b && has_c && !has_d && !has_s && has_y) &&
+				!(has_a && has_b && !has_c && !has_d && has_s && has_y)) {
+			log_warning("Unsupported evaluable cell type: %s (%s.%s)\n", log_id(cell->type), log_id(scope->module), log_id(cell));
+			return;
+		}
+
+		node_t node;
+		node.cell = cell;
+		node.has_c = has_c;
+		node.has_s = has_s;
+		node.a = nets(scope, cell->getPort(ID::A));
+		if (has_b) node.b = nets(scope, cell->getPort(ID::B));
+		if (has_c) node.c = nets(scope, cell->getPort(ID::C));
+		if (has_s) node.s = nets(scope, cell->getPort(ID::S));
+		node.y = nets(scope, cell->getPort(ID::Y));
+
+		auto it = fast_ops.find(cell->type);
+		if (it != fast_ops.end())
+			node.op = it->second;
+
+		node.signed_a = cell->hasParam(ID::A_SIGNED) && cell->getParam(ID::A_SIGNED).as_bool();
+		node.signed_b = cell->hasParam(ID::B_SIGNED) && cell->getParam(ID::B_SIGNED).as_bool();
+
+		if (node.op == OP_SSHL && !node.signed_a)
+			node.op = OP_SHL;
+		if (node.op == OP_SSHR && !node.signed_a)
+			node.op = OP_SHR;
+		if (node.op >= OP_SHL)
+			node.signed_b = false;
+
+		if (node.op == OP_MUX && (GetSize(node.s) != 1 || GetSize(node.a) != GetSize(node.b) || GetSize(node.y) > GetSize(node.a)))
+			node.op = OP_GENERIC;
+		if (node.op == OP_PMUX && (GetSize(node.b) != GetSize(node.a) * GetSize(node.s) || GetSize(node.y) > GetSize(node.a)))
+			node.op = OP_GENERIC;
+		if (node.op > OP_OAI3 && (GetSize(node.a) > 64 || GetSize(node.b) > 64 || GetSize(node.c) > 64 || GetSize(node.y) > 64))
+			node.op = OP_GENERIC;
+		if ((node.op == OP_SSHL || node.op == OP_SSHR) && GetSize(node.a) == 0)
+			node.op = OP_GENERIC;
+
+		// Cell types that are not shifts or unary ops only use signed arithmetic if both operands are signed
+		if (node.op != OP_NOT && node.op != OP_POS && node.op != OP_NEG && node.op < OP_SHL && !(node.signed_a && node.signed_b))
+			node.signed_a = node.signed_b = false;
+
+		nodes.push_back(node);
+	}
+
+	void add_scope_nodes(scope_t *scope)
+	{
+		for (auto &mem : scope->memories)
+		{
+			mem_t mdb;
+			mdb.mem = &mem;
+
+			for (auto &port : mem.rd_ports) {
+				if (port.clk_enable)
+					log_error("Memory %s.%s has clocked read ports. Run 'memory' with -nordff.\n", log_id(scope->module), log_id(mem.memid));
+				mdb.rd_addr.push_back(nets(scope, port.addr));
+				mdb.rd_data.push_back(nets(scope, port.data));
+			}
+
+			for (auto &port : mem.wr_ports) {
+				mdb.wr_clk.push_back(net(scope, port.clk[0]));
+				mdb.wr_en.push_back(nets(scope, port.en));
+				mdb.wr_addr.push_back(nets(scope, port.addr));
+				mdb.wr_data.push_back(nets(scope, port.data));
+				mdb.past_wr_clk.push_back(lanes_t(1));
+				mdb.past_wr_en.push_back(lanes_t(GetSize(port.en)));
+				mdb.past_wr_addr.push_back(lanes_t(GetSize(port.addr)));
+				mdb.past_wr_data.push_back(lanes_t(GetSize(port.data)));
+			}
+
+			mdb.data.resize(num_lanes, mem.get_init_data());
+
+			if (!mem.rd_ports.empty()) {
+				node_t node;
+				node.op = OP_MEMRD;
+				node.mem = GetSize(mems);
+				for (auto &addr : mdb.rd_addr)
+					node.a.insert(node.a.end(), addr.begin(), addr.end());
+				for (auto &data : mdb.rd_data)
+					node.y.insert(node.y.end(), data.begin(), data.end());
+				nodes.push_back(node);
+			}
+
+			mems.push_back(mdb);
+		}
+
+		for (auto cell : scope->module->cells())
+		{
+			if (scope->children.count(cell))
+				continue;
+
+			if (cell->type.in(ID($mem), ID($meminit), ID($memwr), ID($memrd)))
+				continue;
+
+			if (scope->formal_database.count(cell))
+				continue;
+
+			if (cell->type.in(ID($dff))) {
+				ff_t ff;
+				ff.cell = cell;
+				ff.clk = net(scope, cell->getPort(ID::CLK)[0]);
+				ff.clkpol = cell->getParam(ID::CLK_POLARITY).as_bool();
+				ff.d = nets(scope, cell->getPort(ID::D));
+				ff.q = nets(scope, cell->getPort(ID::Q));
+				ff.past_clock = lanes_t(1);
+				ff.past_d = lanes_t(cell->getParam(ID::WIDTH).as_int());
+				ffs.push_back(ff);
+				continue;
+			}
+
+			if (yosys_celltypes.cell_evaluable(cell->type)) {
+				add_cell_node(scope, cell);
+				continue;
+			}
+
+			log_error("Unsupported cell type: %s (%s.%s)\n", log_id(cell->type), log_id(scope->module), log_id(cell));
+		}
+	}
+
+	// Returns false if the design has a combinational loop
+	bool compile(Module *topmod)
+	{
+		net_parent = {0, 1, 2, 3};
+		top = new scope_t(topmod, nullptr, nullptr);
+		create_scope(top);
+
+		// Compact the net numbers, the constants are always the smallest roots
+		std::vector<int> net_index(GetSize(net_parent), -1);
+		for (int i = 0; i < GetSize(net_parent); i++) {
+			int root = find_net(i);
+			if (net_index[root] < 0)
+				net_index[root] = root < 4 ? root : num_nets++;
+			net_index[i] = net_index[root];
+		}
+		net_parent.clear();
+
+		for (auto scope : scopes)
+			for (auto &it : scope->nets)
+				it.second = net_index[it.second];
+
+		for (auto scope : scopes)
+			add_scope_nodes(scope);
+
+		// Levelize the combinational nodes (Kahn's algorithm)
+		std::vector<std::vector<int>> net_drivers(num_nets), net_readers(num_nets);
+		for (int i = 0; i < GetSize(nodes); i++) {
+			auto &node = nodes[i];
+			std::vector<int> inputs = node.a;
+			inputs.insert(inputs.end(), node.b.begin(), node.b.end());
+			inputs.insert(inputs.end(), node.c.begin(), node.c.end());
+			inputs.insert(inputs.end(), node.s.begin(), node.s.end());
+			std::sort(inputs.begin(), inputs.end());
+			inputs.erase(std::unique(inputs.begin(), inputs.end()), inputs.end());
+			for (int n : inputs)
+				net_readers[n].push_back(i);
+			std::vector<int> outputs = node.y;
+			std::sort(outputs.begin(), outputs.end());
+			outputs.erase(std::unique(outputs.begin(), outputs.end()), outputs.end());
+			for (int n : outputs)
+				net_drivers[n].push_back(i);
+		}
+
+		std::vector<int> indegree(GetSize(nodes)), level(GetSize(nodes)), order;
+		for (int n = 0; n < num_nets; n++)
+			for (int reader : net_readers[n])
+				indegree[reader] += GetSize(net_drivers[n]);
+
+		for (int i = 0; i < GetSize(nodes); i++)
+			if (indegree[i] == 0)
+				order.push_back(i);
+
+		int num_levels = 0;
+		for (int k = 0; k < GetSize(order); k++) {
+			int i = order[k];
+			num_levels = std::max(num_levels, level[i] + 1);
+			std::vector<int> outputs = nodes[i].y;
+			std::sort(outputs.begin(), outputs.end());
+			outputs.erase(std::unique(outputs.begin(), outputs.end()), outputs.end());
+			for (int n : outputs)
+				for (int reader : net_readers[n]) {
+					level[reader] = std::max(level[reader], level[i] + 1);
+					if (--indegree[reader] == 0)
+						order.push_back(reader);
+				}
+		}
+
+		if (GetSize(order) != GetSize(nodes))
+			return false;
+
+		std::vector<int> node_index(GetSize(nodes));
+		std::vector<node_t> sorted_nodes;
+		sorted_nodes.reserve(GetSize(nodes));
+		for (int k = 0; k < GetSize(order); k++) {
+			node_index[order[k]] = k;
+			sorted_nodes.push_back(std::move(nodes[order[k]]));
+			if (sorted_nodes.back().op == OP_MEMRD)
+				mems[sorted_nodes.back().mem].node = k;
+		}
+		nodes.swap(sorted_nodes);
+
+		reader_start.resize(num_nets+1);
+		for (int n = 0; n < num_nets; n++) {
+			reader_start[n] = GetSize(readers);
+			for (int reader : net_readers[n])
+				readers.push_back(node_index[reader]);
+		}
+		reader_start[num_nets] = GetSize(readers);
+
+		net_val.assign(num_nets, 0);
+		net_unk.assign(num_nets, lane_mask);
+		dirty_nodes.assign((GetSize(nodes) + 63) / 64, 0);
+
+		// Constant nets, all other nets start out as 'x'
+		net_unk[0] = net_unk[1] = 0;
+		net_val[1] = net_val[3] = lane_mask;
+
+		// Evaluate every node once in the first cycle, so that the result does
+		// not depend on which nets happen to change from their initial 'x'.
+		for (int i = 0; i < GetSize(nodes); i++)
+			dirty_nodes[i >> 6] |= uint64_t(1) << (i & 63);
+
+		for (auto scope : scopes)
+			for (auto wire : scope->module->wires())
+				if (wire->attributes.count(ID::init)) {
+					std::vector<int> sig = nets(scope, wire);
+					Const initval = wire->attributes.at(ID::init);
+					for (int i = 0; i < GetSize(sig) && i < GetSize(initval); i++)
+						if (initval[i] == State::S0 || initval[i] == State::S1)
+							fill_net(sig[i], initval[i]);
+				}
+
+		if (shared->zinit)
+		{
+			for (auto &ff : ffs) {
+				zinit_lanes(ff.past_d);
+				lanes_t qdata(GetSize(ff.q));
+				save_lanes(qdata, ff.q);
+				zinit_lanes(qdata);
+				for (int i = 0; i < GetSize(ff.q); i++)
+					set_net(ff.q[i], qdata.val[i], qdata.unk[i]);
+			}
+
+			for (auto &mdb : mems) {
+				for (auto &val : mdb.past_wr_en)
+					zinit_lanes(val);
+				for (auto &data : mdb.data)
+					zinit(data);
+			}
+		}
+
+		add_formal_entries(top);
+
+		log("Compiled simulation netlist: %d nets, %d nodes in %d levels, %d flip-flops, %d memories.\n",
+				num_nets, GetSize(nodes), num_levels, GetSize(ffs), GetSize(mems));
+		return true;
+	}
+
+	// Native evaluation of a cell with fully defined inputs of at most 64 bits
+	static uint64_t eval_word(const node_t &node, uint64_t a, uint64_t b, uint64_t c)
+	{
+		int width = GetSize(node.y);
+		uint64_t y;
+
+		a = word_extend(a, GetSize(node.a), node.signed_a);
+		b = word_extend(b, GetSize(node.b), node.signed_b);
+
+		switch (node.op)
+		{
+			case OP_NOT:         y = ~a; break;
+			case OP_POS:         y = a; break;
+			case OP_NEG:         y = -a; break;
+			case OP_AND:         y = a & b; break;
+			case OP_OR:          y = a | b; break;
+			case OP_XOR:         y = a ^ b; break;
+			case OP_XNOR:        y = ~(a ^ b); break;
+			case OP_NAND:        y = ~(a & b); break;
+			case OP_NOR:         y = ~(a | b); break;
+			case OP_ANDNOT:      y = a & ~b; break;
+			case OP_ORNOT:       y = a | ~b; break;
+			case OP_AOI3:        y = ~((a & b) | c); break;
+			case OP_OAI3:        y = ~((a | b) & c); break;
+			case OP_REDUCE_AND:  y = a == word_mask(GetSize(node.a)); break;
+			case OP_REDUCE_OR:   y = a != 0; break;
+			case OP_REDUCE_XOR:  y = word_parity(a); break;
+			case OP_REDUCE_XNOR: y = !word_parity(a); break;
+			case OP_LOGIC_NOT:   y = a == 0; break;
+			case OP_LOGIC_AND:   y = a != 0 && b != 0; break;
+			case OP_LOGIC_OR:    y = a != 0 || b != 0; break;
+			case OP_EQ:          y = a == b; break;
+			case OP_NE:          y = a != b; break;
+			case OP_LT:          y = node.signed_a ? int64_t(a) < int64_t(b) : a < b; break;
+			case OP_LE:          y = node.signed_a ? int64_t(a) <= int64_t(b) : a <= b; break;
+			case OP_GT:          y = node.signed_a ? int64_t(a) > int64_t(b) : a > b; break;
+			case OP_GE:          y = node.signed_a ? int64_t(a) >= int64_t(b) : a >= b; break;
+			case OP_ADD:         y = a + b; break;
+			case OP_SUB:         y = a - b; break;
+			case OP_MUL:         y = a * b; break;
+			case OP_SHL:         y = b >= 64 ? 0 : a << b; break;
+			case OP_SHR:         y = b >= 64 ? 0 : (a & word_mask(std::max(width, GetSize(node.a)))) >> b; break;
+			case OP_SSHL:        y = b >= 64 ? 0 : a << b; break;
+			case OP_SSHR:        y = uint64_t(int64_t(a) >> std::min(b, uint64_t(63))); break;
+			default: log_abort();
+		}
+
+		return y & word_mask(width);
+	}
+
+	// Bit i of a signal in all lanes, extended like the cell library does
+	uint64_t ext_lanes(const std::vector<int> &sig, int i, bool is_signed) const
+	{
+		if (i < GetSize(sig))
+			return net_val[sig[i]];
+		if (is_signed && !sig.empty())
+			return net_val[sig.back()];
+		return 0;
+	}
+
+	// Fills result_val[] for all lanes, assuming that all inputs are defined
+	void eval_fast(const node_t &node)
+	{
+		int width = GetSize(node.y);
+
+		// Bitwise cells are evaluated for all lanes at once
+		if (node.op <= OP_OAI3)
+		{
+			for (int i = 0; i < width; i++)
+			{
+				uint64_t a = ext_lanes(node.a, i, node.signed_a);
+				uint64_t b = ext_lanes(node.b, i, node.signed_b);
+				uint64_t c = ext_lanes(node.c, i, false);
+
+				switch (node.op)
+				{
+					case OP_NOT:    result_val[i] = ~a; break;
+					case OP_POS:    result_val[i] = a; break;
+					case OP_AND:    result_val[i] = a & b; break;
+					case OP_OR:     result_val[i] = a | b; break;
+					case OP_XOR:    result_val[i] = a ^ b; break;
+					case OP_XNOR:   result_val[i] = ~(a ^ b); break;
+					case OP_NAND:   result_val[i] = ~(a & b); break;
+					case OP_NOR:    result_val[i] = ~(a | b); break;
+					case OP_ANDNOT: result_val[i] = a & ~b; break;
+					case OP_ORNOT:  result_val[i] = a | ~b; break;
+					case OP_AOI3:   result_val[i] = ~((a & b) | c); break;
+					case OP_OAI3:   result_val[i] = ~((a | b) & c); break;
+					default: log_abort();
+				}
+			}
+			return;
+		}
+
+		for (int lane = 0; lane < num_lanes; lane++)
+		{
+			uint64_t y = eval_word(node, lane_word(node.a, lane), lane_word(node.b, lane), lane_word(node.c, lane));
+			for (int i = 0; i < width; i++)
+				result_val[i] |= ((y >> i) & 1) << lane;
+		}
+	}
+
+	void eval_memrd(const node_t &node)
+	{
+		auto &mdb = mems[node.mem];
+		auto &mem = *mdb.mem;
+
+		for (int lane = 0; lane < num_lanes; lane++)
+			for (int port_idx = 0; port_idx < GetSize(mem.rd_ports); port_idx++)
+			{
+				Const addr = get_const(mdb.rd_addr[port_idx], lane);
+				Const data = Const(State::Sx, mem.width);
+
+				if (addr.is_fully_def()) {
+					int index = addr.as_int() - mem.start_offset;
+					if (index >= 0 && index < mem.size)
+						data = mdb.data[lane].extract(index*mem.width, mem.width);
+				}
+
+				set_const(mdb.rd_data[port_idx], data, lane);
+			}
+	}
+
+	void eval_node(const node_t &node)
+	{
+		int width = GetSize(node.y);
+
+		if (node.op == OP_MEMRD) {
+			eval_memrd(node);
+			return;
+		}
+
+		// Multiplexers just copy the selected input, including undefined bits
+		if (node.op == OP_MUX) {
+			uint64_t sel = net_val[node.s[0]] & ~net_unk[node.s[0]];
+			for (int i = 0; i < width; i++)
+				set_net(node.y[i], (net_val[node.b[i]] & sel) | (net_val[node.a[i]] & ~sel),
+						(net_unk[node.b[i]] & sel) | (net_unk[node.a[i]] & ~sel));
+			return;
+		}
+
+		result_val.assign(width, 0);
+		result_unk.assign(width, 0);
+
+		if (node.op == OP_PMUX) {
+			for (int i = 0; i < width; i++) {
+				result_val[i] = net_val[node.a[i]];
+				result_unk[i] = net_unk[node.a[i]];
+			}
+			for (int k = 0; k < GetSize(node.s); k++) {
+				uint64_t sel = net_val[node.s[k]] & ~net_unk[node.s[k]];
+				const int *src = node.b.data() + k*GetSize(node.a);
+				for (int i = 0; sel != 0 && i < width; i++) {
+					result_val[i] = (net_val[src[i]] & sel) | (result_val[i] & ~sel);
+					result_unk[i] = (net_unk[src[i]] & sel) | (result_unk[i] & ~sel);
+				}
+			}
+			for (int i = 0; i < width; i++)
+				set_net(node.y[i], result_val[i], result_unk[i]);
+			return;
+		}
+
+		// Lanes with undefined inputs are evaluated with CellTypes::eval()
+		uint64_t slow_lanes = lane_mask;
+
+		if (node.op != OP_GENERIC) {
+			uint64_t undef = 0;
+			for (int n : node.a) undef |= net_unk[n];
+			for (int n : node.b) undef |= net_unk[n];
+			for (int n : node.c) undef |= net_unk[n];
+			slow_lanes = undef & lane_mask;
+			if (slow_lanes != lane_mask)
+				eval_fast(node);
+		}
+
+		for (int lane = 0; slow_lanes != 0 && lane < num_lanes; lane++)
+		{
+			if (((slow_lanes >> lane) & 1) == 0)
+				continue;
+
+			Const result;
+			if (node.has_c)
+				result = CellTypes::eval(node.cell, get_const(node.a, lane), get_const(node.b, lane), get_const(node.c, lane));
+			else if (node.has_s)
+				result = CellTypes::eval(node.cell, get_const(node.a, lane), get_const(node.b, lane), get_const(node.s, lane));
+			else
+				result = CellTypes::eval(node.cell, get_const(node.a, lane), get_const(node.b, lane));
+
+			log_assert(width <= GetSize(result));
+			for (int i = 0; i < width; i++)
+				set_lane_state(result_val[i], result_unk[i], lane, result[i]);
+		}
+
+		for (int i = 0; i < width; i++)
+			set_net(node.y[i], result_val[i], result_unk[i]);
+	}
+
+	void update_ph1()
+	{
+		// Nodes only mark nodes later in the topological order as dirty,
+		// so a single ascending scan settles all combinational logic.
+		for (int w = 0; w < GetSize(dirty_nodes); w++)
+			while (dirty_nodes[w] != 0) {
+				uint64_t word = dirty_nodes[w];
+				int bit = 0;
+				while (((word >> bit) & 1) == 0)
+					bit++;
+				dirty_nodes[w] = word & (word - 1);
+				eval_node(nodes[w*64 + bit]);
+			}
+	}
+
+	// Lanes in which a clock changed to its active level, i.e. the past
+	// value was not the active level and the current value is.
+	uint64_t clock_edge(bool polarity, const lanes_t &past, int n) const
+	{
+		uint64_t past_active = (polarity ? past.val[0] : ~past.val[0]) & ~past.unk[0];
+		uint64_t active = (polarity ? net_val[n] : ~net_val[n]) & ~net_unk[n];
+		return ~past_active & active & lane_mask;
+	}
+
+	bool update_ph2()
+	{
+		bool did_something = false;
+
+		for (auto &ff : ffs)
+		{
+			uint64_t edge = clock_edge(ff.clkpol, ff.past_clock, ff.clk);
+
+			if (edge == 0)
+				continue;
+
+			for (int i = 0; i < GetSize(ff.q); i++) {
+				int n = ff.q[i];
+				if (set_net(n, (net_val[n] & ~edge) | (ff.past_d.val[i] & edge), (net_unk[n] & ~edge) | (ff.past_d.unk[i] & edge)))
+					did_something = true;
+			}
+		}
+
+		for (auto &mdb : mems)
+		{
+			auto &mem = *mdb.mem;
+
+			for (int port_idx = 0; port_idx < GetSize(mem.wr_ports); port_idx++)
+			{
+				auto &port = mem.wr_ports[port_idx];
+				uint64_t lanes = port.clk_enable ? clock_edge(port.clk_polarity, mdb.past_wr_clk[port_idx], mdb.wr_clk[port_idx]) : lane_mask;
+
+				for (int lane = 0; lanes != 0 && lane < num_lanes; lane++)
+				{
+					if (((lanes >> lane) & 1) == 0)
+						continue;
+
+					Const addr, data, enable;
+
+					if (!port.clk_enable)
+					{
+						addr = get_const(mdb.wr_addr[port_idx], lane);
+						data = get_const(mdb.wr_data[port_idx], lane);
+						enable = get_const(mdb.wr_en[port_idx], lane);
+					}
+					else
+					{
+						addr = get_const(mdb.past_wr_addr[port_idx], lane);
+						data = get_const(mdb.past_wr_data[port_idx], lane);
+						enable = get_const(mdb.past_wr_en[port_idx], lane);
+					}
+
+					if (addr.is_fully_def())
+					{
+						int index = addr.as_int() - mem.start_offset;
+						if (index >= 0 && index < mem.size)
+							for (int i = 0; i < mem.width; i++)
+								if (enable[i] == State::S1 && mdb.data[lane].bits.at(index*mem.width+i) != data[i]) {
+									mdb.data[lane].bits.at(index*mem.width+i) = data[i];
+									if (mdb.node >= 0)
+										dirty_nodes[mdb.node >> 6] |= uint64_t(1) << (mdb.node & 63);
+									did_something = true;
+								}
+					}
+				}
+			}
+		}
+
+		return did_something;
+	}
+
+	std::string lanes_str(uint64_t lanes) const
+	{
+		if (num_lanes == 1)
+			return "";
+		if (lanes == lane_mask)
+			return " in all lanes";
+
+		std::string str;
+		for (int lane = 0; lane < num_lanes; lane++)
+			if ((lanes >> lane) & 1)
+				str += stringf("%s%d", str.empty() ? "" : ", ", lane);
+		return stringf(" in lane%s %s", (lanes & (lanes - 1)) ? "s" : "", str.c_str());
+	}
+
+	void update_ph3()
+	{
+		for (auto &ff : ffs) {
+			ff.past_clock.val[0] = net_val[ff.clk];
+			ff.past_clock.unk[0] = net_unk[ff.clk];
+			save_lanes(ff.past_d, ff.d);
+		}
+
+		for (auto &mdb : mems)
+			for (int i = 0; i < GetSize(mdb.mem->wr_ports); i++) {
+				mdb.past_wr_clk[i].val[0] = net_val[mdb.wr_clk[i]];
+				mdb.past_wr_clk[i].unk[0] = net_unk[mdb.wr_clk[i]];
+				save_lanes(mdb.past_wr_en[i], mdb.wr_en[i]);
+				save_lanes(mdb.past_wr_addr[i], mdb.wr_addr[i]);
+				save_lanes(mdb.past_wr_data[i], mdb.wr_data[i]);
+			}
+
+		for (auto &formal : formals)
+		{
+			Cell *cell = formal.cell;
+			uint64_t en = net_val[formal.en] & ~net_unk[formal.en];
+			uint64_t a = net_val[formal.a] & ~net_unk[formal.a];
+			uint64_t lanes = en & ~a & lane_mask;
+
+			if (lanes == 0)
+				continue;
+
+			string label = log_id(cell);
+			if (cell->attributes.count(ID::src))
+				label = cell->attributes.at(ID::src).decode_string();
+
+			if (cell->type == ID($cover))
+				log("Cover %s.%s (%s) reached%s.\n", formal.scope->hiername().c_str(), log_id(cell), label.c_str(), lanes_str(lanes).c_str());
+
+			if (cell->type == ID($assume))
+				log("Assumption %s.%s (%s) failed%s.\n", formal.scope->hiername().c_str(), log_id(cell), label.c_str(), lanes_str(lanes).c_str());
+
+			if (cell->type == ID($assert)) {
+				log_warning("Assert %s.%s (%s) failed%s.\n", formal.scope->hiername().c_str(), log_id(cell), label.c_str(), lanes_str(lanes).c_str());
+				for (int lane = 0; lane < num_lanes; lane++)
+					if (((lanes >> lane) & 1) && lane_failed[lane] < 0)
+						lane_failed[lane] = cycle;
+			}
+		}
+	}
+
+	void report_lanes()
+	{
+		int num_failed = 0;
+
+		for (int lane = 0; lane < num_lanes; lane++)
+			if (lane_failed[lane] >= 0) {
+				log("Lane %d: first assertion failure in cycle %d.\n", lane, lane_failed[lane]);
+				num_failed++;
+			}
+
+		log("%d of %d lanes failed assertions.\n", num_failed, num_lanes);
+	}
+
+	void set_state(Wire *wire, State value)
+	{
+		for (int n : nets(top, wire))
+			fill_net(n, value);
+	}
+
+	void set_state(Wire *wire, const Const &value)
+	{
+		std::vector<int> sig = nets(top, wire);
+		for (int i = 0; i < GetSize(sig); i++)
+			fill_net(sig[i], value[i]);
+	}
+
+	Const get_state(Wire *wire) const
+	{
+		return get_const(nets(top, wire), 0);
+	}
+
+	void writeback(scope_t *scope, pool<Module*> &wbmods)
+	{
+		if (wbmods.count(scope->module))
+			log_error("Instance %s of module %s is not unique: Writeback not possible. (Fix by running 'uniquify'.)\n", scope->hiername().c_str(), log_id(scope->module));
+
+		wbmods.insert(scope->module);
+
+		for (auto wire : scope->module->wires())
+			wire->attributes.erase(ID::init);
+
+		for (auto child : scope->children)
+			writeback(child.second, wbmods);
+	}
+
+	void writeback(pool<Module*> &wbmods)
+	{
+		writeback(top, wbmods);
+
+		for (auto &ff : ffs)
+		{
+			SigSpec sig_q = ff.cell->getPort(ID::Q);
+			Const initval = get_const(ff.q, 0);
+
+			for (int i = 0; i < GetSize(sig_q); i++)
+			{
+				Wire *w = sig_q[i].wire;
+
+				if (w->attributes.count(ID::init) == 0)
+					w->attributes[ID::init] = Const(State::Sx, GetSize(w));
+
+				w->attributes[ID::init][sig_q[i].offset] = initval[i];
+			}
+		}
+
+		for (auto &mdb : mems)
+		{
+			mdb.mem->clear_inits();
+			MemInit minit;
+			minit.addr = mdb.mem->start_offset;
+			minit.data = mdb.data[0];
+			mdb.mem->inits.push_back(minit);
+			mdb.mem->emit();
+		}
+	}
+
+	void write_vcd_header(scope_t *scope, std::ofstream &f, int &id)
+	{
+		f << stringf("$scope module %s $end\n", log_id(scope->name()));
+
+		for (auto wire : scope->module->wires())
+		{
+			if (shared->hide_internal && wire->name[0] == '$')
+				continue;
+
+			f << stringf("$var wire %d n%d %s%s $end\n", GetSize(wire), id, wire->name[0] == '$' ? "\\" : "", log_id(wire));
+			scope->vcd_database[wire] = make_pair(id++, Const());
+		}
+
+		for (auto child : scope->children)
+			write_vcd_header(child.second, f, id);
+
+		f << stringf("$upscope $end\n");
+	}
+
+	void write_vcd_header(std::ofstream &f, int &id)
+	{
+		write_vcd_header(top, f, id);
+		add_vcd_entries(top);
+	}
+
+	void write_vcd_step(std::ofstream &f)
+	{
+		for (auto &entry : vcd_entries)
+		{
+			Const value = get_const(entry.nets, 0);
+
+			if (entry.value == value)
+				continue;
+
+			entry.value = value;
+
+			f << "b";
+			for (int i = GetSize(value)-1; i >= 0; i--) {
+				switch (value[i]) {
+					case State::S0: f << "0"; break;
+					case State::S1: f << "1"; break;
+					case State::Sx: f << "x"; break;
+					default: f << "z";
+				}
+			}
+
+			f << stringf(" n%d\n", entry.id);
+		}
+	}
+};
+
 struct SimWorker : SimShared
 {
 	SimInstance *top = nullptr;
+	SimCompiled *compiled = nullptr;
+	bool use_compiled = false;
+	int num_lanes = 0;
+	uint64_t rng_state = 1;
+	std::vector<Wire*> random_inports;
+	std::string replay_file, replay_scope;
 	std::ofstream vcdfile;
 	pool<IdString> clock, clockn, reset, resetn;
 	std::string timescale;
@@ -627,6 +1783,7 @@ struct SimWorker : SimShared
 	~SimWorker()
 	{
 		delete top;
+		delete compiled;
 	}
 
 	void write_vcd_header()
@@ -646,22 +1803,38 @@ struct SimWorker : SimShared
 			vcdfile << stringf("$timescale %s $end\n", timescale.c_str());
 
 		int id = 1;
-		top->write_vcd_header(vcdfile, id);
+		if (compiled)
+			compiled->write_vcd_header(vcdfile, id);
+		else
+			top->write_vcd_header(vcdfile, id);
 
 		vcdfile << stringf("$enddefinitions $end\n");
 	}
 
-	void write_vcd_step(int t)
+	void write_vcd_step(int64_t t)
 	{
 		if (!vcdfile.is_open())
 			return;
 
-		vcdfile << stringf("#%d\n", t);
-		top->write_vcd_step(vcdfile);
+		vcdfile << stringf("#%lld\n", (long long)t);
+		if (compiled)
+			compiled->write_vcd_step(vcdfile);
+		else
+			top->write_vcd_step(vcdfile);
 	}
 
 	void update()
 	{
+		if (compiled)
+		{
+			do
+				compiled->update_ph1();
+			while (compiled->update_ph2());
+
+			compiled->update_ph3();
+			return;
+		}
+
 		while (1)
 		{
 			if (debug)
@@ -684,21 +1857,95 @@ struct SimWorker : SimShared
 
 	void set_inports(pool<IdString> ports, State value)
 	{
+		Module *topmod = compiled ? compiled->top->module : top->module;
+
 		for (auto portname : ports)
 		{
-			Wire *w = top->module->wire(portname);
+			Wire *w = topmod->wire(portname);
 
 			if (w == nullptr)
-				log_error("Can't find port %s on module %s.\n", log_id(portname), log_id(top->module));
+				log_error("Can't find port %s on module %s.\n", log_id(portname), log_id(topmod));
+
+			if (compiled)
+				compiled->set_state(w, value);
+			else
+				top->set_state(w, value);
+		}
+	}
+
+	uint64_t next_random()
+	{
+		// xorshift64
+		rng_state ^= rng_state << 13;
+		rng_state ^= rng_state >> 7;
+		rng_state ^= rng_state << 17;
+		return rng_state;
+	}
+
+	void set_random_inports()
+	{
+		for (auto wire : random_inports)
+			for (int n : compiled->nets(compiled->top, wire))
+				compiled->set_net(n, next_random(), 0);
+	}
 
-			top->set_state(w, value);
+	void set_port(Wire *wire, const Const &value)
+	{
+		if (compiled)
+			compiled->set_state(wire, value);
+		else
+			top->set_state(wire, value);
+	}
+
+	Const get_port(Wire *wire)
+	{
+		return compiled ? compiled->get_state(wire) : top->get_state(wire);
+	}
+
+	void setup(Module *topmod)
+	{
+		log_assert(top == nullptr && compiled == nullptr);
+
+		if (num_lanes > 0)
+		{
+			compiled = new SimCompiled(this, num_lanes);
+			if (!compiled->compile(topmod))
+				log_error("Design has combinational loops, which are not supported with -lanes.\n");
+
+			for (auto wire : topmod->wires())
+				if (wire->port_input && !clock.count(wire->name) && !clockn.count(wire->name) &&
+						!reset.count(wire->name) && !resetn.count(wire->name))
+					random_inports.push_back(wire);
+
+			log("Driving %d input ports with random values in %d lanes.\n", GetSize(random_inports), num_lanes);
 		}
+		else if (use_compiled && debug)
+			log("Debug output is only supported by the interpreted engine, not using -compiled.\n");
+		else if (use_compiled) {
+			compiled = new SimCompiled(this);
+			if (!compiled->compile(topmod)) {
+				log("Design has combinational loops, falling back to the interpreted engine.\n");
+				delete compiled;
+				compiled = nullptr;
+			}
+		}
+
+		if (compiled == nullptr)
+			top = new SimInstance(this, topmod);
+	}
+
+	void do_writeback()
+	{
+		pool<Module*> wbmods;
+		if (compiled)
+			compiled->writeback(wbmods);
+		else
+			top->writeback(wbmods);
 	}
 
 	void run(Module *topmod, int numcycles)
 	{
-		log_assert(top == nullptr);
-		top = new SimInstance(this, topmod);
+		setup(topmod);
 
 		if (debug)
 			log("\n===== 0 =====\n");
@@ -711,6 +1958,9 @@ struct SimWorker : SimShared
 		set_inports(clock, State::Sx);
 		set_inports(clockn, State::Sx);
 
+		if (num_lanes > 0)
+			set_random_inports();
+
 		update();
 
 		write_vcd_header();
@@ -724,6 +1974,9 @@ struct SimWorker : SimShared
 			set_inports(clock, State::S0);
 			set_inports(clockn, State::S1);
 
+			if (num_lanes > 0)
+				set_random_inports();
+
 			update();
 			write_vcd_step(10*cycle + 5);
 
@@ -732,6 +1985,9 @@ struct SimWorker : SimShared
 			else
 				log("Simulating cycle %d.\n", cycle+1);
 
+			if (compiled)
+				compiled->cycle = cycle+1;
+
 			set_inports(clock, State::S1);
 			set_inports(clockn, State::S0);
 
@@ -746,10 +2002,135 @@ struct SimWorker : SimShared
 
 		write_vcd_step(10*numcycles + 2);
 
-		if (writeback) {
-			pool<Module*> wbmods;
-			top->writeback(wbmods);
+		if (num_lanes > 0)
+			compiled->report_lanes();
+
+		if (writeback)
+			do_writeback();
+	}
+
+	// A top-level port (or a part of it) that is recorded in the trace
+	struct trace_port_t
+	{
+		Wire *wire;
+		int offset, width;
+		int signal;
+	};
+
+	// Drives the top-level inputs with the values from a VCD file, and
+	// compares the outputs against the trace after each time step.
+	void replay(Module *topmod, int numsteps)
+	{
+		VcdReader reader(replay_file);
+
+		std::string scope = replay_scope;
+		if (scope.empty()) {
+			std::string topname = log_id(topmod);
+			for (auto &var : reader.vars) {
+				size_t dot = var.scope.rfind('.');
+				std::string last = dot == std::string::npos ? var.scope : var.scope.substr(dot+1);
+				if (last == topname && (scope.empty() || GetSize(var.scope) < GetSize(scope)))
+					scope = var.scope;
+			}
+			if (scope.empty())
+				log_error("Can't find a scope for module %s in `%s', use -scope to select one.\n", topname.c_str(), replay_file.c_str());
+		}
+
+		std::vector<trace_port_t> inputs, outputs;
+		for (auto &var : reader.vars)
+		{
+			if (var.scope != scope)
+				continue;
+
+			std::string name = var.name;
+			if (name[0] == '\\')
+				name = name.substr(1);
+			Wire *wire = topmod->wire(name[0] == '$' ? name : "\\" + name);
+			if (wire == nullptr || (!wire->port_input && !wire->port_output))
+				continue;
+
+			trace_port_t port;
+			port.wire = wire;
+			port.width = var.width;
+			port.offset = 0;
+			port.signal = var.signal;
+
+			// bit 0 of the trace value is the right index of the range
+			if (var.lsb >= 0) {
+				port.offset = var.lsb - wire->start_offset;
+				if (wire->upto)
+					port.offset = GetSize(wire) - 1 - port.offset;
+				if (port.offset < 0)
+					port.width = -1;
+			}
+
+			if (port.width < 0 || port.offset + port.width > GetSize(wire)) {
+				log_warning("Width of %s.%s in `%s' does not match port %s, ignoring it.\n",
+						scope.c_str(), var.name.c_str(), replay_file.c_str(), log_id(wire));
+				continue;
+			}
+
+			reader.watch(port.signal);
+			if (wire->port_input)
+				inputs.push_back(port);
+			else
+				outputs.push_back(port);
+		}
+
+		log("Replaying %d input and comparing %d output signals from scope %s in `%s'.\n",
+				GetSize(inputs), GetSize(outputs), scope.c_str(), replay_file.c_str());
+
+		setup(topmod);
+
+		if (!timescale.empty() || reader.timescale.empty())
+			write_vcd_header();
+		else {
+			timescale = reader.timescale;
+			write_vcd_header();
+		}
+
+		int step = 0, mismatches = 0;
+		int64_t time;
+
+		while ((numsteps < 0 || step < numsteps) && reader.step(time))
+		{
+			if (compiled)
+				compiled->cycle = step;
+
+			for (auto &port : inputs)
+				if (reader.changed(port.signal)) {
+					Const value = get_port(port.wire);
+					for (int i = 0; i < port.width; i++)
+						value.bits[port.offset + i] = reader.value(port.signal)[i];
+					set_port(port.wire, value);
+				}
+
+			update();
+			write_vcd_step(time);
+
+			for (auto &port : outputs)
+			{
+				const Const &expected = reader.value(port.signal);
+				Const actual = get_port(port.wire).extract(port.offset, port.width);
+
+				for (int i = 0; i < port.width; i++)
+					if ((expected[i] == State::S0 || expected[i] == State::S1) && actual[i] != expected[i]) {
+						if (mismatches < 20)
+							log_warning("Output %s differs from the trace at time %lld: expected %s, got %s.\n",
+									log_signal(SigSpec(port.wire, port.offset, port.width)), (long long)time,
+									log_signal(expected), log_signal(actual));
+						mismatches++;
+						break;
+					}
+			}
+
+			step++;
 		}
+
+		log("Replayed %d time steps, found %d output mismatches.\n", step, mismatches);
+
+		if (writeback)
+			do_writeback();
 	}
 };
 
@@ -799,11 +2180,40 @@ struct SimPass : public Pass {
 		log("    -d\n");
 		log("        enable debug output\n");
 		log("\n");
+		log("    -compiled\n");
+		log("        flatten and levelize the netlist once before simulating, and evaluate\n");
+		log("        the cells in topological order on packed net arrays. This is much\n");
+		log("        faster for large designs. Falls back to the default engine for designs\n");
+		log("        with combinational loops and when -d is used.\n");
+		log("\n");
+		log("    -lanes <integer>\n");
+		log("        random stimulus mode: simulate the given number (up to 64) of independent\n");
+		log("        lanes in parallel, using the compiled engine. All top-level inputs\n");
+		log("        except clock and reset get new random values in every cycle, with a\n");
+		log("        different stimulus in each lane. Assertion failures are reported per\n");
+		log("        lane. The VCD file shows lane 0. Writeback is not supported.\n");
+		log("\n");
+		log("    -seed <integer>\n");
+		log("        seed for the random stimulus of -lanes (default: 1)\n");
+		log("\n");
+		log("    -r <filename>\n");
+		log("        replay mode: drive the top-level inputs with the values recorded in the\n");
+		log("        given VCD file, one simulation step per time step in the file, and\n");
+		log("        compare the top-level outputs against the trace after each step.\n");
+		log("        Bits that are undefined in the trace are not compared. The file is\n");
+		log("        read incrementally, so traces larger than the main memory can be\n");
+		log("        replayed. -n limits the number of time steps, the clock and reset\n");
+		log("        options can not be used in this mode.\n");
+		log("\n");
+		log("    -scope <name>\n");
+		log("        hierarchical name of the VCD scope that holds the top-level ports\n");
+		log("        (default: the shortest scope named like the top module)\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
 	{
 		SimWorker worker;
-		int numcycles = 20;
+		int numcycles = -1;
 
 		log_header(design, "Executing SIM pass (simulate the circuit).\n");
 
@@ -857,10 +2267,44 @@ struct SimPass : public Pass {
 				worker.zinit = true;
 				continue;
 			}
+			if (args[argidx] == "-compiled") {
+				worker.use_compiled = true;
+				continue;
+			}
+			if (args[argidx] == "-lanes" && argidx+1 < args.size()) {
+				worker.num_lanes = atoi(args[++argidx].c_str());
+				if (worker.num_lanes < 1 || worker.num_lanes > 64)
+					log_cmd_error("The number of lanes must be between 1 and 64.\n");
+				continue;
+			}
+			if (args[argidx] == "-seed" && argidx+1 < args.size()) {
+				worker.rng_state = uint64_t(atoll(args[++argidx].c_str())) * 0x9e3779b97f4a7c15ull + 1;
+				continue;
+			}
+			if (args[argidx] == "-r" && argidx+1 < args.size()) {
+				worker.replay_file = args[++argidx];
+				continue;
+			}
+			if (args[argidx] == "-scope" && argidx+1 < args.size()) {
+				worker.replay_scope = args[++argidx];
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
 
+		if (worker.num_lanes > 0 && worker.writeback)
+			log_cmd_error("Writeback is not supported with -lanes.\n");
+		if (worker.num_lanes > 0 && worker.debug)
+			log_cmd_error("Debug output is not supported with -lanes.\n");
+		if (worker.rng_state == 0)
+			worker.rng_state = 1;
+		if (!worker.replay_file.empty() && worker.num_lanes > 0)
+			log_cmd_error("Options -r and -lanes can not be combined.\n");
+		if (!worker.replay_file.empty() && (!worker.clock.empty() || !worker.clockn.empty() ||
+				!worker.reset.empty() || !worker.resetn.empty()))
+			log_cmd_error("The clock and reset options can not be used with -r.\n");
+
 		Module *top_mod = nullptr;
 
 		if (design->full_selection()) {
@@ -875,7 +2319,10 @@ struct SimPass : public Pass {
 			top_mod = mods.front();
 		}
 
-		worker.run(top_mod, numcycles);
+		if (!worker.replay_file.empty())
+			worker.replay(top_mod, numcycles);
+		else
+			worker.run(top_mod, numcycles < 0 ? 20 : numcycles);
 	}
 } SimPass;
 
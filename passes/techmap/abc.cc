@@ -47,6 +47,8 @@
 #include "kernel/ffinit.h"
 #include "kernel/cost.h"
 #include "kernel/log.h"
+#include "kernel/threading.h"
+#include "kernel/profile.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -61,6 +63,7 @@
 #endif
 
 #include "frontends/blif/blifparse.h"
+#include "passes/techmap/abc_cache.h"
 
 #ifdef YOSYS_LINK_ABC
 extern "C" int Abc_RealMain(int argc, char *argv[]);
@@ -107,6 +110,7 @@ bool map_mux8;
 bool map_mux16;
 
 bool markgroups;
+std::string cache_dir;
 int map_autoidx;
 SigMap assign_map;
 RTLIL::Module *module;
@@ -120,6 +124,11 @@ bool clk_polarity, en_polarity;
 RTLIL::SigSpec clk_sig, en_sig;
 dict<int, std::string> pi_map, po_map;
 
+// with -threads the extracted cells are only removed once all partitions of a
+// module have been extracted, as if the earlier partitions were already mapped
+bool defer_cell_removal;
+pool<RTLIL::Cell*> extracted_cells;
+
 int map_signal(RTLIL::SigBit bit, gate_type_t gate_type = G(NONE), int in1 = -1, int in2 = -1, int in3 = -1, int in4 = -1)
 {
 	assign_map.apply(bit);
@@ -162,6 +171,14 @@ void mark_port(RTLIL::SigSpec sig)
 			signal_list[signal_map[bit]].is_port = true;
 }
 
+void remove_extracted_cell(RTLIL::Cell *cell)
+{
+	if (defer_cell_removal)
+		extracted_cells.insert(cell);
+	else
+		module->remove(cell);
+}
+
 void extract_cell(RTLIL::Cell *cell, bool keepff)
 {
 	if (cell->type.in(ID($_DFF_N_), ID($_DFF_P_)))
@@ -203,7 +220,7 @@ void extract_cell(RTLIL::Cell *cell, bool keepff)
 
 		map_signal(sig_q, G(FF), map_signal(sig_d));
 
-		module->remove(cell);
+		remove_extracted_cell(cell);
 		return;
 	}
 
@@ -217,7 +234,7 @@ void extract_cell(RTLIL::Cell *cell, bool keepff)
 
 		map_signal(sig_y, cell->type == ID($_BUF_) ? G(BUF) : G(NOT), map_signal(sig_a));
 
-		module->remove(cell);
+		remove_extracted_cell(cell);
 		return;
 	}
 
@@ -253,7 +270,7 @@ void extract_cell(RTLIL::Cell *cell, bool keepff)
 		else
 			log_abort();
 
-		module->remove(cell);
+		remove_extracted_cell(cell);
 		return;
 	}
 
@@ -275,7 +292,7 @@ void extract_cell(RTLIL::Cell *cell, bool keepff)
 
 		map_signal(sig_y, cell->type == ID($_MUX_) ? G(MUX) : G(NMUX), mapped_a, mapped_b, mapped_s);
 
-		module->remove(cell);
+		remove_extracted_cell(cell);
 		return;
 	}
 
@@ -297,7 +314,7 @@ void extract_cell(RTLIL::Cell *cell, bool keepff)
 
 		map_signal(sig_y, cell->type == ID($_AOI3_) ? G(AOI3) : G(OAI3), mapped_a, mapped_b, mapped_c);
 
-		module->remove(cell);
+		remove_extracted_cell(cell);
 		return;
 	}
 
@@ -322,7 +339,7 @@ void extract_cell(RTLIL::Cell *cell, bool keepff)
 
 		map_signal(sig_y, cell->type == ID($_AOI4_) ? G(AOI4) : G(OAI4), mapped_a, mapped_b, mapped_c, mapped_d);
 
-		module->remove(cell);
+		remove_extracted_cell(cell);
 		return;
 	}
 }
@@ -653,16 +670,29 @@ struct abc_output_filter
 	}
 };
 
-void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::string script_file, std::string exe_file,
+// everything abc_module_run() and abc_module_finish() need to know about an
+// ABC run that was set up by abc_module_prepare()
+struct abc_run_t
+{
+	std::string exe_file, script_file, liberty_file, constr_file;
+	std::string tempdir_name, abc_script;
+	bool has_luts, show_tempdir, sop_mode, cleanup;
+	bool needed;
+};
+
+// extract the cells to a netlist and write the files for ABC, leaves the log
+// pushed for abc_module_finish()
+void abc_module_prepare(RTLIL::Design *design, RTLIL::Module *current_module, std::string script_file, std::string exe_file,
 		std::string liberty_file, std::string constr_file, bool cleanup, vector<int> lut_costs, bool dff_mode, std::string clk_str,
 		bool keepff, std::string delay_target, std::string sop_inputs, std::string sop_products, std::string lutin_shared, bool fast_mode,
-		const std::vector<RTLIL::Cell*> &cells, bool show_tempdir, bool sop_mode, bool abc_dress)
+		const std::vector<RTLIL::Cell*> &cells, bool show_tempdir, bool sop_mode, bool abc_dress, abc_run_t &run)
 {
 	module = current_module;
 	map_autoidx = autoidx++;
 
 	signal_map.clear();
 	signal_list.clear();
+	extracted_cells.clear();
 	pi_map.clear();
 	po_map.clear();
 	recover_init = false;
@@ -796,9 +826,12 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 			mark_port(wire);
 	}
 
-	for (auto cell : module->cells())
-	for (auto &port_it : cell->connections())
-		mark_port(port_it.second);
+	for (auto cell : module->cells()) {
+		if (extracted_cells.count(cell))
+			continue;
+		for (auto &port_it : cell->connections())
+			mark_port(port_it.second);
+	}
 
 	if (clk_sig.size() != 0)
 		mark_port(clk_sig);
@@ -989,39 +1022,89 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 			fclose(f);
 		}
 
-		buffer = stringf("%s -s -f %s/abc.script 2>&1", exe_file.c_str(), tempdir_name.c_str());
-		log("Running ABC command: %s\n", replace_tempdir(buffer, tempdir_name, show_tempdir).c_str());
+	}
+
+	run.exe_file = exe_file;
+	run.script_file = script_file;
+	run.liberty_file = liberty_file;
+	run.constr_file = constr_file;
+	run.tempdir_name = tempdir_name;
+	run.abc_script = abc_script;
+	run.has_luts = !lut_costs.empty();
+	run.show_tempdir = show_tempdir;
+	run.sop_mode = sop_mode;
+	run.cleanup = cleanup;
+	run.needed = count_output > 0;
+}
+
+// run ABC on the files written by abc_module_prepare(), only looks at the
+// run itself so that several of these can be executed in parallel
+void abc_module_run(const abc_run_t &run)
+{
+	const std::string &tempdir_name = run.tempdir_name;
+
+	AbcCache cache(cache_dir, tempdir_name);
+	cache.add_exe(run.exe_file);
+	cache.add_file(stringf("%s/input.blif", tempdir_name.c_str()));
+	cache.add_file(stringf("%s/stdcells.genlib", tempdir_name.c_str()));
+	if (run.has_luts)
+		cache.add_file(stringf("%s/lutdefs.txt", tempdir_name.c_str()));
+	cache.add_file(run.liberty_file);
+	cache.add_file(run.constr_file);
+	cache.add_file(run.script_file);
+	cache.add_script(run.abc_script);
+
+	std::string output_name = stringf("%s/output.blif", tempdir_name.c_str());
+	if (cache.fetch(output_name))
+		return;
+
+	std::string buffer = stringf("%s -s -f %s/abc.script 2>&1", run.exe_file.c_str(), tempdir_name.c_str());
+	log("Running ABC command: %s\n", replace_tempdir(buffer, tempdir_name, run.show_tempdir).c_str());
 
 #ifndef YOSYS_LINK_ABC
-		abc_output_filter filt(tempdir_name, show_tempdir);
-		int ret = run_command(buffer, std::bind(&abc_output_filter::next_line, filt, std::placeholders::_1));
+	abc_output_filter filt(tempdir_name, run.show_tempdir);
+	int ret = run_command(buffer, std::bind(&abc_output_filter::next_line, filt, std::placeholders::_1));
 #else
-		// These needs to be mutable, supposedly due to getopt
-		char *abc_argv[5];
-		string tmp_script_name = stringf("%s/abc.script", tempdir_name.c_str());
-		abc_argv[0] = strdup(exe_file.c_str());
-		abc_argv[1] = strdup("-s");
-		abc_argv[2] = strdup("-f");
-		abc_argv[3] = strdup(tmp_script_name.c_str());
-		abc_argv[4] = 0;
-		int ret = Abc_RealMain(4, abc_argv);
-		free(abc_argv[0]);
-		free(abc_argv[1]);
-		free(abc_argv[2]);
-		free(abc_argv[3]);
+	// These needs to be mutable, supposedly due to getopt
+	char *abc_argv[5];
+	string tmp_script_name = stringf("%s/abc.script", tempdir_name.c_str());
+	abc_argv[0] = strdup(run.exe_file.c_str());
+	abc_argv[1] = strdup("-s");
+	abc_argv[2] = strdup("-f");
+	abc_argv[3] = strdup(tmp_script_name.c_str());
+	abc_argv[4] = 0;
+	int ret;
+	{
+		ProfileScope profile("abc", tmp_script_name);
+		ret = Abc_RealMain(4, abc_argv);
+	}
+	free(abc_argv[0]);
+	free(abc_argv[1]);
+	free(abc_argv[2]);
+	free(abc_argv[3]);
 #endif
-		if (ret != 0)
-			log_error("ABC: execution of command \"%s\" failed: return code %d.\n", buffer.c_str(), ret);
+	if (ret != 0)
+		log_error("ABC: execution of command \"%s\" failed: return code %d.\n", buffer.c_str(), ret);
+
+	cache.store(output_name);
+}
+
+// read the ABC results back into the module and pop the log
+void abc_module_finish(RTLIL::Design *design, const abc_run_t &run)
+{
+	const std::string &tempdir_name = run.tempdir_name;
 
-		buffer = stringf("%s/%s", tempdir_name.c_str(), "output.blif");
+	if (run.needed)
+	{
+		std::string buffer = stringf("%s/%s", tempdir_name.c_str(), "output.blif");
 		std::ifstream ifs;
 		ifs.open(buffer);
 		if (ifs.fail())
 			log_error("Can't open ABC output file `%s'.\n", buffer.c_str());
 
-		bool builtin_lib = liberty_file.empty();
+		bool builtin_lib = run.liberty_file.empty();
 		RTLIL::Design *mapped_design = new RTLIL::Design;
-		parse_blif(mapped_design, ifs, builtin_lib ? ID(DFF) : ID(_dff_), false, sop_mode);
+		parse_blif(mapped_design, ifs, builtin_lib ? ID(DFF) : ID(_dff_), false, run.sop_mode);
 
 		ifs.close();
 
@@ -1263,7 +1346,7 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 		log("Don't call ABC as there is nothing to map.\n");
 	}
 
-	if (cleanup)
+	if (run.cleanup)
 	{
 		log("Removing temp directory.\n");
 		remove_directory(tempdir_name);
@@ -1272,6 +1355,48 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 	log_pop();
 }
 
+void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::string script_file, std::string exe_file,
+		std::string liberty_file, std::string constr_file, bool cleanup, vector<int> lut_costs, bool dff_mode, std::string clk_str,
+		bool keepff, std::string delay_target, std::string sop_inputs, std::string sop_products, std::string lutin_shared, bool fast_mode,
+		const std::vector<RTLIL::Cell*> &cells, bool show_tempdir, bool sop_mode, bool abc_dress)
+{
+	abc_run_t run;
+	abc_module_prepare(design, current_module, script_file, exe_file, liberty_file, constr_file, cleanup, lut_costs, dff_mode, clk_str,
+			keepff, delay_target, sop_inputs, sop_products, lutin_shared, fast_mode, cells, show_tempdir, sop_mode, abc_dress, run);
+	if (run.needed)
+		abc_module_run(run);
+	abc_module_finish(design, run);
+}
+
+// a partition that was prepared with abc_module_prepare(), together with the
+// global state that abc_module_finish() needs to re-integrate it
+struct abc_job_t
+{
+	abc_run_t run;
+	RTLIL::Module *module = nullptr;
+	int map_autoidx = 0;
+	std::vector<gate_t> signal_list;
+	dict<int, std::string> pi_map, po_map;
+	bool recover_init = false, clk_polarity = false, en_polarity = false;
+	RTLIL::SigSpec clk_sig, en_sig;
+	pool<RTLIL::Cell*> extracted_cells;
+};
+
+void swap_job_state(abc_job_t &job)
+{
+	std::swap(module, job.module);
+	std::swap(map_autoidx, job.map_autoidx);
+	std::swap(signal_list, job.signal_list);
+	std::swap(pi_map, job.pi_map);
+	std::swap(po_map, job.po_map);
+	std::swap(recover_init, job.recover_init);
+	std::swap(clk_polarity, job.clk_polarity);
+	std::swap(en_polarity, job.en_polarity);
+	std::swap(clk_sig, job.clk_sig);
+	std::swap(en_sig, job.en_sig);
+	std::swap(extracted_cells, job.extracted_cells);
+}
+
 struct AbcPass : public Pass {
 	AbcPass() : Pass("abc", "use ABC for technology mapping") { }
 	void help() override
@@ -1435,6 +1560,20 @@ struct AbcPass : public Pass {
 		log("        print the temp dir name in log. usually this is suppressed so that the\n");
 		log("        command output is identical across runs.\n");
 		log("\n");
+		log("    -cache <dir>\n");
+		log("        keep the results of ABC runs in the specified directory and reuse them\n");
+		log("        when ABC is called again with the same netlist, script, libraries and\n");
+		log("        ABC executable. the log output of ABC is not reproduced for results\n");
+		log("        taken from the cache.\n");
+		log("\n");
+		log("    -threads <N>\n");
+		log("        with N > 1, first extract the netlists of all modules and clock domains,\n");
+		log("        then run up to N ABC processes at the same time, and re-integrate the\n");
+		log("        results in the same order as without this option. the result does\n");
+		log("        not depend on the value of N, but can differ in the details from the\n");
+		log("        result of a run with N = 1. the default is the value of the -j option\n");
+		log("        of yosys.\n");
+		log("\n");
 		log("    -markgroups\n");
 		log("        set a 'abcgroup' attribute on all objects created by ABC. The value of\n");
 		log("        this attribute is a unique integer for each ABC process started. This\n");
@@ -1486,7 +1625,9 @@ struct AbcPass : public Pass {
 		bool show_tempdir = false, sop_mode = false;
 		bool abc_dress = false;
 		vector<int> lut_costs;
+		int threads = yosys_threads;
 		markgroups = false;
+		cache_dir.clear();
 
 		map_mux4 = false;
 		map_mux8 = false;
@@ -1539,6 +1680,8 @@ struct AbcPass : public Pass {
 		keepff = design->scratchpad_get_bool("abc.keepff", keepff);
 		show_tempdir = design->scratchpad_get_bool("abc.showtmp", show_tempdir);
 		markgroups = design->scratchpad_get_bool("abc.markgroups", markgroups);
+		cache_dir = design->scratchpad_get_string("abc.cache", cache_dir);
+		threads = design->scratchpad_get_int("abc.threads", threads);
 
 		if (design->scratchpad_get_bool("abc.debug")) {
 			cleanup = false;
@@ -1651,6 +1794,14 @@ struct AbcPass : public Pass {
 				show_tempdir = true;
 				continue;
 			}
+			if (arg == "-threads" && argidx+1 < args.size()) {
+				threads = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (arg == "-cache" && argidx+1 < args.size()) {
+				cache_dir = args[++argidx];
+				continue;
+			}
 			if (arg == "-markgroups") {
 				markgroups = true;
 				continue;
@@ -1849,6 +2000,23 @@ struct AbcPass : public Pass {
 			// enabled_gates.insert("NMUX");
 		}
 
+		std::vector<abc_job_t> jobs;
+		defer_cell_removal = threads > 1;
+
+		auto map_cells = [&](RTLIL::Module *mod, bool dff_mode, std::string clk_str, const std::vector<RTLIL::Cell*> &cells) {
+			if (!defer_cell_removal) {
+				abc_module(design, mod, script_file, exe_file, liberty_file, constr_file, cleanup, lut_costs, dff_mode, clk_str, keepff,
+						delay_target, sop_inputs, sop_products, lutin_shared, fast_mode, cells, show_tempdir, sop_mode, abc_dress);
+				return;
+			}
+			jobs.emplace_back();
+			abc_job_t &job = jobs.back();
+			abc_module_prepare(design, mod, script_file, exe_file, liberty_file, constr_file, cleanup, lut_costs, dff_mode, clk_str, keepff,
+					delay_target, sop_inputs, sop_products, lutin_shared, fast_mode, cells, show_tempdir, sop_mode, abc_dress, job.run);
+			log_pop();
+			swap_job_state(job);
+		};
+
 		for (auto mod : design->selected_modules())
 		{
 			if (mod->processes.size() > 0) {
@@ -1860,8 +2028,7 @@ struct AbcPass : public Pass {
 			initvals.set(&assign_map, mod);
 
 			if (!dff_mode || !clk_str.empty()) {
-				abc_module(design, mod, script_file, exe_file, liberty_file, constr_file, cleanup, lut_costs, dff_mode, clk_str, keepff,
-						delay_target, sop_inputs, sop_products, lutin_shared, fast_mode, mod->selected_cells(), show_tempdir, sop_mode, abc_dress);
+				map_cells(mod, dff_mode, clk_str, mod->selected_cells());
 				continue;
 			}
 
@@ -2005,12 +2172,35 @@ struct AbcPass : public Pass {
 				clk_sig = assign_map(std::get<1>(it.first));
 				en_polarity = std::get<2>(it.first);
 				en_sig = assign_map(std::get<3>(it.first));
-				abc_module(design, mod, script_file, exe_file, liberty_file, constr_file, cleanup, lut_costs, !clk_sig.empty(), "$",
-						keepff, delay_target, sop_inputs, sop_products, lutin_shared, fast_mode, it.second, show_tempdir, sop_mode, abc_dress);
+				map_cells(mod, !clk_sig.empty(), "$", it.second);
 				assign_map.set(mod);
 			}
 		}
 
+		if (defer_cell_removal)
+		{
+			for (auto &job : jobs)
+				for (auto cell : job.extracted_cells)
+					job.module->remove(cell);
+
+#ifdef YOSYS_LINK_ABC
+			// the linked-in ABC is not reentrant
+			threads = 1;
+#endif
+			parallel_for(GetSize(jobs), threads, [&](int i) {
+				if (jobs[i].run.needed)
+					abc_module_run(jobs[i].run);
+			});
+
+			for (auto &job : jobs) {
+				swap_job_state(job);
+				log_push();
+				abc_module_finish(design, job.run);
+			}
+			defer_cell_removal = false;
+			extracted_cells.clear();
+		}
+
 		assign_map.clear();
 		signal_list.clear();
 		signal_map.clear();
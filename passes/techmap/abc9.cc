@@ -165,6 +165,10 @@ struct Abc9Pass : public ScriptPass
 		log("    -box <file>\n");
 		log("        pass this file with box library to ABC.\n");
 		log("\n");
+		log("    -cache <dir>\n");
+		log("        keep the results of ABC runs in the specified directory and reuse them\n");
+		log("        on later runs with identical inputs. see 'help abc9_exe' for details.\n");
+		log("\n");
 		log("Note that this is a logic optimization pass within Yosys that is calling ABC\n");
 		log("internally. This is not going to \"run ABC on your design\". It will instead run\n");
 		log("ABC on logic snippets extracted from your design. You will not get any useful\n");
@@ -214,7 +218,7 @@ struct Abc9Pass : public ScriptPass
 			std::string arg = args[argidx];
 			if ((arg == "-exe" || arg == "-script" || arg == "-D" ||
 						/*arg == "-S" ||*/ arg == "-lut" || arg == "-luts" ||
-						/*arg == "-box" ||*/ arg == "-W") &&
+						/*arg == "-box" ||*/ arg == "-W" || arg == "-cache") &&
 					argidx+1 < args.size()) {
 				if (arg == "-lut" || arg == "-luts")
 					lut_mode = true;
@@ -24,6 +24,8 @@
 
 #include "kernel/register.h"
 #include "kernel/log.h"
+#include "kernel/profile.h"
+#include "passes/techmap/abc_cache.h"
 
 #ifndef _WIN32
 #  include <unistd.h>
@@ -165,7 +167,7 @@ struct abc9_output_filter
 void abc9_module(RTLIL::Design *design, std::string script_file, std::string exe_file,
 		vector<int> lut_costs, bool dff_mode, std::string delay_target, std::string /*lutin_shared*/, bool fast_mode,
 		bool show_tempdir, std::string box_file, std::string lut_file,
-		std::string wire_delay, std::string tempdir_name
+		std::string wire_delay, std::string tempdir_name, std::string cache_dir
 )
 {
 	std::string abc9_script;
@@ -262,6 +264,20 @@ void abc9_module(RTLIL::Design *design, std::string script_file, std::string exe
 		fclose(f);
 	}
 
+	AbcCache cache(cache_dir, tempdir_name);
+	cache.add_exe(exe_file);
+	cache.add_file(stringf("%s/input.xaig", tempdir_name.c_str()));
+	if (!lut_costs.empty())
+		cache.add_file(stringf("%s/lutdefs.txt", tempdir_name.c_str()));
+	cache.add_file(lut_file);
+	cache.add_file(box_file);
+	cache.add_file(script_file);
+	cache.add_script(abc9_script);
+
+	std::string output_name = stringf("%s/output.aig", tempdir_name.c_str());
+	if (cache.fetch(output_name))
+		return;
+
 	buffer = stringf("%s -s -f %s/abc.script 2>&1", exe_file.c_str(), tempdir_name.c_str());
 	log("Running ABC command: %s\n", replace_tempdir(buffer, tempdir_name, show_tempdir).c_str());
 
@@ -277,18 +293,25 @@ void abc9_module(RTLIL::Design *design, std::string script_file, std::string exe
 	abc9_argv[2] = strdup("-f");
 	abc9_argv[3] = strdup(tmp_script_name.c_str());
 	abc9_argv[4] = 0;
-	int ret = Abc_RealMain(4, abc9_argv);
+	int ret;
+	{
+		ProfileScope profile("abc", tmp_script_name);
+		ret = Abc_RealMain(4, abc9_argv);
+	}
 	free(abc9_argv[0]);
 	free(abc9_argv[1]);
 	free(abc9_argv[2]);
 	free(abc9_argv[3]);
 #endif
 	if (ret != 0) {
-		if (check_file_exists(stringf("%s/output.aig", tempdir_name.c_str())))
+		if (check_file_exists(output_name))
 			log_warning("ABC: execution of command \"%s\" failed: return code %d.\n", buffer.c_str(), ret);
 		else
 			log_error("ABC: execution of command \"%s\" failed: return code %d.\n", buffer.c_str(), ret);
+		return;
 	}
+
+	cache.store(output_name);
 }
 
 struct Abc9ExePass : public Pass {
@@ -360,6 +383,12 @@ struct Abc9ExePass : public Pass {
 		log("    -box <file>\n");
 		log("        pass this file with box library to ABC.\n");
 		log("\n");
+		log("    -cache <dir>\n");
+		log("        keep the results of ABC runs in the specified directory and reuse them\n");
+		log("        when ABC is called again with the same netlist, script, libraries and\n");
+		log("        ABC executable. the log output of ABC is not reproduced for results\n");
+		log("        taken from the cache.\n");
+		log("\n");
 		log("    -cwd <dir>\n");
 		log("        use this as the current working directory, inside which the 'input.xaig'\n");
 		log("        file is expected. temporary files will be created in this directory, and\n");
@@ -386,7 +415,7 @@ struct Abc9ExePass : public Pass {
 #endif
 		std::string script_file, clk_str, box_file, lut_file;
 		std::string delay_target, lutin_shared = "-S 1", wire_delay;
-		std::string tempdir_name;
+		std::string tempdir_name, cache_dir;
 		bool fast_mode = false, dff_mode = false;
 		bool show_tempdir = false;
 		vector<int> lut_costs;
@@ -415,6 +444,7 @@ struct Abc9ExePass : public Pass {
 		dff_mode = design->scratchpad_get_bool("abc9.dff", dff_mode);
 		show_tempdir = design->scratchpad_get_bool("abc9.showtmp", show_tempdir);
 		box_file = design->scratchpad_get_string("abc9.box", box_file);
+		cache_dir = design->scratchpad_get_string("abc9.cache", cache_dir);
 		if (design->scratchpad.count("abc9.W")) {
 			wire_delay = "-W " + design->scratchpad_get_string("abc9.W");
 		}
@@ -475,6 +505,10 @@ struct Abc9ExePass : public Pass {
 				wire_delay = "-W " + args[++argidx];
 				continue;
 			}
+			if (arg == "-cache" && argidx+1 < args.size()) {
+				cache_dir = args[++argidx];
+				continue;
+			}
 			if (arg == "-cwd" && argidx+1 < args.size()) {
 				tempdir_name = args[++argidx];
 				continue;
@@ -542,7 +576,7 @@ struct Abc9ExePass : public Pass {
 
 		abc9_module(design, script_file, exe_file, lut_costs, dff_mode,
 				delay_target, lutin_shared, fast_mode, show_tempdir,
-				box_file, lut_file, wire_delay, tempdir_name);
+				box_file, lut_file, wire_delay, tempdir_name, cache_dir);
 	}
 } Abc9ExePass;
 
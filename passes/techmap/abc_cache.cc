@@ -0,0 +1,179 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "passes/techmap/abc_cache.h"
+#include <sys/stat.h>
+#include <errno.h>
+#include <cstdio>
+
+#ifdef _WIN32
+#  include <direct.h>
+#endif
+
+YOSYS_NAMESPACE_BEGIN
+
+static bool copy_file(const std::string &from, const std::string &to)
+{
+	std::ifstream ifs(from, std::ios::binary);
+	if (ifs.fail())
+		return false;
+	std::ofstream ofs(to, std::ios::binary | std::ios::trunc);
+	if (ofs.fail())
+		return false;
+	ofs << ifs.rdbuf();
+	ofs.close();
+	return !ofs.fail();
+}
+
+static void make_dirs(const std::string &dirname)
+{
+	for (size_t pos = dirname.find_first_of("/\\", 1); ; pos = dirname.find_first_of("/\\", pos+1)) {
+		std::string prefix = dirname.substr(0, pos);
+#ifdef _WIN32
+		_mkdir(prefix.c_str());
+#else
+		mkdir(prefix.c_str(), 0777);
+#endif
+		if (pos == std::string::npos)
+			break;
+	}
+}
+
+AbcCache::AbcCache(const std::string &cache_dir, const std::string &tempdir_name) :
+		cache_dir(cache_dir), tempdir_name(tempdir_name)
+{
+	add_string("yosys", yosys_version_str);
+}
+
+void AbcCache::add_string(const std::string &tag, const std::string &data)
+{
+	hasher.update(stringf("%s %zu\n", tag.c_str(), data.size()));
+	hasher.update(data);
+}
+
+void AbcCache::add_exe(const std::string &exe_file)
+{
+	if (!enabled())
+		return;
+
+#ifdef YOSYS_LINK_ABC
+	add_string("exe", "linked");
+#else
+	// hashing the executable itself would be too expensive for every call,
+	// its size and modification time are a good enough stand-in
+	struct stat st;
+	if (stat(exe_file.c_str(), &st) == 0)
+		add_string("exe", stringf("%s %lld %lld", exe_file.c_str(), (long long)st.st_size, (long long)st.st_mtime));
+	else
+		add_string("exe", exe_file);
+#endif
+}
+
+void AbcCache::add_file(const std::string &filename)
+{
+	if (!enabled() || filename.empty() || filename[0] == '+')
+		return;
+
+	std::ifstream ifs(filename, std::ios::binary);
+	if (ifs.fail()) {
+		add_string("missing", "");
+		return;
+	}
+
+	std::stringstream buf;
+	buf << ifs.rdbuf();
+	add_string("file", buf.str());
+	file_names.push_back(filename);
+}
+
+void AbcCache::add_script(std::string script)
+{
+	if (!enabled())
+		return;
+
+	auto replace_all = [&](const std::string &from, const std::string &to) {
+		for (size_t pos = script.find(from); pos != std::string::npos; pos = script.find(from, pos + GetSize(to)))
+			script = script.substr(0, pos) + to + script.substr(pos + GetSize(from));
+	};
+
+	std::vector<int> order;
+	for (int i = 0; i < GetSize(file_names); i++)
+		order.push_back(i);
+	std::sort(order.begin(), order.end(), [&](int a, int b) { return GetSize(file_names[a]) > GetSize(file_names[b]); });
+
+	for (int i : order)
+		replace_all(file_names[i], stringf("<abc-cache-file-%d>", i));
+	replace_all(tempdir_name, "<abc-temp-dir>");
+
+	add_string("script", script);
+}
+
+std::string AbcCache::entry_name(const std::string &filename)
+{
+	if (key.empty())
+		key = hasher.final();
+
+	std::string basename = filename;
+	size_t pos = basename.find_last_of("/\\");
+	if (pos != std::string::npos)
+		basename = basename.substr(pos+1);
+
+	return stringf("%s/%s/%s-%s", cache_dir.c_str(), key.substr(0, 2).c_str(), key.c_str(), basename.c_str());
+}
+
+bool AbcCache::fetch(const std::string &filename)
+{
+	if (!enabled())
+		return false;
+
+	std::string entry = entry_name(filename);
+	if (!check_file_exists(entry))
+		return false;
+
+	if (!copy_file(entry, filename)) {
+		log_warning("Copying ABC cache entry `%s' failed, running ABC instead.\n", entry.c_str());
+		return false;
+	}
+
+	log("Using cached ABC result %s.\n", key.c_str());
+	return true;
+}
+
+void AbcCache::store(const std::string &filename)
+{
+	if (!enabled())
+		return;
+
+	std::string entry = entry_name(filename);
+	make_dirs(entry.substr(0, entry.find_last_of('/')));
+
+	// write to a private file first and rename it into place, so that concurrent
+	// runs sharing the cache never see a partially written entry
+	std::string tmp_entry = entry + ".tmp-" + sha1(tempdir_name).substr(0, 8);
+	if (!copy_file(filename, tmp_entry) || std::rename(tmp_entry.c_str(), entry.c_str()) != 0) {
+		remove(tmp_entry.c_str());
+		if (!check_file_exists(entry))
+			log_warning("Storing ABC result in cache `%s' failed: %s\n", cache_dir.c_str(), strerror(errno));
+		return;
+	}
+
+	log("Stored ABC result in cache as %s.\n", key.c_str());
+}
+
+YOSYS_NAMESPACE_END
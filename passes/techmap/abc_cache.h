@@ -0,0 +1,61 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef ABC_CACHE_H
+#define ABC_CACHE_H
+
+#include "kernel/yosys.h"
+#include "libs/sha1/sha1.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// On-disk cache for the results of ABC runs. The key is a SHA1 over everything
+// that is handed to the ABC process: the ABC executable, the input netlist, the
+// libraries and constraint files, and the script (with the temp dir name and the
+// names of the registered input files replaced by placeholders, so that the key
+// does not depend on where the files live).
+struct AbcCache
+{
+	std::string cache_dir, tempdir_name;
+	std::vector<std::string> file_names;
+	SHA1 hasher;
+	std::string key;
+
+	AbcCache(const std::string &cache_dir, const std::string &tempdir_name);
+
+	bool enabled() const { return !cache_dir.empty(); }
+
+	void add_exe(const std::string &exe_file);
+	void add_file(const std::string &filename);
+	void add_script(std::string script);
+
+	// look up the cache entry and copy it to 'filename', returns true on a hit
+	bool fetch(const std::string &filename);
+
+	// copy 'filename' into the cache
+	void store(const std::string &filename);
+
+private:
+	void add_string(const std::string &tag, const std::string &data);
+	std::string entry_name(const std::string &filename);
+};
+
+YOSYS_NAMESPACE_END
+
+#endif
@@ -0,0 +1,4 @@
+module top(input [3:0] a, b, input c, output [3:0] y, output z);
+	assign y = c ? a + b : a ^ b;
+	assign z = &a | ^b;
+endmodule
@@ -0,0 +1,13 @@
+set -e
+
+run_abc() {
+	../../yosys -q -l abc_cache.tmp.log -p "read_verilog abc_cache.v; synth -run coarse; techmap; opt -fast; abc $1 -cache abc_cache.tmp; write_rtlil $2"
+	grep -q "$3" abc_cache.tmp.log
+}
+
+rm -rf abc_cache.tmp
+run_abc "-lut 4" abc_cache_1.tmp.il "Stored ABC result in cache"
+run_abc "-lut 4" abc_cache_2.tmp.il "Using cached ABC result"
+run_abc "-lut 5" abc_cache_3.tmp.il "Stored ABC result in cache"
+cmp abc_cache_1.tmp.il abc_cache_2.tmp.il
+rm -rf abc_cache.tmp abc_cache*.tmp.*
@@ -0,0 +1,217 @@
+#include <gtest/gtest.h>
+#include <chrono>
+
+#include "kernel/yosys.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+template<typename K, typename T>
+using chained_dict = dict<K, T, hash_ops<K>, hash_chained>;
+template<typename K, typename T>
+using probed_dict = dict<K, T, hash_ops<K>, hash_probed>;
+
+template<typename A, typename B>
+static void expect_same_order(const A &a, const B &b)
+{
+	ASSERT_EQ(a.size(), b.size());
+	auto it = b.begin();
+	for (auto &entry : a) {
+		EXPECT_EQ(entry, *it);
+		++it;
+	}
+}
+
+TEST(KernelHashlibTest, probedDictMatchesChained)
+{
+	// same operations on both layouts, the entries must stay in the same
+	// order since only the index differs
+	chained_dict<int, int> ref;
+	probed_dict<int, int> dut;
+	uint32_t rng = 123456789;
+	auto next = [&]() { rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5; return rng; };
+
+	for (int round = 0; round < 20; round++) {
+		for (int i = 0; i < 5000; i++) {
+			int key = next() % 3000;
+			switch (next() % 4) {
+			case 0:
+			case 1:
+				ref[key] = i;
+				dut[key] = i;
+				break;
+			case 2:
+				EXPECT_EQ(ref.erase(key), dut.erase(key));
+				break;
+			case 3:
+				EXPECT_EQ(ref.count(key), dut.count(key));
+				if (ref.count(key))
+					EXPECT_EQ(ref.at(key), dut.at(key));
+				break;
+			}
+		}
+		expect_same_order(ref, dut);
+
+		// erase through iterators while iterating, as passes do
+		for (auto it = dut.begin(); it != dut.end();)
+			if (it->second % 3 == 0)
+				it = dut.erase(it);
+			else
+				++it;
+		for (auto it = ref.begin(); it != ref.end();)
+			if (it->second % 3 == 0)
+				it = ref.erase(it);
+			else
+				++it;
+		expect_same_order(ref, dut);
+	}
+
+	probed_dict<int, int> copy = dut;
+	expect_same_order(ref, copy);
+	copy.sort();
+	ref.sort();
+	expect_same_order(ref, copy);
+	for (auto &it : ref)
+		EXPECT_EQ(copy.at(it.first), it.second);
+
+	dut.clear();
+	EXPECT_EQ(dut.count(1), 0);
+	dut[1] = 2;
+	EXPECT_EQ(dut.at(1), 2);
+}
+
+TEST(KernelHashlibTest, probedPoolMatchesChained)
+{
+	pool<std::string, hash_ops<std::string>, hash_chained> ref;
+	pool<std::string, hash_ops<std::string>, hash_probed> dut;
+
+	for (int i = 0; i < 10000; i++) {
+		std::string s = stringf("s%d", (i * 7919) % 4000);
+		if (i % 3 == 2) {
+			EXPECT_EQ(ref.erase(s), dut.erase(s));
+		} else {
+			EXPECT_EQ(ref.insert(s).second, dut.insert(s).second);
+		}
+	}
+	expect_same_order(ref, dut);
+
+	while (!ref.empty())
+		EXPECT_EQ(ref.pop(), dut.pop());
+	EXPECT_TRUE(dut.empty());
+}
+
+template<typename K>
+static int distinct_hashes(const std::vector<K> &keys)
+{
+	pool<int> hashes;
+	for (auto &key : keys)
+		hashes.insert(hash_ops<K>::hash(key));
+	return GetSize(hashes);
+}
+
+TEST(KernelHashlibTest, hashCollisions)
+{
+	// regular keys that DJB2 maps to the same hash
+	std::vector<std::pair<int, int>> pairs;
+	for (int i = 0; i < 256; i++)
+		for (int j = 0; j < 256; j++)
+			pairs.push_back({i, j});
+
+	RTLIL::Design *design = new RTLIL::Design;
+	RTLIL::Module *module = design->addModule("\\m");
+	std::vector<RTLIL::SigBit> bits;
+	for (int i = 0; i < 256; i++) {
+		RTLIL::Wire *wire = module->addWire(stringf("\\bus%d", i), 256);
+		for (int j = 0; j < 256; j++)
+			bits.push_back(SigBit(wire, j));
+	}
+
+	int distinct_pairs = distinct_hashes(pairs);
+	int distinct_bits = distinct_hashes(bits);
+	printf("distinct hashes: %d of %d pairs, %d of %d bits\n", distinct_pairs, GetSize(pairs), distinct_bits, GetSize(bits));
+#ifdef HASHLIB_MIX64
+	EXPECT_GT(distinct_pairs, GetSize(pairs) * 99 / 100);
+	EXPECT_GT(distinct_bits, GetSize(bits) * 99 / 100);
+#endif
+
+	delete design;
+}
+
+// Builds each table and looks up every key 10 times in a random order, half
+// of the lookups miss. Prints the time per operation for both layouts.
+template<typename K, typename C>
+static double bench(const std::vector<K> &keys, const std::vector<K> &misses)
+{
+	std::vector<std::pair<K, bool>> lookups;
+	for (int i = 0; i < GetSize(keys); i++) {
+		lookups.push_back({keys[i], true});
+		lookups.push_back({misses[i], false});
+	}
+	uint32_t rng = 1;
+	for (int i = GetSize(lookups) - 1; i > 0; i--) {
+		rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+		std::swap(lookups[i], lookups[rng % (i + 1)]);
+	}
+
+	auto t0 = std::chrono::steady_clock::now();
+	C table;
+	for (int i = 0; i < GetSize(keys); i++)
+		table[keys[i]] = i;
+	int found = 0;
+	for (int k = 0; k < 10; k++)
+		for (auto &it : lookups)
+			found += table.count(it.first);
+	auto t1 = std::chrono::steady_clock::now();
+	EXPECT_EQ(found, 10 * GetSize(keys));
+	return std::chrono::duration<double, std::nano>(t1 - t0).count() / (21 * GetSize(keys));
+}
+
+template<typename K>
+static void bench_both(const char *name, const std::vector<K> &keys, const std::vector<K> &misses)
+{
+	double chained = bench<K, chained_dict<K, int>>(keys, misses);
+	double probed = bench<K, probed_dict<K, int>>(keys, misses);
+	printf("%-16s %8d keys: chained %6.1f ns/op, probed %6.1f ns/op\n", name, GetSize(keys), chained, probed);
+}
+
+TEST(KernelHashlibTest, benchmark)
+{
+	const int n = 250000;
+	RTLIL::Design *design = new RTLIL::Design;
+	RTLIL::Module *module = design->addModule("\\m");
+
+	std::vector<RTLIL::SigBit> bits, other_bits;
+	for (int i = 0; i < n / 16; i++) {
+		RTLIL::Wire *wire = module->addWire(stringf("\\w%d", i), 32);
+		for (int j = 0; j < 32; j++)
+			(j < 16 ? bits : other_bits).push_back(SigBit(wire, j));
+	}
+
+	std::vector<RTLIL::Cell*> cells, other_cells;
+	for (int i = 0; i < 2 * n; i++) {
+		RTLIL::Cell *cell = module->addCell(stringf("\\c%d", i), ID($and));
+		(i % 2 ? other_cells : cells).push_back(cell);
+	}
+
+	std::vector<RTLIL::IdString> ids, other_ids;
+	for (int i = 0; i < n; i++) {
+		ids.push_back(stringf("\\id%d", i));
+		other_ids.push_back(stringf("\\other%d", i));
+	}
+
+	for (int size : {1000, n}) {
+		auto head = [&](const std::vector<RTLIL::SigBit> &v) { return std::vector<RTLIL::SigBit>(v.begin(), v.begin() + size); };
+		bench_both("dict<SigBit>", head(bits), head(other_bits));
+	}
+	for (int size : {1000, n}) {
+		auto head = [&](const std::vector<RTLIL::Cell*> &v) { return std::vector<RTLIL::Cell*>(v.begin(), v.begin() + size); };
+		bench_both("dict<Cell*>", head(cells), head(other_cells));
+	}
+	for (int size : {1000, n}) {
+		auto head = [&](const std::vector<RTLIL::IdString> &v) { return std::vector<RTLIL::IdString>(v.begin(), v.begin() + size); };
+		bench_both("dict<IdString>", head(ids), head(other_ids));
+	}
+
+	delete design;
+}
+
+YOSYS_NAMESPACE_END
@@ -1,4 +1,8 @@
 #include <gtest/gtest.h>
+#include <chrono>
+#ifdef __GLIBC__
+#  include <malloc.h>
+#endif
 
 #include "kernel/yosys.h"
 #include "kernel/rtlil.h"
@@ -11,4 +15,423 @@ TEST(KernelRtlilTest, getReferenceValid)
 	EXPECT_EQ(33, 33);
 }
 
+TEST(KernelRtlilTest, packedConstRoundTrip)
+{
+	std::string str;
+	for (int i = 0; i < 150; i++)
+		str += "01xz"[(i * 7 + i / 3) % 4];
+
+	RTLIL::Const c = RTLIL::Const::from_string(str);
+	RTLIL::PackedConst p(c);
+	EXPECT_EQ(p.width, 150);
+	EXPECT_EQ(p.words(), 3);
+	EXPECT_FALSE(p.is_fully_def());
+	EXPECT_EQ(p.as_const(), c);
+
+	RTLIL::PackedConst q(RTLIL::Const(0x5a5a, 100), 130, true);
+	EXPECT_TRUE(q.is_fully_def());
+	EXPECT_EQ(q.as_const(), RTLIL::Const(0x5a5a, 130));
+	EXPECT_EQ(RTLIL::PackedConst(RTLIL::Const::from_string("1x0"), 6, true).as_const().as_string(), "1111x0");
+}
+
+TEST(KernelRtlilTest, packedConstLogic)
+{
+	RTLIL::Const a = RTLIL::Const::from_string("00001111xxxxzzzz");
+	RTLIL::Const b = RTLIL::Const::from_string("01xz01xz01xz01xz");
+	EXPECT_EQ(RTLIL::const_and(a, b, false, false, -1).as_string(), "000001xx0xxx0xxx");
+	EXPECT_EQ(RTLIL::const_or(a, b, false, false, -1).as_string(), "01xx1111x1xxx1xx");
+	EXPECT_EQ(RTLIL::const_xor(a, b, false, false, -1).as_string(), "01xx10xxxxxxxxxx");
+	EXPECT_EQ(RTLIL::const_xnor(a, b, false, false, -1).as_string(), "10xx01xxxxxxxxxx");
+	EXPECT_EQ(RTLIL::const_not(b, RTLIL::Const(), false, false, -1).as_string(), "10xx10xx10xx10xx");
+
+	EXPECT_EQ(RTLIL::const_reduce_and(RTLIL::Const::from_string("11x1"), RTLIL::Const(), false, false, 1).as_string(), "x");
+	EXPECT_EQ(RTLIL::const_reduce_and(RTLIL::Const::from_string("10x1"), RTLIL::Const(), false, false, 1).as_string(), "0");
+	EXPECT_EQ(RTLIL::const_reduce_or(RTLIL::Const::from_string("0z00"), RTLIL::Const(), false, false, 2).as_string(), "0x");
+	EXPECT_EQ(RTLIL::const_reduce_xor(RTLIL::Const(7, 70), RTLIL::Const(), false, false, 1).as_string(), "1");
+	EXPECT_EQ(RTLIL::const_logic_not(RTLIL::Const(0, 70), RTLIL::Const(), false, false, 1).as_string(), "1");
+
+	EXPECT_EQ(RTLIL::const_eq(RTLIL::Const::from_string("1x"), RTLIL::Const::from_string("0x"), false, false, 1).as_string(), "0");
+	EXPECT_EQ(RTLIL::const_eq(RTLIL::Const::from_string("1x"), RTLIL::Const::from_string("10"), false, false, 1).as_string(), "x");
+	EXPECT_EQ(RTLIL::const_ne(RTLIL::Const(-1, 100), RTLIL::Const(-1, 99), true, true, 1).as_string(), "0");
+}
+
+TEST(KernelRtlilTest, constArithmetic)
+{
+	EXPECT_EQ(RTLIL::const_add(RTLIL::Const(200, 8), RTLIL::Const(100, 8), false, false, 8).as_int(), 44);
+	EXPECT_EQ(RTLIL::const_sub(RTLIL::Const(5, 4), RTLIL::Const(7, 4), true, true, 8).as_int(true), -2);
+	EXPECT_EQ(RTLIL::const_mul(RTLIL::Const(-3, 8), RTLIL::Const(7, 8), true, true, 16).as_int(true), -21);
+	EXPECT_EQ(RTLIL::const_div(RTLIL::Const(-7, 8), RTLIL::Const(2, 8), true, true, 8).as_int(true), -3);
+	EXPECT_EQ(RTLIL::const_divfloor(RTLIL::Const(-7, 8), RTLIL::Const(2, 8), true, true, 8).as_int(true), -4);
+	EXPECT_EQ(RTLIL::const_mod(RTLIL::Const(-7, 8), RTLIL::Const(2, 8), true, true, 8).as_int(true), -1);
+	EXPECT_EQ(RTLIL::const_modfloor(RTLIL::Const(-7, 8), RTLIL::Const(2, 8), true, true, 8).as_int(true), 1);
+	EXPECT_EQ(RTLIL::const_pow(RTLIL::Const(3, 8), RTLIL::Const(5, 8), false, false, 8).as_int(), 243);
+	EXPECT_EQ(RTLIL::const_shl(RTLIL::Const(5, 8), RTLIL::Const(2, 8), false, false, 8).as_int(), 20);
+	EXPECT_EQ(RTLIL::const_sshr(RTLIL::Const(-8, 8), RTLIL::Const(2, 8), true, false, 8).as_int(true), -2);
+	EXPECT_EQ(RTLIL::const_lt(RTLIL::Const(-1, 8), RTLIL::Const(1, 8), true, true, 1).as_string(), "1");
+	EXPECT_EQ(RTLIL::const_lt(RTLIL::Const(-1, 8), RTLIL::Const(1, 8), false, false, 1).as_string(), "0");
+
+	// wide operands go through the multi-word code path
+	RTLIL::Const ones(RTLIL::State::S1, 130);
+	EXPECT_EQ(RTLIL::const_add(ones, RTLIL::Const(1, 2), false, false, 131), RTLIL::const_shl(RTLIL::Const(1, 1), RTLIL::Const(130, 8), false, false, 131));
+	EXPECT_EQ(RTLIL::const_mul(ones, ones, true, true, 130), RTLIL::Const(1, 130));
+	EXPECT_EQ(RTLIL::const_sub(RTLIL::Const(0, 100), RTLIL::Const(1, 1), false, false, 100), RTLIL::Const(RTLIL::State::S1, 100));
+	EXPECT_EQ(RTLIL::const_ge(ones, RTLIL::Const(0, 1), true, false, 1).as_string(), "0");
+
+	// undefined bits still make the whole result undefined
+	EXPECT_EQ(RTLIL::const_add(RTLIL::Const::from_string("1x"), RTLIL::Const(1, 2), false, false, 2).as_string(), "xx");
+	EXPECT_EQ(RTLIL::const_lt(RTLIL::Const::from_string("z0"), RTLIL::Const(1, 2), false, false, 1).as_string(), "x");
+}
+
+TEST(KernelRtlilTest, idStringInterning)
+{
+	RTLIL::IdString a("\\id_test_a"), b = a;
+	EXPECT_EQ(a, b);
+	EXPECT_EQ(a.index_, RTLIL::IdString("\\id_test_a").index_);
+	EXPECT_NE(a, RTLIL::IdString("\\id_test_b"));
+	EXPECT_EQ(a.str(), "\\id_test_a");
+	EXPECT_STREQ(RTLIL::IdString().c_str(), "");
+
+	// a released name gets a fresh slot and is still found by name afterwards
+	std::string name = "\\id_test_released";
+	RTLIL::IdString *c = new RTLIL::IdString(name);
+	delete c;
+	RTLIL::IdString d(name);
+	EXPECT_EQ(d.str(), name);
+	EXPECT_EQ(d.index_, RTLIL::IdString(name).index_);
+}
+
+#ifdef YOSYS_ENABLE_THREADS
+TEST(KernelRtlilTest, idStringInterningThreads)
+{
+	const int num_threads = 8, num_names = 2048;
+	std::vector<std::vector<RTLIL::IdString>> ids(num_threads);
+	std::vector<std::thread> threads;
+
+	for (int t = 0; t < num_threads; t++)
+		threads.emplace_back([t, &ids]() {
+			for (int round = 0; round < 4; round++)
+				for (int i = 0; i < num_names; i++) {
+					// the names are created and released again in a different order
+					// by each thread, only the last round is kept
+					RTLIL::IdString id(stringf("\\mt_%d", (i * (2*t + 1)) % num_names));
+					RTLIL::IdString copy = id;
+					if (round == 3)
+						ids[t].push_back(copy);
+				}
+			std::sort(ids[t].begin(), ids[t].end(), RTLIL::sort_by_id_str());
+		});
+	for (auto &th : threads)
+		th.join();
+
+	for (int t = 0; t < num_threads; t++) {
+		ASSERT_EQ(GetSize(ids[t]), num_names);
+		for (int i = 0; i < num_names; i++) {
+			EXPECT_EQ(ids[t][i].index_, ids[0][i].index_);
+			EXPECT_EQ(ids[t][i], RTLIL::IdString(ids[0][i].str()));
+		}
+	}
+}
+#endif
+
+TEST(KernelRtlilTest, idStringBenchmark)
+{
+	// single-threaded cost of interning, copying and lookup; compare builds
+	// with ENABLE_THREADS=1 and ENABLE_THREADS=0 to see the locking overhead
+	const int n = 200000;
+	std::vector<std::string> names;
+	for (int i = 0; i < n; i++)
+		names.push_back(stringf("\\bench_%d", i));
+
+	auto t0 = std::chrono::steady_clock::now();
+	std::vector<RTLIL::IdString> ids;
+	for (auto &name : names)
+		ids.push_back(RTLIL::IdString(name));
+	auto t1 = std::chrono::steady_clock::now();
+	int found = 0;
+	for (auto &name : names)
+		found += RTLIL::IdString(name).index_ != 0;
+	auto t2 = std::chrono::steady_clock::now();
+	std::vector<RTLIL::IdString> copies;
+	for (int k = 0; k < 10; k++)
+		copies = ids;
+	auto t3 = std::chrono::steady_clock::now();
+	ids.clear();
+	copies.clear();
+	auto t4 = std::chrono::steady_clock::now();
+
+	auto ns = [](std::chrono::steady_clock::duration d, int ops) {
+		return std::chrono::duration<double, std::nano>(d).count() / ops;
+	};
+	printf("IdString: create %.1f ns, lookup %.1f ns, copy %.1f ns, release %.1f ns\n",
+			ns(t1-t0, n), ns(t2-t1, n), ns(t3-t2, 10*n), ns(t4-t3, n));
+	EXPECT_EQ(found, n);
+}
+
+TEST(KernelRtlilTest, sigSpecCopyOnWrite)
+{
+	RTLIL::Design *design = new RTLIL::Design;
+	RTLIL::Module *module = design->addModule("\\top");
+	RTLIL::Wire *a = module->addWire("\\a", 8);
+	RTLIL::Wire *b = module->addWire("\\b", 4);
+
+	RTLIL::SigSpec sig = {RTLIL::SigSpec(b), RTLIL::SigSpec(a)};
+	RTLIL::SigSpec copy = sig;
+	EXPECT_EQ(copy, sig);
+
+	// modifying either copy leaves the other one alone
+	copy[0] = RTLIL::State::S1;
+	EXPECT_EQ(sig[0], RTLIL::SigBit(a, 0));
+	EXPECT_EQ(copy[0], RTLIL::SigBit(RTLIL::State::S1));
+
+	copy = sig;
+	sig.append(RTLIL::State::S0);
+	sig.reverse();
+	EXPECT_EQ(GetSize(copy), 12);
+	EXPECT_EQ(copy.chunks().size(), 2u);
+	EXPECT_EQ(GetSize(sig), 13);
+	EXPECT_EQ(sig[0], RTLIL::SigBit(RTLIL::State::S0));
+
+	// the const replace/remove variants write to a shared other
+	copy = sig;
+	RTLIL::SigSpec other = sig;
+	sig.replace(RTLIL::SigSpec(b), RTLIL::SigSpec(RTLIL::State::Sx, 4), &other);
+	EXPECT_EQ(copy, sig);
+	EXPECT_EQ(GetSize(other.extract(RTLIL::SigSpec(b))), 0);
+	other.remove_const();
+	RTLIL::SigSpec a_rev = a;
+	a_rev.reverse();
+	EXPECT_EQ(other, a_rev);
+	EXPECT_EQ(GetSize(copy), 13);
+
+	// packing or unpacking a shared spec does not invalidate references held
+	// through the other copies
+	copy = sig;
+	const std::vector<RTLIL::SigBit> &bits = copy.bits();
+	sig.chunks();
+	EXPECT_EQ(GetSize(bits), 13);
+	EXPECT_EQ(sig, copy);
+
+	// iterating over a non-const spec may modify it
+	for (auto &bit : sig)
+		if (bit.wire == a)
+			bit = RTLIL::State::S1;
+	EXPECT_EQ(sig.extract(5, 8), RTLIL::SigSpec(RTLIL::State::S1, 8));
+	EXPECT_EQ(copy.extract(5, 8), a_rev);
+
+	RTLIL::SigSpec moved = std::move(copy);
+	EXPECT_EQ(GetSize(copy), 0);
+	EXPECT_EQ(GetSize(moved), 13);
+	copy.append(RTLIL::SigBit(b, 3));
+	EXPECT_EQ(copy, RTLIL::SigSpec(b, 3));
+
+	delete design;
+}
+
+TEST(KernelRtlilTest, sigSpecCloneInto)
+{
+	RTLIL::Design *design = new RTLIL::Design;
+	RTLIL::Module *module = design->addModule("\\top");
+	RTLIL::Wire *a = module->addWire("\\a", 4);
+	RTLIL::Wire *y = module->addWire("\\y", 4);
+	RTLIL::Cell *inv = module->addCell("\\inv", ID($not));
+	inv->setPort("\\A", a);
+	inv->setPort("\\Y", y);
+	module->connect(RTLIL::SigSpec(y, 2, 2), RTLIL::SigSpec(a, 0, 2));
+
+	// the clone starts out sharing the connections of the original, rewriting
+	// them to the new wires must not change the original module
+	RTLIL::Module *clone = module->clone();
+	clone->name = "\\clone";
+	design->add(clone);
+
+	EXPECT_EQ(inv->getPort("\\A").as_wire(), a);
+	EXPECT_EQ(inv->getPort("\\Y").as_wire(), y);
+	EXPECT_EQ(module->connections().at(0).first.as_chunk().wire, y);
+	EXPECT_EQ(clone->cell("\\inv")->getPort("\\A").as_wire(), clone->wire("\\a"));
+	EXPECT_EQ(clone->connections().at(0).second.as_chunk().wire, clone->wire("\\a"));
+
+	module->remove(pool<RTLIL::Wire*>{a});
+	EXPECT_EQ(clone->connections().at(0).second.as_chunk().wire, clone->wire("\\a"));
+	EXPECT_EQ(clone->cell("\\inv")->getPort("\\A").as_wire(), clone->wire("\\a"));
+
+	delete design;
+}
+
+TEST(KernelRtlilTest, sigSpecBenchmark)
+{
+	// copies of a SigSpec share their chunks until one of them is modified
+	const int n = 200000;
+	RTLIL::Design *design = new RTLIL::Design;
+	RTLIL::Module *module = design->addModule("\\bench");
+	std::vector<RTLIL::SigSpec> sigs;
+	for (int i = 0; i < 64; i++) {
+		RTLIL::SigSpec sig;
+		for (int j = 0; j < 8; j++)
+			sig.append(module->addWire(NEW_ID, 4));
+		sigs.push_back(sig);
+	}
+
+	auto t0 = std::chrono::steady_clock::now();
+	std::vector<RTLIL::SigSpec> copies;
+	copies.reserve(n);
+	for (int i = 0; i < n; i++)
+		copies.push_back(sigs[i % 64]);
+	auto t1 = std::chrono::steady_clock::now();
+	int width = 0;
+	for (int i = 0; i < n; i += 4) {
+		copies[i].append(RTLIL::State::S0);
+		width += GetSize(copies[i]);
+	}
+	auto t2 = std::chrono::steady_clock::now();
+	copies.clear();
+	auto t3 = std::chrono::steady_clock::now();
+
+	auto ns = [](std::chrono::steady_clock::duration d, int ops) {
+		return std::chrono::duration<double, std::nano>(d).count() / ops;
+	};
+	printf("SigSpec: copy %.1f ns, modify copy %.1f ns, release %.1f ns\n",
+			ns(t1-t0, n), ns(t2-t1, n/4), ns(t3-t2, n));
+	EXPECT_EQ(width, 33 * n / 4);
+	delete design;
+}
+
+TEST(KernelRtlilTest, designShareModules)
+{
+	RTLIL::Design *design = new RTLIL::Design;
+	RTLIL::Module *top = design->addModule("\\top");
+	RTLIL::Module *sub = design->addModule("\\sub");
+	top->addWire("\\a", 4);
+	sub->addWire("\\b", 2);
+
+	RTLIL::Design *saved = new RTLIL::Design;
+	for (auto &it : design->modules_)
+		saved->share(it.second);
+	EXPECT_EQ(saved->modules_.at("\\top"), top);
+	EXPECT_EQ(saved->modules_.at("\\sub"), sub);
+
+	{
+		RTLIL::Design::ReadOnlyScope readonly(design);
+		EXPECT_EQ(GetSize(design->modules()), 2);
+		EXPECT_EQ(saved->modules_.at("\\top"), top);
+	}
+
+	// looking up a module keeps it for the design and gives the saved
+	// design a copy, other modules stay shared
+	EXPECT_EQ(design->module("\\top"), top);
+	RTLIL::Module *saved_top = saved->modules_.at("\\top");
+	EXPECT_NE(saved_top, top);
+	EXPECT_EQ(saved_top->design, saved);
+	EXPECT_EQ(saved->modules_.at("\\sub"), sub);
+
+	top->addWire("\\c", 1);
+	EXPECT_EQ(GetSize(top->wires_), 2);
+	EXPECT_EQ(GetSize(saved_top->wires_), 1);
+	EXPECT_EQ(saved->module("\\top")->wire("\\c"), nullptr);
+
+	// removing a shared module passes it on to the other design
+	design->remove(sub);
+	EXPECT_EQ(saved->modules_.at("\\sub"), sub);
+	EXPECT_EQ(sub->design, saved);
+	EXPECT_TRUE(sub->shared_designs_.empty());
+
+	// loading the saved design back shares the modules again
+	RTLIL::Design *loaded = new RTLIL::Design;
+	for (auto &it : saved->modules_)
+		loaded->share(it.second);
+	delete saved;
+	EXPECT_EQ(loaded->module("\\sub"), sub);
+	EXPECT_EQ(sub->design, loaded);
+	EXPECT_EQ(loaded->module("\\top"), saved_top);
+	EXPECT_TRUE(saved_top->shared_designs_.empty());
+
+	delete loaded;
+	delete design;
+}
+
+TEST(KernelRtlilTest, moduleArena)
+{
+	RTLIL::Design *design = new RTLIL::Design;
+	RTLIL::Module *module = design->addModule("\\top");
+
+	std::vector<RTLIL::Wire*> wires;
+	std::vector<RTLIL::Cell*> cells;
+	for (int i = 0; i < 1000; i++) {
+		wires.push_back(module->addWire(stringf("\\w%d", i), 2));
+		cells.push_back(module->addCell(stringf("\\c%d", i), ID($not)));
+		cells.back()->setPort("\\A", wires.back());
+	}
+	EXPECT_EQ(module->wire_arena_stats().live, 1000u);
+	EXPECT_EQ(module->cell_arena_stats().live, 1000u);
+	size_t capacity = module->cell_arena_stats().capacity;
+
+	for (int i = 0; i < 1000; i += 2)
+		module->remove(cells[i]);
+	EXPECT_EQ(module->cell_arena_stats().live, 500u);
+	EXPECT_EQ(module->cell("\\c1"), cells[1]);
+	EXPECT_EQ(cells[1]->getPort("\\A").as_wire(), wires[1]);
+
+	// freed slots are reused before the arena grows again
+	for (int i = 0; i < 500; i++)
+		module->addCell(stringf("\\d%d", i), ID($not));
+	EXPECT_EQ(module->cell_arena_stats().live, 1000u);
+	EXPECT_EQ(module->cell_arena_stats().capacity, capacity);
+#ifdef YOSYS_ENABLE_ARENA
+	EXPECT_LT(module->cell_arena_stats().slabs, 10u);
+#endif
+
+	// removing wires that are still in use creates replacement wires
+	module->remove(pool<RTLIL::Wire*>(wires.begin(), wires.begin() + 10));
+	EXPECT_EQ(GetSize(module->wires()), 995);
+	EXPECT_EQ(module->wire_arena_stats().live, 995u);
+
+	delete design;
+}
+
+TEST(KernelRtlilTest, moduleArenaBenchmark)
+{
+	// creating and removing cells and wires in random order, like techmap
+	// and opt passes do; compare builds with ENABLE_ARENA=1 and ENABLE_ARENA=0
+	const int n = 100000, rounds = 4;
+	RTLIL::Design *design = new RTLIL::Design;
+	RTLIL::Module *module = design->addModule("\\bench");
+	std::vector<RTLIL::Cell*> cells;
+	uint32_t rng = 1;
+
+	auto t0 = std::chrono::steady_clock::now();
+	for (int round = 0; round < rounds; round++) {
+		while (GetSize(cells) < n) {
+			RTLIL::Wire *w = module->addWire(NEW_ID, 4);
+			RTLIL::Cell *cell = module->addCell(NEW_ID, ID($not));
+			cell->setPort("\\A", w);
+			cell->setPort("\\Y", module->addWire(NEW_ID, 4));
+			cells.push_back(cell);
+		}
+		pool<RTLIL::Wire*> wires;
+		for (int i = 0; i < n / 2; i++) {
+			rng ^= rng << 13, rng ^= rng >> 17, rng ^= rng << 5;
+			std::swap(cells[rng % GetSize(cells)], cells.back());
+			RTLIL::Cell *cell = cells.back();
+			cells.pop_back();
+			wires.insert(cell->getPort("\\A").as_wire());
+			wires.insert(cell->getPort("\\Y").as_wire());
+			module->remove(cell);
+		}
+		module->remove(wires);
+	}
+	auto t1 = std::chrono::steady_clock::now();
+
+	ArenaStats stats = module->wire_arena_stats();
+	stats += module->cell_arena_stats();
+	printf("Module arena: %.1f ns per cell, %zu slabs, %zu of %zu slots live (%.0f%% unused), %.1f MB\n",
+			std::chrono::duration<double, std::nano>(t1-t0).count() / (rounds * n),
+			stats.slabs, stats.live, stats.capacity, 100 * stats.fragmentation(), stats.bytes / 1e6);
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+	struct mallinfo2 mi = mallinfo2();
+	printf("Heap: %.1f MB in use, %.1f MB free in %zu fragments\n", mi.uordblks / 1e6, mi.fordblks / 1e6, mi.ordblks);
+#endif
+
+	delete design;
+	EXPECT_EQ(stats.live, size_t(3 * GetSize(cells)));
+}
+
 YOSYS_NAMESPACE_END
@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+
+#include "kernel/yosys.h"
+#include "kernel/satgen.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+TEST(KernelSatgenTest, importedLiterals)
+{
+	RTLIL::Design *design = new RTLIL::Design;
+	RTLIL::Module *module = design->addModule("\\m");
+	RTLIL::Wire *a = module->addWire("\\a", 4);
+	RTLIL::Wire *b = module->addWire("\\b", 4);
+	module->connect(b, a);
+
+	SigMap sigmap(module);
+	ezMiniSAT ez;
+	SatGen satgen(&ez, &sigmap);
+	satgen.model_undef = true;
+
+	// the same bit gets the same literal, also through the sigmap
+	std::vector<int> lits = satgen.importSigSpec(a);
+	EXPECT_EQ(satgen.importSigSpec(b), lits);
+	EXPECT_EQ(satgen.importSigBit(SigBit(b, 2)), lits[2]);
+	EXPECT_TRUE(satgen.importedSigBit(sigmap(SigBit(b, 2))));
+	EXPECT_FALSE(satgen.importedSigBit(sigmap(SigBit(b, 2)), 1));
+
+	// timesteps, undef bits and prefixes get their own literals
+	std::vector<int> step1 = satgen.importSigSpec(a, 1);
+	std::vector<int> step2 = satgen.importSigSpec(a, 2);
+	std::vector<int> undef1 = satgen.importUndefSigSpec(a, 1);
+	EXPECT_NE(step1, lits);
+	EXPECT_NE(step1, step2);
+	EXPECT_NE(step1, undef1);
+	EXPECT_EQ(satgen.importDefSigSpec(a, 1), step1);
+	EXPECT_TRUE(satgen.importedSigBit(sigmap(SigBit(a, 0)), 1));
+
+	satgen.setContext(&sigmap, "B");
+	std::vector<int> other = satgen.importSigSpec(a, 1);
+	EXPECT_NE(other, step1);
+	satgen.setContext(&sigmap);
+	EXPECT_EQ(satgen.importSigSpec(a, 1), step1);
+
+	// constants do not allocate literals
+	std::vector<int> consts = satgen.importSigSpec(RTLIL::Const(2, 2));
+	EXPECT_EQ(consts[0], ez.CONST_FALSE);
+	EXPECT_EQ(consts[1], ez.CONST_TRUE);
+
+	delete design;
+}
+
+TEST(KernelSatgenTest, namedLiterals)
+{
+	RTLIL::Design *design = new RTLIL::Design;
+	RTLIL::Module *module = design->addModule("\\m");
+	RTLIL::Wire *a = module->addWire("\\a", 4);
+	RTLIL::Wire *c = module->addWire("\\c");
+
+	SigMap sigmap(module);
+	ezMiniSAT ez;
+	SatGen satgen(&ez, &sigmap, "X");
+	satgen.named_literals = true;
+	satgen.model_undef = true;
+
+	EXPECT_EQ(ez.lookup_literal(satgen.importSigBit(SigBit(a, 3), 5)), "X@5:a [3]");
+	EXPECT_EQ(ez.lookup_literal(satgen.importSigBit(c)), "Xc");
+	EXPECT_EQ(ez.lookup_literal(satgen.importUndefSigBit(c, 2)), "undef:X@2:c");
+
+	// without names the literals are anonymous
+	satgen.named_literals = false;
+	EXPECT_EQ(ez.lookup_literal(satgen.importSigBit(SigBit(a, 0), 5)), "");
+
+	delete design;
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include <chrono>
+
+#include "kernel/yosys.h"
+#include "kernel/sigtools.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// module->sigmap() must map every bit like a SigMap built from scratch
+static void expect_same_sigmap(RTLIL::Module *module)
+{
+	SigMap fresh(module);
+	const SigMap &live = module->sigmap();
+	for (auto wire : module->wires())
+		for (int i = 0; i < GetSize(wire); i++)
+			EXPECT_EQ(live(SigBit(wire, i)), fresh(SigBit(wire, i))) << log_id(wire) << "[" << i << "]";
+}
+
+TEST(KernelSigtoolsTest, moduleSigMapIncremental)
+{
+	RTLIL::Design *design = new RTLIL::Design;
+	RTLIL::Module *module = design->addModule("\\m");
+	RTLIL::Wire *a = module->addWire("\\a", 4);
+	RTLIL::Wire *b = module->addWire("\\b", 4);
+	RTLIL::Wire *c = module->addWire("\\c", 4);
+	RTLIL::Wire *d = module->addWire("\\d", 4);
+
+	expect_same_sigmap(module);
+
+	module->connect(a, b);
+	module->connect(SigSpec(c).extract(0, 2), SigSpec(b).extract(2, 2));
+	expect_same_sigmap(module);
+	EXPECT_EQ(module->sigmap()(SigBit(a, 3)), module->sigmap()(SigBit(c, 1)));
+
+	// bits with a constant left hand side are dropped by connect()
+	module->connect(SigSpec({State::S0, SigBit(d, 0)}), SigSpec({SigBit(c, 3), State::S1}));
+	expect_same_sigmap(module);
+	EXPECT_EQ(module->sigmap()(SigBit(d, 0)), SigBit(State::S1));
+	EXPECT_EQ(module->sigmap()(SigBit(c, 3)), SigBit(c, 3));
+
+	// replacing the connections splits nets again
+	std::vector<RTLIL::SigSig> conns = module->connections();
+	conns.erase(conns.begin());
+	module->new_connections(conns);
+	expect_same_sigmap(module);
+	EXPECT_NE(module->sigmap()(SigBit(a, 0)), module->sigmap()(SigBit(b, 0)));
+
+	module->connect(d, a);
+	module->remove(pool<RTLIL::Wire*>{b});
+	expect_same_sigmap(module);
+
+	module->makeblackbox();
+	expect_same_sigmap(module);
+
+	delete design;
+}
+
+TEST(KernelSigtoolsTest, moduleSigMapBenchmark)
+{
+	// cost of rebuilding a SigMap for each pass against fetching the
+	// incrementally maintained one
+	const int n = 100000, passes = 20;
+	RTLIL::Design *design = new RTLIL::Design;
+	RTLIL::Module *module = design->addModule("\\m");
+	std::vector<RTLIL::Wire*> wires;
+	for (int i = 0; i < n; i++)
+		wires.push_back(module->addWire(stringf("\\w%d", i), 8));
+	for (int i = 1; i < n; i++)
+		module->connect(wires[i], wires[(i * 7919) % i]);
+
+	auto t0 = std::chrono::steady_clock::now();
+	int found = 0;
+	for (int k = 0; k < passes; k++) {
+		SigMap sigmap(module);
+		found += sigmap(SigBit(wires[n-1], 0)).wire != nullptr;
+	}
+	auto t1 = std::chrono::steady_clock::now();
+	for (int k = 0; k < passes; k++) {
+		const SigMap &sigmap = module->sigmap();
+		found += sigmap(SigBit(wires[n-1], 0)).wire != nullptr;
+	}
+	auto t2 = std::chrono::steady_clock::now();
+
+	auto ms = [](std::chrono::steady_clock::duration d) {
+		return std::chrono::duration<double, std::milli>(d).count() / passes;
+	};
+	printf("SigMap: rebuild %.2f ms, module sigmap %.3f ms per pass\n", ms(t1-t0), ms(t2-t1));
+	EXPECT_EQ(found, 2*passes);
+
+	delete design;
+}
+
+YOSYS_NAMESPACE_END